@@ -1,5 +1,9 @@
 #include<ncurses.h>
 #include<stdlib.h>
+#include<stdio.h>
+#include<fcntl.h>
+#include<sys/stat.h>
+#include<unistd.h>
 #include<fstream>
 #include<iostream>
 #include"winner.cpp"
@@ -114,6 +118,14 @@ void level(int &maxrow, int &maxcol, int MainMatrix[100][100],char filename[11])
 	//get row and column sizes
 	infile >> maxrow;
 	infile >> maxcol;
+	//MainMatrix is fixed at 100x100, bigger mazes are for v2
+	if(maxrow<=0 || maxcol<=0 || maxrow>100 || maxcol>100){
+		move(10,30);
+		attrset(COLOR_PAIR(1));
+		printw("Level Too Large...!");
+		getch();
+		exit(1);
+	}
 	//get values to array matrix
 	for(x=0;x<maxrow;x++){
 		for(y=0;y<maxcol;y++){
@@ -282,14 +294,23 @@ void gethighscore(char name[10], int &marks){
 }//gethighscore
 
 void savehighscore(char name[10], int marks){
-	ofstream outfile("score.dat");
-	if(!outfile){
+	//Write a new file, sync it and rename it over score.dat, so a crash leaves the old or the new score
+	char temp[]="score.dat.XXXXXX";
+	char line[64];
+	int length=snprintf(line,sizeof(line),"%s %d",player,marks);
+	int fd=mkstemp(temp);
+	if(fd<0 || fchmod(fd,0644)!=0 || write(fd,line,length)!=length || fsync(fd)!=0 || close(fd)!=0 ||
+	   rename(temp,"score.dat")!=0){
+		unlink(temp);
 		endwin();
 		cout << "Output Error.....!";
 		exit(1);
 	}
-	outfile<<player<<" ";
-	outfile<<marks;
+	int dir=open(".",O_RDONLY);
+	if(dir>=0){
+		fsync(dir);
+		close(dir);
+	}
 }//savehighscore
 
 void printmatrix(int maxrow, int maxcol,int MainMatrix[100][100]){
@@ -0,0 +1,191 @@
+#include "agents.hpp"
+
+namespace MulaWee {
+
+namespace {
+
+const Direction ALL_DIRECTIONS[4] = {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT};
+
+} // namespace
+
+// Direction helpers
+Position directionOffset(Direction dir) {
+    switch (dir) {
+        case Direction::UP:    return Position(-1, 0);
+        case Direction::DOWN:  return Position(1, 0);
+        case Direction::LEFT:  return Position(0, -1);
+        case Direction::RIGHT: return Position(0, 1);
+    }
+    return Position(0, 0);
+}
+
+Direction opposite(Direction dir) {
+    switch (dir) {
+        case Direction::UP:    return Direction::DOWN;
+        case Direction::DOWN:  return Direction::UP;
+        case Direction::LEFT:  return Direction::RIGHT;
+        case Direction::RIGHT: return Direction::LEFT;
+    }
+    return dir;
+}
+
+Direction turnRight(Direction dir) {
+    switch (dir) {
+        case Direction::UP:    return Direction::RIGHT;
+        case Direction::RIGHT: return Direction::DOWN;
+        case Direction::DOWN:  return Direction::LEFT;
+        case Direction::LEFT:  return Direction::UP;
+    }
+    return dir;
+}
+
+Direction turnLeft(Direction dir) {
+    return opposite(turnRight(dir));
+}
+
+// WallFollowerAgent implementation
+void WallFollowerAgent::reset(const Level&, const Position&) {
+    heading = Direction::UP;
+}
+
+Direction WallFollowerAgent::nextMove(const Level& level, const Position& position) {
+    const Direction order[4] = {turnRight(heading), heading, turnLeft(heading), opposite(heading)};
+    for (Direction dir : order) {
+        if (level.canMoveTo(position + directionOffset(dir))) {
+            heading = dir;
+            return dir;
+        }
+    }
+    return heading; // Walled in on all sides
+}
+
+// TremauxAgent implementation
+void TremauxAgent::reset(const Level& level, const Position&) {
+    cols = level.getCols();
+    marks.assign(static_cast<std::size_t>(level.getRows()) * cols, 0);
+    arrived = false;
+    lastMove = Direction::UP;
+}
+
+int TremauxAgent::getMark(const Position& pos, Direction dir) const {
+    std::size_t cell = static_cast<std::size_t>(pos.row) * cols + pos.col;
+    return (marks[cell] >> (static_cast<int>(dir) * 2)) & 3;
+}
+
+void TremauxAgent::addMark(const Position& pos, Direction dir) {
+    std::size_t cell = static_cast<std::size_t>(pos.row) * cols + pos.col;
+    int shift = static_cast<int>(dir) * 2;
+    int mark = (marks[cell] >> shift) & 3;
+    if (mark < 3) {
+        marks[cell] = static_cast<std::uint8_t>(marks[cell] + (1 << shift));
+    }
+}
+
+Direction TremauxAgent::nextMove(const Level& level, const Position& position) {
+    Direction entry = opposite(lastMove);
+    bool haveChoice = false;
+    Direction choice = Direction::UP;
+
+    if (arrived) {
+        // A fresh passage that leads into an already visited cell: turn back
+        bool visitedBefore = false;
+        for (Direction dir : ALL_DIRECTIONS) {
+            if (dir != entry && getMark(position, dir) > 0) {
+                visitedBefore = true;
+            }
+        }
+        if (visitedBefore && getMark(position, entry) == 1) {
+            choice = entry;
+            haveChoice = true;
+        }
+    }
+
+    // Otherwise prefer an unmarked passage, then the way back, then any passage marked once
+    for (int wanted = 0; wanted <= 1 && !haveChoice; ++wanted) {
+        if (wanted == 1 && arrived && getMark(position, entry) == 1) {
+            choice = entry;
+            haveChoice = true;
+            break;
+        }
+        for (Direction dir : ALL_DIRECTIONS) {
+            if (level.canMoveTo(position + directionOffset(dir)) && getMark(position, dir) == wanted) {
+                choice = dir;
+                haveChoice = true;
+                break;
+            }
+        }
+    }
+
+    if (!haveChoice) {
+        return entry; // Everything is marked twice: the goal is unreachable
+    }
+
+    addMark(position, choice);
+    addMark(position + directionOffset(choice), opposite(choice));
+    lastMove = choice;
+    arrived = true;
+    return choice;
+}
+
+// RandomWalkAgent implementation
+void RandomWalkAgent::reset(const Level&, const Position& start) {
+    // Same seed and start give the same walk regardless of scheduling
+    state = seed ^ (static_cast<std::uint64_t>(start.row) << 32 | static_cast<std::uint32_t>(start.col));
+    if (state == 0) {
+        state = 0x9E3779B97F4A7C15ull;
+    }
+}
+
+Direction RandomWalkAgent::nextMove(const Level& level, const Position& position) {
+    Direction open[4];
+    int count = 0;
+    for (Direction dir : ALL_DIRECTIONS) {
+        if (level.canMoveTo(position + directionOffset(dir))) {
+            open[count++] = dir;
+        }
+    }
+    if (count == 0) {
+        return Direction::UP;
+    }
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return open[state % count];
+}
+
+// OptimalAgent implementation
+void OptimalAgent::reset(const Level& level, const Position& start) {
+    path = solver.bfs(level, start, level.getGoalPosition()).path;
+    step = 0;
+}
+
+Direction OptimalAgent::nextMove(const Level&, const Position& position) {
+    while (step + 1 < path.size() && !(path[step] == position)) {
+        ++step;
+    }
+    if (step + 1 >= path.size()) {
+        return Direction::UP; // No path
+    }
+
+    const Position& next = path[++step];
+    if (next.row < position.row) return Direction::UP;
+    if (next.row > position.row) return Direction::DOWN;
+    if (next.col < position.col) return Direction::LEFT;
+    return Direction::RIGHT;
+}
+
+// Agent registry
+std::vector<std::string> agentNames() {
+    return {"wall-follower", "tremaux", "random-walk", "optimal"};
+}
+
+std::unique_ptr<Agent> createAgent(const std::string& name, std::uint64_t seed) {
+    if (name == "wall-follower") return std::make_unique<WallFollowerAgent>();
+    if (name == "tremaux") return std::make_unique<TremauxAgent>();
+    if (name == "random-walk") return std::make_unique<RandomWalkAgent>(seed);
+    if (name == "optimal") return std::make_unique<OptimalAgent>();
+    throw GameException("Unknown agent: " + name);
+}
+
+} // namespace MulaWee
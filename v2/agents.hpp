@@ -0,0 +1,100 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "maze_solver.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// Automated player. The tournament asks for one direction per step; agents may look
+// at the level around the player (walls are visible) but move like a person would.
+class Agent {
+public:
+    virtual ~Agent() = default;
+
+    virtual const char* getName() const = 0;
+
+    // Called once before each level
+    virtual void reset(const Level& level, const Position& start) = 0;
+
+    // Next direction to try from `position`
+    virtual Direction nextMove(const Level& level, const Position& position) = 0;
+};
+
+// Keeps its right hand on the wall; solves any level without loops around it
+class WallFollowerAgent : public Agent {
+private:
+    Direction heading;
+
+public:
+    WallFollowerAgent() : heading(Direction::UP) {}
+
+    const char* getName() const override { return "wall-follower"; }
+    void reset(const Level& level, const Position& start) override;
+    Direction nextMove(const Level& level, const Position& position) override;
+};
+
+// Tremaux's algorithm: marks each passage on entry and exit, never takes a passage
+// marked twice, so every level with a reachable goal is solved
+class TremauxAgent : public Agent {
+private:
+    std::vector<std::uint8_t> marks; // 2 bits per direction per cell
+    int cols;
+    bool arrived;                    // False until the first move has been made
+    Direction lastMove;
+
+public:
+    TremauxAgent() : cols(0), arrived(false), lastMove(Direction::UP) {}
+
+    const char* getName() const override { return "tremaux"; }
+    void reset(const Level& level, const Position& start) override;
+    Direction nextMove(const Level& level, const Position& position) override;
+
+private:
+    int getMark(const Position& pos, Direction dir) const;
+    void addMark(const Position& pos, Direction dir);
+};
+
+// Uniformly random open direction (seeded, so runs are reproducible)
+class RandomWalkAgent : public Agent {
+private:
+    std::uint64_t seed;
+    std::uint64_t state;
+
+public:
+    explicit RandomWalkAgent(std::uint64_t rngSeed) : seed(rngSeed), state(rngSeed) {}
+
+    const char* getName() const override { return "random-walk"; }
+    void reset(const Level& level, const Position& start) override;
+    Direction nextMove(const Level& level, const Position& position) override;
+};
+
+// Follows a precomputed shortest path (BFS)
+class OptimalAgent : public Agent {
+private:
+    MazeSolver solver;
+    std::vector<Position> path;
+    std::size_t step;
+
+public:
+    OptimalAgent() : step(0) {}
+
+    const char* getName() const override { return "optimal"; }
+    void reset(const Level& level, const Position& start) override;
+    Direction nextMove(const Level& level, const Position& position) override;
+};
+
+// Agent registry
+std::vector<std::string> agentNames();
+std::unique_ptr<Agent> createAgent(const std::string& name, std::uint64_t seed);
+
+// Direction helpers shared by agents
+Position directionOffset(Direction dir);
+Direction opposite(Direction dir);
+Direction turnRight(Direction dir);
+Direction turnLeft(Direction dir);
+
+} // namespace MulaWee
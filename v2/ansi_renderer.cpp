@@ -0,0 +1,116 @@
+#include "ansi_renderer.hpp"
+
+namespace MulaWee {
+
+namespace {
+
+// SGR parameters matching the ncurses color pairs
+const char* colorCode(ColorPair color) {
+    switch (color) {
+        case ColorPair::RED: return "0;31";
+        case ColorPair::GREEN: return "0;32";
+        case ColorPair::BLUE: return "0;34";
+        case ColorPair::YELLOW: return "0;33";
+        case ColorPair::GOAL: return "0;30;43";
+        case ColorPair::DEFAULT:
+        default: return "0;37";
+    }
+}
+
+} // namespace
+
+// AnsiRenderer class implementation
+AnsiRenderer::AnsiRenderer(int screenRows, int screenCols)
+    : rows(screenRows), cols(screenCols), cursorRow(-1), cursorCol(-1),
+      color(ColorPair::DEFAULT), colorKnown(false) {}
+
+void AnsiRenderer::reset() {
+    output += "\x1b[0m\x1b[2J\x1b[?25l";
+    cursorRow = cursorCol = -1;
+    colorKnown = false;
+}
+
+void AnsiRenderer::forgetCursor() {
+    cursorRow = cursorCol = -1;
+    colorKnown = false;
+}
+
+void AnsiRenderer::clear() {
+    output += "\x1b[0m\x1b[2J";
+    cursorRow = cursorCol = -1;
+    colorKnown = false;
+}
+
+void AnsiRenderer::drawChar(int row, int col, ColorPair cellColor, char ch) {
+    moveTo(row, col);
+    setColor(cellColor);
+    output += ch;
+    advance(1);
+}
+
+void AnsiRenderer::drawText(int row, int col, ColorPair textColor, const std::string& text) {
+    moveTo(row, col);
+    setColor(textColor);
+    output += text;
+    advance(static_cast<int>(text.size()));
+}
+
+void AnsiRenderer::drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) {
+    moveTo(row, col);
+    for (int i = 0; i < count; ++i) {
+        setColor(glyphs[i].color);
+        output += glyphs[i].ch;
+    }
+    advance(count);
+}
+
+bool AnsiRenderer::getScreenSize(int& screenRows, int& screenCols) const {
+    screenRows = rows;
+    screenCols = cols;
+    return true;
+}
+
+void AnsiRenderer::moveTo(int row, int col) {
+    if (row == cursorRow && col == cursorCol) {
+        return; // Continuing the previous span
+    }
+    output += "\x1b[";
+    appendNumber(row + 1);
+    output += ';';
+    appendNumber(col + 1);
+    output += 'H';
+    cursorRow = row;
+    cursorCol = col;
+}
+
+void AnsiRenderer::advance(int count) {
+    cursorCol += count;
+    if (cursorCol >= cols) {
+        cursorRow = cursorCol = -1; // Terminals differ at the right margin
+    }
+}
+
+void AnsiRenderer::setColor(ColorPair next) {
+    if (colorKnown && next == color) {
+        return;
+    }
+    output += "\x1b[";
+    output += colorCode(next);
+    output += 'm';
+    color = next;
+    colorKnown = true;
+}
+
+void AnsiRenderer::appendNumber(int value) {
+    char digits[12];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (length > 0) {
+        output += digits[--length];
+    }
+}
+
+} // namespace MulaWee
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "renderer.hpp"
+#include <string>
+
+namespace MulaWee {
+
+// Renderer that encodes drawing as ANSI (VT100) escape sequences into a byte buffer,
+// for a terminal on the other end of a socket. Nothing is kept per cell, so it is
+// meant to sit behind a DiffRenderer, which only forwards what changed. Cursor moves
+// and color changes are skipped when the terminal is already there.
+class AnsiRenderer : public Renderer {
+private:
+    std::string output;
+    int rows, cols;
+    int cursorRow, cursorCol; // Where the terminal cursor is (-1 = unknown)
+    ColorPair color;
+    bool colorKnown;
+
+public:
+    AnsiRenderer(int screenRows, int screenCols);
+
+    void clear() override;
+    void drawChar(int row, int col, ColorPair color, char ch) override;
+    void drawText(int row, int col, ColorPair color, const std::string& text) override;
+    void drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) override;
+    void beep() override { output += '\a'; }
+    void refresh() override {}
+    bool getScreenSize(int& screenRows, int& screenCols) const override;
+
+    // Bytes encoded and not yet taken; the owner sends and erases them
+    std::string& getOutput() { return output; }
+
+    // Clear the terminal and hide its cursor, forgetting what it showed
+    void reset();
+
+    // Move the cursor and set the color explicitly on the next drawing, so the output
+    // from here on is also right on a terminal that did not see what came before
+    void forgetCursor();
+
+private:
+    void moveTo(int row, int col);
+    void advance(int count);
+    void setColor(ColorPair next);
+    void appendNumber(int value);
+};
+
+} // namespace MulaWee
@@ -0,0 +1,36 @@
+#include "camera.hpp"
+#include <algorithm>
+
+namespace MulaWee {
+
+// Camera class implementation
+void Camera::reset(int levelRowCount, int levelColCount, int viewRowCount, int viewColCount) {
+    levelRows = levelRowCount;
+    levelCols = levelColCount;
+    viewRows = std::max(1, std::min(viewRowCount, levelRows));
+    viewCols = std::max(1, std::min(viewColCount, levelCols));
+    top = 0;
+    left = 0;
+}
+
+bool Camera::follow(const Position& pos) {
+    int newTop = followAxis(pos.row, top, viewRows, levelRows);
+    int newLeft = followAxis(pos.col, left, viewCols, levelCols);
+    bool moved = newTop != top || newLeft != left;
+    top = newTop;
+    left = newLeft;
+    return moved;
+}
+
+int Camera::followAxis(int pos, int origin, int view, int extent) {
+    if (view >= extent) {
+        return 0;
+    }
+    int margin = std::max(1, view / 4);
+    if (pos >= origin + margin && pos < origin + view - margin) {
+        return origin;
+    }
+    return std::max(0, std::min(pos - view / 2, extent - view));
+}
+
+} // namespace MulaWee
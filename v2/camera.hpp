@@ -0,0 +1,40 @@
+#pragma once
+
+#include "game_core.hpp"
+
+namespace MulaWee {
+
+// The part of a level that is on screen, in grid coordinates. The window only moves
+// when the player comes within a margin of its edge, and then re-centres on them, so
+// most moves scroll nothing and a scroll happens at most every few steps. Levels that
+// fit on screen never scroll.
+class Camera {
+private:
+    int levelRows, levelCols;
+    int viewRows, viewCols;
+    int top, left;
+
+public:
+    Camera() : levelRows(0), levelCols(0), viewRows(0), viewCols(0), top(0), left(0) {}
+
+    // View sizes are clamped to the level (and to at least one cell)
+    void reset(int levelRowCount, int levelColCount, int viewRowCount, int viewColCount);
+
+    // Keep `pos` inside the window; true if the window moved
+    bool follow(const Position& pos);
+
+    int getTop() const { return top; }
+    int getLeft() const { return left; }
+    int getRows() const { return viewRows; }
+    int getCols() const { return viewCols; }
+
+    bool contains(const Position& pos) const {
+        return pos.row >= top && pos.row < top + viewRows &&
+               pos.col >= left && pos.col < left + viewCols;
+    }
+
+private:
+    static int followAxis(int pos, int origin, int view, int extent);
+};
+
+} // namespace MulaWee
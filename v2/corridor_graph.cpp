@@ -0,0 +1,348 @@
+#include "corridor_graph.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+// CorridorGraph class implementation
+
+namespace MulaWee {
+
+constexpr std::uint32_t CorridorGraph::NONE;
+
+CorridorGraph::CorridorGraph(const Level& level)
+    : rows(level.getRows()), cols(level.getCols()), startCell(NONE), goalCell(NONE), generation(0) {
+    const std::size_t cells = static_cast<std::size_t>(rows) * cols;
+    if (cells >= NONE) {
+        throw GameException("Level too large for CorridorGraph: " + level.getFilename());
+    }
+    const Position& start = level.getStartPosition();
+    const Position& goal = level.getGoalPosition();
+    if (level.canMoveTo(start)) {
+        startCell = static_cast<std::uint32_t>(start.row) * cols + start.col;
+    }
+    if (level.canMoveTo(goal)) {
+        goalCell = static_cast<std::uint32_t>(goal.row) * cols + goal.col;
+    }
+
+    nodeBits.assign(cells / 64 + 1, 0);
+    nodeRank.assign(nodeBits.size(), 0);
+    for (std::uint32_t cell = 0; cell < cells; ++cell) {
+        if ((cell & 63) == 0) {
+            nodeRank[cell >> 6] = static_cast<std::uint32_t>(nodeCell.size());
+        }
+        if (isOpen(level, cell) && isNode(level, cell)) {
+            nodeBits[cell >> 6] |= std::uint64_t(1) << (cell & 63);
+            nodeCell.push_back(cell);
+        }
+    }
+    nodeCell.shrink_to_fit();
+
+    // Each corridor is walked once from either end, so every edge is stored both ways
+    edgeStart.reserve(nodeCell.size() + 1);
+    edgeStart.push_back(0);
+    for (std::uint32_t cell : nodeCell) {
+        std::uint32_t next[4];
+        neighbours(level, cell, next);
+        for (int dir = 0; dir < 4; ++dir) {
+            if (next[dir] == NONE) {
+                continue;
+            }
+            Corridor corridor = follow(level, cell, dir, NONE);
+            if (corridor.end == cell) {
+                continue; // A loop back to the same node never shortens a route
+            }
+            edgeTarget.push_back(nodeAt(corridor.end));
+            edgeLength.push_back(corridor.length);
+            edgeDir.push_back(static_cast<std::uint8_t>(dir));
+        }
+        edgeStart.push_back(static_cast<std::uint32_t>(edgeTarget.size()));
+    }
+
+    stamp.assign(nodeCell.size(), 0);
+    bestG.resize(nodeCell.size());
+    parentNode.resize(nodeCell.size());
+    parentEdge.resize(nodeCell.size());
+    startLink.resize(nodeCell.size());
+}
+
+int CorridorGraph::neighbours(const Level& level, std::uint32_t cell, std::uint32_t next[4]) const {
+    const int r = static_cast<int>(cell / cols);
+    const int c = static_cast<int>(cell - static_cast<std::uint32_t>(r) * cols);
+    next[0] = r > 0 ? cell - cols : NONE;
+    next[1] = r + 1 < rows ? cell + cols : NONE;
+    next[2] = c > 0 ? cell - 1 : NONE;
+    next[3] = c + 1 < cols ? cell + 1 : NONE;
+    int open = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (next[dir] != NONE && !isOpen(level, next[dir])) {
+            next[dir] = NONE;
+        }
+        open += next[dir] != NONE;
+    }
+    return open;
+}
+
+bool CorridorGraph::isNode(const Level& level, std::uint32_t cell) const {
+    std::uint32_t next[4];
+    return cell == startCell || cell == goalCell || neighbours(level, cell, next) != 2;
+}
+
+std::uint32_t CorridorGraph::nodeAt(std::uint32_t cell) const {
+    std::uint64_t word = nodeBits[cell >> 6];
+    std::uint64_t bit = std::uint64_t(1) << (cell & 63);
+    if (!(word & bit)) {
+        return NONE;
+    }
+    return nodeRank[cell >> 6] + static_cast<std::uint32_t>(__builtin_popcountll(word & (bit - 1)));
+}
+
+CorridorGraph::Corridor CorridorGraph::follow(const Level& level, std::uint32_t from, int dir,
+                                              std::uint32_t watch) const {
+    Corridor corridor{0, 1, NONE, static_cast<std::uint8_t>(dir)};
+    std::uint32_t next[4];
+    neighbours(level, from, next);
+    std::uint32_t previous = from;
+    std::uint32_t cell = next[dir];
+
+    // Corridor cells have two open neighbours: go on through the one not come from
+    while (true) {
+        if (cell == watch && corridor.seenAt == NONE) {
+            corridor.seenAt = corridor.length;
+        }
+        if (cell == from || cell == startCell || cell == goalCell || neighbours(level, cell, next) != 2) {
+            break;
+        }
+        int onward = next[0] != NONE && next[0] != previous ? 0
+                   : next[1] != NONE && next[1] != previous ? 1
+                   : next[2] != NONE && next[2] != previous ? 2 : 3;
+        previous = cell;
+        cell = next[onward];
+        corridor.lastDir = static_cast<std::uint8_t>(onward);
+        ++corridor.length;
+    }
+    corridor.end = cell;
+    return corridor;
+}
+
+void CorridorGraph::walk(const Level& level, std::uint32_t from, int dir, std::uint32_t steps,
+                         std::vector<Position>& out) const {
+    std::uint32_t next[4];
+    std::uint32_t previous = from;
+    std::uint32_t cell = from;
+    for (std::uint32_t i = 0; i < steps; ++i) {
+        neighbours(level, cell, next);
+        if (i > 0) {
+            for (dir = 0; next[dir] == NONE || next[dir] == previous; ++dir) {
+            }
+        }
+        previous = cell;
+        cell = next[dir];
+        out.push_back(toPosition(cell));
+    }
+}
+
+void CorridorGraph::checkLevel(const Level& level) const {
+    if (level.getRows() != rows || level.getCols() != cols) {
+        throw GameException("CorridorGraph was built for another level than " + level.getFilename());
+    }
+}
+
+std::uint32_t CorridorGraph::link(const Level& level, std::uint32_t start, std::uint32_t goal,
+                                  std::uint8_t& directDir) {
+    sources.clear();
+    targets.clear();
+    std::uint32_t direct = NONE;
+
+    std::uint32_t node = nodeAt(start);
+    if (node != NONE) {
+        sources.push_back(Link{node, 0, 0});
+    } else {
+        std::uint32_t next[4];
+        neighbours(level, start, next);
+        for (int dir = 0; dir < 4; ++dir) {
+            if (next[dir] == NONE) {
+                continue;
+            }
+            Corridor corridor = follow(level, start, dir, goal);
+            if (corridor.seenAt < direct) {
+                direct = corridor.seenAt;
+                directDir = static_cast<std::uint8_t>(dir);
+            }
+            if (corridor.end != start) {
+                sources.push_back(Link{nodeAt(corridor.end), corridor.length, static_cast<std::uint8_t>(dir)});
+            }
+        }
+    }
+
+    node = nodeAt(goal);
+    if (node != NONE) {
+        targets.push_back(Link{node, 0, 0});
+    } else {
+        std::uint32_t next[4];
+        neighbours(level, goal, next);
+        for (int dir = 0; dir < 4; ++dir) {
+            if (next[dir] == NONE) {
+                continue;
+            }
+            Corridor corridor = follow(level, goal, dir, NONE);
+            if (corridor.end != goal) {
+                // Directions pair up as UP/DOWN and LEFT/RIGHT, so ^ 1 turns one round
+                targets.push_back(Link{nodeAt(corridor.end), corridor.length,
+                                       static_cast<std::uint8_t>(corridor.lastDir ^ 1)});
+            }
+        }
+    }
+    return direct;
+}
+
+void CorridorGraph::relax(std::uint32_t node, std::uint32_t g, std::uint32_t fromNode, std::uint32_t edge,
+                          std::uint8_t source, const Position& goal) {
+    if (stamp[node] == generation && bestG[node] <= g) {
+        return;
+    }
+    stamp[node] = generation;
+    bestG[node] = g;
+    parentNode[node] = fromNode;
+    parentEdge[node] = edge;
+    startLink[node] = source;
+
+    // A corridor is never shorter than the Manhattan distance along it, so the
+    // heuristic stays consistent on the weighted graph
+    std::uint32_t cell = nodeCell[node];
+    std::uint32_t h = static_cast<std::uint32_t>(std::abs(static_cast<int>(cell / cols) - goal.row) +
+                                                 std::abs(static_cast<int>(cell % cols) - goal.col));
+    heap.push_back(HeapNode{g + h, g, node});
+    std::push_heap(heap.begin(), heap.end(), HeapOrder());
+}
+
+bool CorridorGraph::isTarget(std::uint32_t node) const {
+    for (const Link& target : targets) {
+        if (target.node == node) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint32_t CorridorGraph::search(const Position& goal, std::uint32_t direct, std::size_t& expanded,
+                                    std::size_t& via) {
+    if (generation == std::numeric_limits<std::uint32_t>::max()) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 0;
+    }
+    ++generation;
+
+    std::uint32_t best = direct;
+    via = NONE;
+    heap.clear();
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        relax(sources[i].node, sources[i].length, NONE, NONE, static_cast<std::uint8_t>(i), goal);
+    }
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), HeapOrder());
+        HeapNode top = heap.back();
+        heap.pop_back();
+        if (top.g != bestG[top.node]) {
+            continue; // Superseded by a shorter route
+        }
+        if (top.f >= best) {
+            break;
+        }
+        ++expanded;
+
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            if (targets[i].node == top.node && top.g + targets[i].length < best) {
+                best = top.g + targets[i].length;
+                via = i;
+            }
+        }
+        for (std::uint32_t edge = edgeStart[top.node]; edge < edgeStart[top.node + 1]; ++edge) {
+            // A dead end leads nowhere unless the route ends there
+            std::uint32_t next = edgeTarget[edge];
+            if (edgeStart[next + 1] - edgeStart[next] > 1 || isTarget(next)) {
+                relax(next, top.g + edgeLength[edge], top.node, edge, 0, goal);
+            }
+        }
+    }
+    return best;
+}
+
+SolveResult CorridorGraph::solve(const Level& level) {
+    return solve(level, level.getStartPosition(), level.getGoalPosition());
+}
+
+SolveResult CorridorGraph::solve(const Level& level, const Position& start, const Position& goal) {
+    checkLevel(level);
+    SolveResult result;
+    if (!level.canMoveTo(start) || !level.canMoveTo(goal)) {
+        return result;
+    }
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * cols + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * cols + goal.col;
+    result.path.push_back(start);
+    if (source == target) {
+        result.found = true;
+        return result;
+    }
+
+    std::uint8_t directDir = 0;
+    std::size_t via = NONE;
+    std::uint32_t direct = link(level, source, target, directDir);
+    std::uint32_t length = search(goal, direct, result.expanded, via);
+    if (length == NONE) {
+        result.path.clear();
+        return result;
+    }
+
+    if (via == NONE) {
+        walk(level, source, directDir, direct, result.path);
+    } else {
+        // Nodes back from the last one, then the cells start to goal
+        std::vector<std::uint32_t> nodes;
+        for (std::uint32_t node = targets[via].node; node != NONE; node = parentNode[node]) {
+            nodes.push_back(node);
+        }
+        const Link& first = sources[startLink[nodes.back()]];
+        walk(level, source, first.dir, first.length, result.path);
+        for (std::size_t i = nodes.size() - 1; i > 0; --i) {
+            std::uint32_t edge = parentEdge[nodes[i - 1]];
+            walk(level, nodeCell[nodes[i]], edgeDir[edge], edgeLength[edge], result.path);
+        }
+        walk(level, nodeCell[targets[via].node], targets[via].dir, targets[via].length, result.path);
+    }
+    result.found = true;
+    return result;
+}
+
+int CorridorGraph::distance(const Level& level) {
+    return distance(level, level.getStartPosition(), level.getGoalPosition());
+}
+
+int CorridorGraph::distance(const Level& level, const Position& start, const Position& goal) {
+    checkLevel(level);
+    if (!level.canMoveTo(start) || !level.canMoveTo(goal)) {
+        return -1;
+    }
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * cols + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * cols + goal.col;
+    if (source == target) {
+        return 0;
+    }
+    std::uint8_t directDir = 0;
+    std::size_t expanded = 0;
+    std::size_t via = NONE;
+    std::uint32_t length = search(goal, link(level, source, target, directDir), expanded, via);
+    return length == NONE ? -1 : static_cast<int>(length);
+}
+
+std::size_t CorridorGraph::memoryUsage() const {
+    return nodeBits.capacity() * sizeof(std::uint64_t) +
+           (nodeCell.capacity() + nodeRank.capacity() + edgeStart.capacity() + edgeTarget.capacity() +
+            edgeLength.capacity() + stamp.capacity() + bestG.capacity() + parentNode.capacity() +
+            parentEdge.capacity()) * sizeof(std::uint32_t) +
+           edgeDir.capacity() + startLink.capacity() + heap.capacity() * sizeof(HeapNode) +
+           (sources.capacity() + targets.capacity()) * sizeof(Link);
+}
+
+} // namespace MulaWee
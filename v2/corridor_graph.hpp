@@ -0,0 +1,117 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "maze_solver.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MulaWee {
+
+// A level contracted to the cells where a route can change: junctions, dead ends,
+// open areas, and the start and goal. Every other open cell has exactly two open
+// neighbours, so the corridor through it is a single weighted edge between the
+// nodes at its ends. The graph is stored as CSR (compressed sparse row): the
+// edges of node n are edgeTarget[edgeStart[n] .. edgeStart[n + 1]), with their
+// lengths in moves and the direction of their first step.
+//
+// Queries take the level the graph was built from, as MazeSolver does. A start or
+// goal in the middle of a corridor is joined to the nodes at both of its ends for
+// that query. Search buffers are reused between queries, so one graph serves one
+// thread at a time.
+class CorridorGraph {
+private:
+    struct HeapNode {
+        std::uint32_t f;
+        std::uint32_t g;
+        std::uint32_t node;
+    };
+
+    struct HeapOrder {
+        bool operator()(const HeapNode& a, const HeapNode& b) const {
+            return a.f != b.f ? a.f > b.f : a.g < b.g;
+        }
+    };
+
+    // Where a walk along a corridor ended
+    struct Corridor {
+        std::uint32_t end;      // First node cell reached, or the cell the walk began at
+        std::uint32_t length;   // Moves to `end`
+        std::uint32_t seenAt;   // Moves to the `watch` cell if passed, else NONE
+        std::uint8_t lastDir;   // Direction of the final step
+    };
+
+    // A corridor from the query's start or goal to a node
+    struct Link {
+        std::uint32_t node;
+        std::uint32_t length;
+        std::uint8_t dir;       // First step away from the start, or from the node towards the goal
+    };
+
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    int rows;
+    int cols;
+    std::uint32_t startCell;                // Always nodes, or NONE if not open
+    std::uint32_t goalCell;
+    std::vector<std::uint32_t> nodeCell;    // Row-major cell of each node, ascending
+    std::vector<std::uint64_t> nodeBits;    // Node cells, 64 to a word
+    std::vector<std::uint32_t> nodeRank;    // Nodes before each word, so a cell's node is found in O(1)
+    std::vector<std::uint32_t> edgeStart;   // Per node, plus one past the end
+    std::vector<std::uint32_t> edgeTarget;
+    std::vector<std::uint32_t> edgeLength;
+    std::vector<std::uint8_t> edgeDir;
+
+    // Search state, by node
+    std::vector<std::uint32_t> stamp;
+    std::vector<std::uint32_t> bestG;
+    std::vector<std::uint32_t> parentNode;
+    std::vector<std::uint32_t> parentEdge;  // Edge used to reach the node, or NONE from the start
+    std::vector<std::uint8_t> startLink;    // Index into sources when parentEdge is NONE
+    std::vector<HeapNode> heap;
+    std::vector<Link> sources;
+    std::vector<Link> targets;
+    std::uint32_t generation;
+
+public:
+    // Throws GameException if the level has more cells than fit in 32 bits
+    explicit CorridorGraph(const Level& level);
+
+    std::size_t getNodeCount() const { return nodeCell.size(); }
+    std::size_t getEdgeCount() const { return edgeTarget.size(); } // Each corridor counts twice
+
+    // Shortest route; `expanded` counts graph nodes, not cells
+    SolveResult solve(const Level& level);
+    SolveResult solve(const Level& level, const Position& start, const Position& goal);
+
+    // Moves on the shortest route (the level's par), or -1 if there is none
+    int distance(const Level& level);
+    int distance(const Level& level, const Position& start, const Position& goal);
+
+    // Bytes held by the graph and the search buffers
+    std::size_t memoryUsage() const;
+
+private:
+    static bool isOpen(const Level& level, std::uint32_t cell) { return level.cellAt(cell) != CellType::WALL; }
+    // Open neighbours of `cell` by Direction, NONE for walls and the level's edge
+    int neighbours(const Level& level, std::uint32_t cell, std::uint32_t next[4]) const;
+    bool isNode(const Level& level, std::uint32_t cell) const;
+    std::uint32_t nodeAt(std::uint32_t cell) const;
+    bool isTarget(std::uint32_t node) const;
+    void relax(std::uint32_t node, std::uint32_t g, std::uint32_t fromNode, std::uint32_t edge,
+               std::uint8_t source, const Position& goal);
+    Corridor follow(const Level& level, std::uint32_t from, int dir, std::uint32_t watch) const;
+    void walk(const Level& level, std::uint32_t from, int dir, std::uint32_t steps, std::vector<Position>& out) const;
+    Position toPosition(std::uint32_t cell) const {
+        return Position(static_cast<int>(cell / cols), static_cast<int>(cell % cols));
+    }
+
+    // Fills sources and targets; returns the length of a route along a single corridor
+    // (or NONE), with the direction of its first step in `directDir`
+    std::uint32_t link(const Level& level, std::uint32_t start, std::uint32_t goal, std::uint8_t& directDir);
+    // A* from the sources; returns the route length or NONE, and the target it ended through
+    std::uint32_t search(const Position& goal, std::uint32_t direct, std::size_t& expanded, std::size_t& via);
+    void checkLevel(const Level& level) const;
+};
+
+} // namespace MulaWee
@@ -0,0 +1,231 @@
+#include "distance_field.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+// DistanceField class implementation
+
+namespace MulaWee {
+
+constexpr std::uint32_t DistanceField::UNREACHABLE;
+constexpr std::size_t DistanceField::DEFAULT_REPAIR_BUDGET;
+
+DistanceField::DistanceField(const Level& level, std::size_t repairEntries)
+    : rows(level.getRows()), cols(level.getCols()), goalCell(UNREACHABLE), km(0), lastCell(0),
+      repairBudget(repairEntries), repairedCells(0), repairing(false) {
+    const std::size_t cells = static_cast<std::size_t>(rows) * cols;
+    if (cells >= UNREACHABLE) {
+        throw GameException("Level too large for DistanceField: " + level.getFilename());
+    }
+    open.assign(cells / 64 + 1, 0);
+    for (std::size_t cell = 0; cell < cells; ++cell) {
+        if (level.cellAt(cell) != CellType::WALL) {
+            open[cell >> 6] |= std::uint64_t(1) << (cell & 63);
+        }
+    }
+    if (level.canMoveTo(level.getGoalPosition())) {
+        goalCell = toCell(level.getGoalPosition());
+    }
+    fill();
+}
+
+void DistanceField::neighbours(std::uint32_t cell, std::uint32_t next[4]) const {
+    const int r = static_cast<int>(cell / cols);
+    const int c = static_cast<int>(cell - static_cast<std::uint32_t>(r) * cols);
+    next[0] = r > 0 ? cell - cols : UNREACHABLE;
+    next[1] = r + 1 < rows ? cell + cols : UNREACHABLE;
+    next[2] = c > 0 ? cell - 1 : UNREACHABLE;
+    next[3] = c + 1 < cols ? cell + 1 : UNREACHABLE;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (next[dir] != UNREACHABLE && !isOpen(next[dir])) {
+            next[dir] = UNREACHABLE;
+        }
+    }
+}
+
+std::uint32_t DistanceField::manhattan(std::uint32_t a, std::uint32_t b) const {
+    const int rowA = static_cast<int>(a / cols), rowB = static_cast<int>(b / cols);
+    const int colA = static_cast<int>(a % cols), colB = static_cast<int>(b % cols);
+    return static_cast<std::uint32_t>(std::abs(rowA - rowB) + std::abs(colA - colB));
+}
+
+// Plain BFS outwards from the goal
+void DistanceField::fill() {
+    g.assign(static_cast<std::size_t>(rows) * cols, UNREACHABLE);
+    if (goalCell == UNREACHABLE) {
+        return;
+    }
+    std::vector<std::uint32_t> queue;
+    queue.push_back(goalCell);
+    g[goalCell] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const std::uint32_t cell = queue[head];
+        std::uint32_t next[4];
+        neighbours(cell, next);
+        for (std::uint32_t n : next) {
+            if (n != UNREACHABLE && g[n] == UNREACHABLE) {
+                g[n] = g[cell] + 1;
+                queue.push_back(n);
+            }
+        }
+    }
+}
+
+DistanceField::HeapNode DistanceField::keyOf(std::uint32_t cell) const {
+    const std::uint32_t best = std::min(g[cell], rhs[cell]);
+    return HeapNode{static_cast<std::uint64_t>(best) + manhattan(lastCell, cell) + km, best, cell};
+}
+
+// The queued keys used the Manhattan distance from lastCell. Moving it lowers any of
+// them by at most the distance moved, so adding that to km keeps them lower bounds.
+void DistanceField::moveStart(std::uint32_t cell) {
+    if (heap.empty()) {
+        km = 0;
+    } else if (cell != lastCell) {
+        km += manhattan(lastCell, cell);
+    }
+    lastCell = cell;
+}
+
+void DistanceField::updateCell(std::uint32_t cell) {
+    if (cell != goalCell) {
+        std::uint32_t best = UNREACHABLE;
+        if (isOpen(cell)) {
+            std::uint32_t next[4];
+            neighbours(cell, next);
+            for (std::uint32_t n : next) {
+                if (n != UNREACHABLE && g[n] != UNREACHABLE) {
+                    best = std::min(best, g[n] + 1);
+                }
+            }
+        }
+        rhs[cell] = best;
+    }
+    if (g[cell] != rhs[cell]) {
+        heap.push_back(keyOf(cell));
+        std::push_heap(heap.begin(), heap.end(), HeapOrder());
+    }
+}
+
+// D* Lite's ComputeShortestPath, towards `start`
+bool DistanceField::repair(std::uint32_t start, std::size_t budget) {
+    moveStart(start);
+    const HeapOrder later;
+    for (std::size_t popped = 0; !heap.empty(); ++popped) {
+        const HeapNode top = heap.front();
+        if (g[start] == rhs[start] && !later(keyOf(start), top)) {
+            break; // Nothing queued can still change the start's distance
+        }
+        if (popped == budget) {
+            return false;
+        }
+        std::pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+
+        const std::uint32_t cell = top.cell;
+        if (g[cell] == rhs[cell]) {
+            continue; // Settled through a newer entry
+        }
+        const HeapNode now = keyOf(cell);
+        if (later(now, top)) {
+            heap.push_back(now); // Key went up since it was queued
+            std::push_heap(heap.begin(), heap.end(), later);
+            continue;
+        }
+
+        ++repairedCells;
+        if (g[cell] > rhs[cell]) {
+            g[cell] = rhs[cell]; // Got closer: settle it
+        } else {
+            g[cell] = UNREACHABLE; // Got further: forget it and let the neighbours say
+            updateCell(cell);
+        }
+        std::uint32_t next[4];
+        neighbours(cell, next);
+        for (std::uint32_t n : next) {
+            if (n != UNREACHABLE) {
+                updateCell(n);
+            }
+        }
+    }
+    return true;
+}
+
+std::uint32_t DistanceField::distance(const Position& pos) {
+    if (pos.row < 0 || pos.row >= rows || pos.col < 0 || pos.col >= cols) {
+        return UNREACHABLE;
+    }
+    const std::uint32_t cell = toCell(pos);
+    if (!isOpen(cell)) {
+        return UNREACHABLE;
+    }
+    if (!heap.empty()) {
+        repair(cell, static_cast<std::size_t>(-1));
+    }
+    return g[cell];
+}
+
+bool DistanceField::bestMove(const Position& pos, Direction& dir) {
+    repairing = false;
+    if (isWall(pos)) {
+        return false;
+    }
+    const std::uint32_t cell = toCell(pos);
+    if (!heap.empty() && !repair(cell, repairBudget)) {
+        repairing = true;
+        return false;
+    }
+    if (g[cell] == UNREACHABLE || g[cell] == 0) {
+        return false;
+    }
+    std::uint32_t next[4];
+    neighbours(cell, next);
+    std::uint32_t best = UNREACHABLE;
+    for (int d = 0; d < 4; ++d) {
+        if (next[d] != UNREACHABLE && g[next[d]] < best) {
+            best = g[next[d]];
+            dir = static_cast<Direction>(d);
+        }
+    }
+    return best != UNREACHABLE;
+}
+
+bool DistanceField::isWall(const Position& pos) const {
+    return pos.row < 0 || pos.row >= rows || pos.col < 0 || pos.col >= cols || !isOpen(toCell(pos));
+}
+
+void DistanceField::setWall(const Position& pos, bool wall, const Position& player) {
+    if (pos.row < 0 || pos.row >= rows || pos.col < 0 || pos.col >= cols) {
+        throw GameException("Cell outside the level: (" + std::to_string(pos.row) + ", " +
+                            std::to_string(pos.col) + ")");
+    }
+    const std::uint32_t cell = toCell(pos);
+    if (wall && cell == goalCell) {
+        throw GameException("The goal cannot be walled in");
+    }
+    if (wall == !isOpen(cell)) {
+        return;
+    }
+    if (rhs.empty()) {
+        rhs = g; // Every cell is consistent until now
+    }
+    open[cell >> 6] ^= std::uint64_t(1) << (cell & 63);
+
+    const bool playerInside = player.row >= 0 && player.row < rows && player.col >= 0 && player.col < cols;
+    moveStart(playerInside ? toCell(player) : lastCell);
+    updateCell(cell);
+    std::uint32_t next[4];
+    neighbours(cell, next);
+    for (std::uint32_t n : next) {
+        if (n != UNREACHABLE) {
+            updateCell(n);
+        }
+    }
+}
+
+std::size_t DistanceField::memoryUsage() const {
+    return open.capacity() * sizeof(std::uint64_t) + (g.capacity() + rhs.capacity()) * sizeof(std::uint32_t) +
+           heap.capacity() * sizeof(HeapNode);
+}
+
+} // namespace MulaWee
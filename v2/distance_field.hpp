@@ -0,0 +1,95 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MulaWee {
+
+// Moves from every cell to the level's goal, for the in-game hint. The field is filled
+// by one BFS from the goal when it is built, so the best move from any cell is the
+// open neighbour closest to the goal: four reads, however big the level.
+//
+// The field keeps its own copy of the walls. setWall() changes one and repairs the
+// distances the way D* Lite does rather than filling the field again: g is each cell's
+// distance, rhs the one its neighbours imply, and cells where they disagree wait in a
+// priority queue. The queue is only worked through far enough to make the asked-about
+// cell right, ordered by distance plus the Manhattan distance from that cell, so a
+// change far from the player costs little until the player nears it. A hint stops
+// after a fixed number of queue entries and the next one carries on, because a wall
+// that cuts a long corridor can move millions of distances. rhs is only allocated
+// once a wall changes.
+class DistanceField {
+private:
+    // D* Lite key: lower first, then by the distance itself
+    struct HeapNode {
+        std::uint64_t k1;
+        std::uint32_t k2;
+        std::uint32_t cell;
+    };
+
+    struct HeapOrder {
+        bool operator()(const HeapNode& a, const HeapNode& b) const {
+            return a.k1 != b.k1 ? a.k1 > b.k1 : a.k2 > b.k2;
+        }
+    };
+
+    int rows;
+    int cols;
+    std::uint32_t goalCell;
+    std::vector<std::uint64_t> open;    // Open cells, 64 to a word
+    std::vector<std::uint32_t> g;       // Moves to the goal, or UNREACHABLE
+    std::vector<std::uint32_t> rhs;     // Empty until the first setWall()
+    std::vector<HeapNode> heap;         // May hold stale entries; they are skipped when popped
+    std::uint64_t km;                   // Heuristic drift since the queued keys were made
+    std::uint32_t lastCell;             // Cell the queued keys were made for
+    std::size_t repairBudget;           // Queue entries per hint
+    std::size_t repairedCells;
+    bool repairing;                     // The last hint ran out of budget
+
+public:
+    static constexpr std::uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr std::size_t DEFAULT_REPAIR_BUDGET = 16384; // A few ms, even on a slow core
+
+    // Throws GameException if the level has more cells than fit in 32 bits
+    explicit DistanceField(const Level& level, std::size_t repairEntries = DEFAULT_REPAIR_BUDGET);
+
+    // Moves from `pos` to the goal, or UNREACHABLE (also for walls and cells off the level).
+    // Finishes any repair it needs, however long that takes.
+    std::uint32_t distance(const Position& pos);
+
+    // The first move of a shortest route from `pos`; false at the goal, with no route, or
+    // when the repair budget ran out first (isRepairing())
+    bool bestMove(const Position& pos, Direction& dir);
+    bool isRepairing() const { return repairing; }
+
+    // Turns the cell at `pos` into a wall or opens it, with the player at `player`.
+    // Throws GameException for a cell off the level or walling in the goal.
+    void setWall(const Position& pos, bool wall, const Position& player);
+
+    bool isWall(const Position& pos) const;
+
+    // Cells whose distance changed while repairing, since the field was built
+    std::size_t getRepairedCells() const { return repairedCells; }
+
+    // Bytes held by the walls, the distances and the repair queue
+    std::size_t memoryUsage() const;
+
+private:
+    bool isOpen(std::uint32_t cell) const { return (open[cell >> 6] >> (cell & 63)) & 1; }
+    // Open neighbours of `cell` by Direction, UNREACHABLE for walls and the level's edge
+    void neighbours(std::uint32_t cell, std::uint32_t next[4]) const;
+    std::uint32_t toCell(const Position& pos) const {
+        return static_cast<std::uint32_t>(pos.row) * static_cast<std::uint32_t>(cols) + static_cast<std::uint32_t>(pos.col);
+    }
+    std::uint32_t manhattan(std::uint32_t a, std::uint32_t b) const;
+
+    void fill();
+    HeapNode keyOf(std::uint32_t cell) const;
+    void moveStart(std::uint32_t cell);
+    void updateCell(std::uint32_t cell);
+    bool repair(std::uint32_t start, std::size_t budget); // False if the budget ran out
+};
+
+} // namespace MulaWee
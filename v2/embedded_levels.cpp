@@ -0,0 +1,60 @@
+#include "embedded_levels.hpp"
+#include "fixed_level.hpp"
+#include <vector>
+
+namespace MulaWee {
+namespace EmbeddedLevels {
+
+namespace {
+
+// Generated from ../data/levelN.dat by the Makefile: cells and EmbeddedLevel per
+// level, the static_asserts on them, and LEVELS in play order
+#include "embedded_levels.inc"
+
+// Generated the same way: EmbeddedLevelSizes, the sizes above as FixedLevelSizes
+#include "embedded_level_sizes.inc"
+
+// The embedded levels, each with FixedLevelRules of its size, so moves in play are
+// checked against compile-time bounds
+class EmbeddedSource : public LevelSource {
+private:
+    std::vector<std::shared_ptr<const Level>> levels;
+    std::vector<std::shared_ptr<const LevelRules>> rules;
+
+public:
+    EmbeddedSource() {
+        levels.reserve(count());
+        rules.reserve(count());
+        for (const EmbeddedLevel* embedded : LEVELS) {
+            levels.push_back(std::make_shared<Level>(*embedded));
+            rules.push_back(makeFixedRules(*levels.back(), EmbeddedLevelSizes()));
+            if (!rules.back()) {
+                throw GameException("No FixedLevel size for embedded level " + std::string(embedded->name));
+            }
+        }
+    }
+
+    std::size_t size() const override { return levels.size(); }
+    std::shared_ptr<const Level> get(std::size_t index) override { return levels.at(index); }
+    std::shared_ptr<const LevelRules> getRules(std::size_t index) override { return rules.at(index); }
+};
+
+} // namespace
+
+std::size_t count() {
+    return sizeof(LEVELS) / sizeof(LEVELS[0]);
+}
+
+const EmbeddedLevel& get(std::size_t index) {
+    if (index >= count()) {
+        throw GameException("No embedded level " + std::to_string(index + 1));
+    }
+    return *LEVELS[index];
+}
+
+std::shared_ptr<LevelSource> open() {
+    return std::make_shared<EmbeddedSource>();
+}
+
+} // namespace EmbeddedLevels
+} // namespace MulaWee
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "level_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace MulaWee {
+
+// The shipped levels built into the program. `mulavee_levelc --embed` turns the
+// text levels into constexpr tables (embedded_levels.inc), and embedded_levels.cpp
+// checks each one with static_assert, so a broken level fails the build rather than
+// the game. Playing them needs no file I/O and no parsing, from any directory, and
+// their moves are checked on a FixedLevel of each one's size (`--embed-sizes`).
+namespace EmbeddedLevels {
+
+std::size_t count();
+const EmbeddedLevel& get(std::size_t index);
+
+// Every embedded level, in play order, with FixedLevelRules for each
+std::shared_ptr<LevelSource> open();
+
+// Compile-time checks on one level's tables
+constexpr CellType cellAt(const EmbeddedLevel& level, int row, int col) {
+    return static_cast<CellType>(
+        (level.cells[(static_cast<std::size_t>(row) * level.cols + col) >> 2] >>
+         (((static_cast<std::size_t>(row) * level.cols + col) & 3) << 1)) & 3);
+}
+
+constexpr bool hasValidSize(const EmbeddedLevel& level) {
+    return level.rows > 0 && level.cols > 0 &&
+           level.cellBytes == (static_cast<std::size_t>(level.rows) * level.cols + 3) / 4;
+}
+
+constexpr bool hasOneGoal(const EmbeddedLevel& level) {
+    int goals = 0;
+    for (int r = 0; r < level.rows; ++r) {
+        for (int c = 0; c < level.cols; ++c) {
+            goals += cellAt(level, r, c) == CellType::GOAL;
+        }
+    }
+    return goals == 1 && level.goalRow >= 0 && level.goalRow < level.rows && level.goalCol >= 0 &&
+           level.goalCol < level.cols && cellAt(level, level.goalRow, level.goalCol) == CellType::GOAL;
+}
+
+constexpr bool hasOpenStart(const EmbeddedLevel& level) {
+    return level.startRow >= 0 && level.startRow < level.rows && level.startCol >= 0 &&
+           level.startCol < level.cols && cellAt(level, level.startRow, level.startCol) != CellType::WALL;
+}
+
+// Only the three cell types, and the unused bits of the last byte are clear
+constexpr bool hasKnownCells(const EmbeddedLevel& level) {
+    std::size_t cells = static_cast<std::size_t>(level.rows) * level.cols;
+    for (std::size_t i = 0; i < level.cellBytes * 4; ++i) {
+        unsigned cell = (level.cells[i >> 2] >> ((i & 3) << 1)) & 3;
+        if (cell > static_cast<unsigned>(CellType::GOAL) || (i >= cells && cell != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool hasChecksum(const EmbeddedLevel& level) {
+    return LevelFormat::checksum(level.cells, level.cellBytes) == level.checksum;
+}
+
+} // namespace EmbeddedLevels
+
+} // namespace MulaWee
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace MulaWee {
+
+// A level whose size is a compile-time constant. The packed cells live in a std::array
+// inside the object, so a bounds check compares against constants, a row-major index
+// is a multiply by a constant and a cell read has no pointer to follow. It has the
+// read interface of Level (getRows, getCols, isValidPosition, getCellType, canMoveTo,
+// cellAt, start, goal, name), which is all Player::move and MazeSolver use, so they
+// take either one. Built from any Level of the same size: text, compiled, packed or
+// embedded.
+template <int Rows, int Cols>
+class FixedLevel {
+    static_assert(Rows > 0 && Cols > 0, "a level needs at least one cell");
+
+public:
+    static constexpr std::size_t CELL_BYTES = (static_cast<std::size_t>(Rows) * Cols + 3) / 4;
+
+private:
+    std::array<std::uint8_t, CELL_BYTES> cells;
+    Position goalPosition;
+    Position startPosition;
+    std::uint32_t checksum;
+    std::string filename;
+
+public:
+    // Throws GameException unless `level` is Rows x Cols
+    explicit FixedLevel(const Level& level)
+        : goalPosition(level.getGoalPosition()), startPosition(level.getStartPosition()),
+          checksum(level.getChecksum()), filename(level.getFilename()) {
+        if (!fits(level)) {
+            throw GameException("Level " + filename + " is not " + std::to_string(Rows) + "x" +
+                                std::to_string(Cols));
+        }
+        std::memcpy(cells.data(), level.getGrid().data(), CELL_BYTES);
+    }
+
+    static bool fits(const Level& level) { return level.getRows() == Rows && level.getCols() == Cols; }
+
+    static constexpr int getRows() { return Rows; }
+    static constexpr int getCols() { return Cols; }
+    const Position& getGoalPosition() const { return goalPosition; }
+    const Position& getStartPosition() const { return startPosition; }
+    std::uint32_t getChecksum() const { return checksum; }
+    const std::string& getFilename() const { return filename; }
+
+    static constexpr bool isValidPosition(const Position& pos) {
+        return pos.row >= 0 && pos.row < Rows && pos.col >= 0 && pos.col < Cols;
+    }
+
+    CellType cellAt(std::size_t index) const {
+        return static_cast<CellType>((cells[index >> 2] >> ((index & 3) << 1)) & 3);
+    }
+
+    // Out-of-bounds positions read as walls
+    CellType getCellType(const Position& pos) const {
+        return isValidPosition(pos) ? cellAt(static_cast<std::size_t>(pos.row) * Cols + pos.col) : CellType::WALL;
+    }
+
+    bool canMoveTo(const Position& pos) const {
+        return isValidPosition(pos) && cellAt(static_cast<std::size_t>(pos.row) * Cols + pos.col) != CellType::WALL;
+    }
+};
+
+// GameSession's move and goal checks on a FixedLevel copy of the level being played
+template <int Rows, int Cols>
+class FixedLevelRules : public LevelRules {
+private:
+    FixedLevel<Rows, Cols> level;
+
+public:
+    explicit FixedLevelRules(const FixedLevel<Rows, Cols>& source) : level(source) {}
+
+    bool move(Player& player, Direction dir) const override { return player.move(dir, level); }
+    bool isGoal(const Position& pos) const override { return level.getCellType(pos) == CellType::GOAL; }
+};
+
+// A list of level sizes, rows then columns: FixedLevelSizes<19, 57, 19, 70>.
+// `mulavee_levelc --embed-sizes` writes the one for the shipped levels.
+template <int... RowsCols>
+struct FixedLevelSizes {
+    static_assert(sizeof...(RowsCols) % 2 == 0, "sizes come in rows, columns pairs");
+};
+
+// Calls visit(FixedLevel<R, C>(level)) for the first size in the list that `level`
+// has. False, without calling it, when the level has none of them.
+template <typename Visit>
+bool withFixedLevel(const Level&, Visit&&, FixedLevelSizes<>) {
+    return false;
+}
+
+template <int Rows, int Cols, int... Rest, typename Visit>
+bool withFixedLevel(const Level& level, Visit&& visit, FixedLevelSizes<Rows, Cols, Rest...>) {
+    if (FixedLevel<Rows, Cols>::fits(level)) {
+        visit(FixedLevel<Rows, Cols>(level));
+        return true;
+    }
+    return withFixedLevel(level, std::forward<Visit>(visit), FixedLevelSizes<Rest...>());
+}
+
+// FixedLevelRules for `level` if it has a size in the list, otherwise null
+template <int... RowsCols>
+std::shared_ptr<const LevelRules> makeFixedRules(const Level& level, FixedLevelSizes<RowsCols...> sizes) {
+    std::shared_ptr<const LevelRules> rules;
+    withFixedLevel(level, [&rules](const auto& fixed) {
+        using Fixed = typename std::decay<decltype(fixed)>::type;
+        rules = std::make_shared<FixedLevelRules<Fixed::getRows(), Fixed::getCols()>>(fixed);
+    }, sizes);
+    return rules;
+}
+
+} // namespace MulaWee
@@ -0,0 +1,336 @@
+#include "game_core.hpp"
+#include "latency.hpp"
+#include "level_format.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+namespace MulaWee {
+
+// PackedGrid implementation
+PackedGrid::PackedGrid(int rowCount, int colCount)
+    : bytes(bytesFor(rowCount, colCount), 0), cells(bytes.data()), rows(rowCount), cols(colCount) {}
+
+PackedGrid::PackedGrid(std::shared_ptr<const std::uint8_t> borrowed, int rowCount, int colCount)
+    : external(std::move(borrowed)), cells(external.get()), rows(rowCount), cols(colCount) {}
+
+PackedGrid::PackedGrid(const PackedGrid& other)
+    : bytes(other.bytes), external(other.external),
+      cells(other.external ? other.cells : bytes.data()),
+      rows(other.rows), cols(other.cols) {}
+
+PackedGrid::PackedGrid(PackedGrid&& other) noexcept
+    : bytes(std::move(other.bytes)), external(std::move(other.external)),
+      cells(external ? other.cells : bytes.data()),
+      rows(other.rows), cols(other.cols) {
+    other.cells = nullptr;
+    other.rows = other.cols = 0;
+}
+
+PackedGrid& PackedGrid::operator=(PackedGrid other) noexcept {
+    bytes.swap(other.bytes);
+    external.swap(other.external);
+    cells = external ? other.cells : bytes.data();
+    rows = other.rows;
+    cols = other.cols;
+    return *this;
+}
+
+void PackedGrid::set(int r, int c, CellType type) {
+    if (external) {
+        detach();
+    }
+    std::size_t index = static_cast<std::size_t>(r) * cols + c;
+    int shift = static_cast<int>((index & 3) << 1);
+    std::uint8_t& byte = bytes[index >> 2];
+    byte = static_cast<std::uint8_t>((byte & ~(3 << shift)) | (static_cast<int>(type) << shift));
+}
+
+void PackedGrid::detach() {
+    bytes.assign(cells, cells + byteSize());
+    external.reset();
+    cells = bytes.data();
+}
+
+// Level class implementation
+Level::Level(const std::string& levelFile)
+    : rows(0), cols(0), startPosition(defaultStart()), checksum(0), filename(levelFile), unknownCells(0) {
+    loadFromFile();
+}
+
+Level::Level(PackedGrid cells, const Position& start, const Position& goal, const std::string& name)
+    : grid(std::move(cells)), rows(grid.getRows()), cols(grid.getCols()),
+      goalPosition(goal), startPosition(start), checksum(0), filename(name), unknownCells(0) {
+    if (rows <= 0 || cols <= 0) {
+        throw GameException("Invalid level dimensions in " + filename);
+    }
+    checksum = LevelFormat::checksum(grid.data(), grid.byteSize());
+}
+
+Level::Level(const EmbeddedLevel& embedded)
+    : grid(std::shared_ptr<const std::uint8_t>(embedded.cells, [](const std::uint8_t*) {}),
+           embedded.rows, embedded.cols),
+      rows(embedded.rows), cols(embedded.cols), goalPosition(embedded.goalRow, embedded.goalCol),
+      startPosition(embedded.startRow, embedded.startCol), checksum(embedded.checksum),
+      filename(embedded.name), unknownCells(0) {}
+
+void Level::loadFromFile() {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw FileException(filename);
+    }
+
+    char magic[sizeof(LevelFormat::MAGIC)] = {};
+    if (file.read(magic, sizeof(magic)) &&
+        std::equal(magic, magic + sizeof(magic), LevelFormat::MAGIC)) {
+        file.close();
+        loadCompiled();
+        return;
+    }
+
+    file.clear();
+    file.seekg(0);
+    loadFromText(file);
+    checksum = LevelFormat::checksum(grid.data(), grid.byteSize());
+}
+
+void Level::loadFromText(std::ifstream& file) {
+    file >> rows >> cols;
+    if (!file || rows <= 0 || cols <= 0) {
+        throw GameException("Invalid level dimensions in " + filename);
+    }
+
+    grid = PackedGrid(rows, cols);
+
+    // Cells are the non-whitespace characters that follow the header, as with `file >> ch`,
+    // but read through the stream buffer so large levels do not pay for formatted input.
+    std::istreambuf_iterator<char> it(file), end;
+    long long total = static_cast<long long>(rows) * cols;
+    long long cell = 0;
+    for (; it != end && cell < total; ++it) {
+        char ch = *it;
+        if (std::isspace(static_cast<unsigned char>(ch))) {
+            continue;
+        }
+
+        int r = static_cast<int>(cell / cols);
+        int c = static_cast<int>(cell % cols);
+        ++cell;
+
+        switch (ch) {
+            case '*':
+                grid.set(r, c, CellType::PATH);
+                break;
+            case '$':
+                grid.set(r, c, CellType::GOAL);
+                goalPosition = Position(r, c);
+                break;
+            case '|':
+            case '%':
+                break; // Walls are the zeroed default
+            default:
+                ++unknownCells; // Also a wall; LevelValidator reports them
+        }
+    }
+
+    if (cell < total) {
+        throw GameException("Truncated level data in " + filename);
+    }
+}
+
+void Level::loadCompiled() {
+    // The grid borrows the mapping directly: no copy, no parse, pages fault in on use
+    std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(filename);
+    if (mapping->size() < sizeof(LevelFormat::Header)) {
+        throw GameException("Truncated level data in " + filename);
+    }
+
+    LevelFormat::Header header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    LevelFormat::validateHeader(header, mapping->size(), filename);
+
+    rows = header.rows;
+    cols = header.cols;
+    goalPosition = Position(header.goalRow, header.goalCol);
+    startPosition = Position(header.startRow, header.startCol);
+    checksum = header.checksum;
+
+    std::shared_ptr<const std::uint8_t> cells(mapping, mapping->data() + header.headerSize);
+    grid = PackedGrid(std::move(cells), rows, cols);
+}
+
+// Player class implementation
+void Player::reset(const Position& startPos) {
+    position = startPos;
+    lastPosition = startPos;
+    moveCount = 0;
+}
+
+// ScoreManager class implementation
+ScoreManager::ScoreManager(const std::string& logFile)
+    : runLogFile(logFile), currentScore(0), highScore(0) {
+    loadHighScore();
+}
+
+void ScoreManager::addLevelScore(int level, int moves) {
+    int levelScore = calculateLevelScore(level, moves);
+    currentScore += levelScore;
+    currentLevels.push_back(RunLevelResult{moves, levelScore});
+}
+
+void ScoreManager::loadHighScore() {
+    highScorePlayerName = "Default";
+    highScore = 0;
+    if (runLogFile.empty()) {
+        return;
+    }
+
+    auto best = [this](const RunRecord& record) {
+        if (record.total > highScore) {
+            highScore = record.total;
+            highScorePlayerName = record.playerName;
+        }
+    };
+    bool created = !std::ifstream(runLogFile).is_open();
+    runLog = std::make_unique<RunLog>(runLogFile, best);
+
+    if (created) {
+        std::ifstream legacy(legacyScorePathFor(runLogFile));
+        RunRecord record;
+        if (legacy >> record.playerName >> record.total) {
+            runLog->append(record);
+            best(record);
+        }
+    }
+}
+
+void ScoreManager::recordRun() {
+    if (!runLog) {
+        return;
+    }
+
+    RunRecord record;
+    record.playerName = currentPlayerName;
+    record.timestamp = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    record.total = currentScore;
+    record.levels = currentLevels;
+    runLog->append(record);
+
+    if (currentScore > highScore) {
+        highScore = currentScore;
+        highScorePlayerName = currentPlayerName;
+    }
+}
+
+int ScoreManager::calculateLevelScore(int level, int moves) const {
+    // Original scoring algorithm from the game
+    int baseScore;
+    switch (level) {
+        case 1: baseScore = 154; break;
+        case 2: baseScore = 253; break;
+        case 3: baseScore = 212; break;
+        default: baseScore = 100; break;
+    }
+
+    // Score decreases with more moves, but never goes below 0
+    int score = ((baseScore + std::max(0, baseScore - moves)) * baseScore) / 100;
+    return std::max(0, score);
+}
+
+bool keyToDirection(int key, Direction& dir) {
+    switch (key) {
+        case 'w': case 'W': dir = Direction::UP; return true;
+        case 's': case 'S': dir = Direction::DOWN; return true;
+        case 'a': case 'A': dir = Direction::LEFT; return true;
+        case 'd': case 'D': dir = Direction::RIGHT; return true;
+        default: return false;
+    }
+}
+
+// GameSession class implementation
+GameSession::GameSession(std::vector<std::shared_ptr<const Level>> levelSet,
+                         const std::string& runLogFile)
+    : GameSession(std::make_shared<LevelList>(std::move(levelSet)), runLogFile) {}
+
+GameSession::GameSession(std::shared_ptr<LevelSource> levelSource, const std::string& runLogFile)
+    : levels(std::move(levelSource)), scoreManager(runLogFile),
+      currentState(GameState::MENU), currentLevel(0), latency(nullptr) {
+    if (levels->size() == 0) {
+        throw GameException("No levels to play");
+    }
+    level = levels->get(0);
+}
+
+void GameSession::begin(const std::string& playerName) {
+    scoreManager.setPlayerName(playerName);
+    scoreManager.resetScore();
+    currentState = GameState::PLAYING;
+    startLevel(0);
+}
+
+MoveResult GameSession::move(Direction dir) {
+    if (currentState != GameState::PLAYING) {
+        return MoveResult::BLOCKED;
+    }
+
+    std::uint64_t start = latency ? latencyNow() : 0;
+    bool moved = rules ? rules->move(player, dir) : player.move(dir, *level);
+    std::uint64_t validated = latency ? latencyNow() : 0;
+    if (latency) {
+        latency->record(LatencyStage::VALIDATION, start, validated);
+    }
+    if (!moved) {
+        return MoveResult::BLOCKED;
+    }
+
+    // Same rule as the original game: stepping onto a goal cell completes the level
+    bool reachedGoal = rules ? rules->isGoal(player.getPosition())
+                             : level->getCellType(player.getPosition()) == CellType::GOAL;
+    if (latency) {
+        latency->record(LatencyStage::GOAL_CHECK, validated, latencyNow());
+    }
+    if (reachedGoal) {
+        currentState = GameState::LEVEL_COMPLETE;
+        return MoveResult::GOAL_REACHED;
+    }
+    return MoveResult::MOVED;
+}
+
+void GameSession::completeLevel() {
+    if (currentState != GameState::LEVEL_COMPLETE) {
+        return;
+    }
+
+    scoreManager.addLevelScore(currentLevel + 1, player.getMoveCount());
+
+    if (isLastLevel()) {
+        currentState = GameState::WINNER;
+    } else {
+        startLevel(currentLevel + 1);
+        currentState = GameState::PLAYING;
+    }
+}
+
+void GameSession::finishRun() {
+    scoreManager.recordRun();
+}
+
+void GameSession::startLevel(int index) {
+    if (index < 0 || index >= getLevelCount()) {
+        throw GameException("Invalid level number");
+    }
+
+    // Fetched again on every start, so a cache can hand out an edited level
+    level = levels->get(static_cast<std::size_t>(index));
+    rules = levels->getRules(static_cast<std::size_t>(index));
+    currentLevel = index;
+    player.reset(level->getStartPosition());
+    if (!isLastLevel()) {
+        levels->prefetch(static_cast<std::size_t>(index) + 1);
+    }
+}
+
+} // namespace MulaWee
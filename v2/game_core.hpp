@@ -0,0 +1,369 @@
+#pragma once
+
+#include "run_log.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+
+// Terminal-independent game core: no ncurses in here or in game_core.cpp
+
+namespace MulaWee {
+
+// Modern enums for better type safety
+enum class CellType : char {
+    WALL = 0,
+    PATH = 1,
+    GOAL = 2
+};
+
+enum class GameState {
+    MENU,
+    PLAYING,
+    LEVEL_COMPLETE,
+    GAME_OVER,
+    WINNER,
+    QUIT
+};
+
+enum class Direction {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT
+};
+
+// Position structure for better coordinate handling
+struct Position {
+    int row, col;
+
+    Position(int r = 0, int c = 0) : row(r), col(c) {}
+
+    Position operator+(const Position& other) const {
+        return Position(row + other.row, col + other.col);
+    }
+
+    bool operator==(const Position& other) const {
+        return row == other.row && col == other.col;
+    }
+};
+
+// Exception classes for better error handling
+class GameException : public std::runtime_error {
+public:
+    explicit GameException(const std::string& message)
+        : std::runtime_error("Game Error: " + message) {}
+};
+
+class FileException : public GameException {
+public:
+    explicit FileException(const std::string& filename)
+        : GameException("Failed to open file: " + filename) {}
+};
+
+// Contiguous row-major cell storage packed at 2 bits per cell (4 cells per byte).
+// A zeroed grid is all walls, so memory scales with the level and never with a cap.
+// The bytes are either owned or borrowed from external storage such as a mapped file.
+class PackedGrid {
+private:
+    std::vector<std::uint8_t> bytes;
+    std::shared_ptr<const std::uint8_t> external; // Keeps borrowed bytes alive
+    const std::uint8_t* cells;
+    int rows, cols;
+
+public:
+    PackedGrid() : cells(nullptr), rows(0), cols(0) {}
+    PackedGrid(int rowCount, int colCount);
+    PackedGrid(std::shared_ptr<const std::uint8_t> borrowed, int rowCount, int colCount);
+
+    PackedGrid(const PackedGrid& other);
+    PackedGrid(PackedGrid&& other) noexcept;
+    PackedGrid& operator=(PackedGrid other) noexcept;
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    const std::uint8_t* data() const { return cells; }
+    std::size_t byteSize() const { return bytesFor(rows, cols); }
+    bool isBorrowed() const { return external != nullptr; }
+
+    // Callers are expected to have bounds-checked (r, c)
+    CellType get(int r, int c) const {
+        std::size_t index = static_cast<std::size_t>(r) * cols + c;
+        return static_cast<CellType>((cells[index >> 2] >> ((index & 3) << 1)) & 3);
+    }
+
+    // Same as get() for a precomputed row-major index
+    CellType at(std::size_t index) const {
+        return static_cast<CellType>((cells[index >> 2] >> ((index & 3) << 1)) & 3);
+    }
+
+    // Writing to a borrowed grid first copies it into owned storage
+    void set(int r, int c, CellType type);
+
+    static std::size_t bytesFor(int rowCount, int colCount) {
+        return (static_cast<std::size_t>(rowCount) * colCount + 3) / 4;
+    }
+
+private:
+    void detach();
+};
+
+class LatencyRecorder; // Optional per-stage timing (latency.hpp)
+
+// A level built into the program as constant tables (see embedded_levels.hpp)
+struct EmbeddedLevel {
+    const char* name;
+    int rows, cols;
+    int goalRow, goalCol;
+    int startRow, startCol;
+    std::uint32_t checksum;
+    const std::uint8_t* cells; // PackedGrid bytes
+    std::size_t cellBytes;
+};
+
+// Level class - encapsulates level data and operations
+class Level {
+private:
+    PackedGrid grid;
+    int rows, cols;
+    Position goalPosition;
+    Position startPosition;
+    std::uint32_t checksum;
+    std::string filename;
+    std::size_t unknownCells; // Text cells read as walls (see loadFromText)
+
+public:
+    // Loads either a text .dat level or a compiled level (see level_format.hpp)
+    explicit Level(const std::string& levelFile);
+
+    // Builds a level from cells already in memory (generators, tests, benchmarks)
+    Level(PackedGrid cells, const Position& start, const Position& goal,
+          const std::string& name = "<memory>");
+
+    // No I/O and no parsing: the grid is used in place from the program image
+    explicit Level(const EmbeddedLevel& embedded);
+
+    // Text levels do not record a start, so they all begin here (grid coordinates)
+    static Position defaultStart() { return Position(17, 1); }
+
+    // Getters
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    const Position& getGoalPosition() const { return goalPosition; }
+    const Position& getStartPosition() const { return startPosition; }
+    std::uint32_t getChecksum() const { return checksum; }
+    const PackedGrid& getGrid() const { return grid; }
+    const std::string& getFilename() const { return filename; }
+    std::size_t getUnknownCells() const { return unknownCells; }
+
+    // Out-of-bounds positions read as walls
+    CellType getCellType(const Position& pos) const {
+        return isValidPosition(pos) ? grid.get(pos.row, pos.col) : CellType::WALL;
+    }
+
+    // Validation (inline - these sit on every move and every search step)
+    bool isValidPosition(const Position& pos) const {
+        return pos.row >= 0 && pos.row < rows && pos.col >= 0 && pos.col < cols;
+    }
+
+    bool canMoveTo(const Position& pos) const {
+        return isValidPosition(pos) && grid.get(pos.row, pos.col) != CellType::WALL;
+    }
+
+    // Row-major index, bounds-checked by the caller (search loops)
+    CellType cellAt(std::size_t index) const { return grid.at(index); }
+
+private:
+    void loadFromFile();
+    void loadFromText(std::ifstream& file);
+    void loadCompiled();
+};
+
+// Player class - encapsulates player state and movement
+class Player {
+private:
+    Position position;
+    Position lastPosition;
+    int moveCount;
+
+public:
+    // Positions are grid coordinates; renderers add their own screen offset
+    Player(const Position& startPos = Level::defaultStart())
+        : position(startPos), lastPosition(startPos), moveCount(0) {}
+
+    // Movement - returns false (and stays put) when the target is a wall. Takes a
+    // Level or a FixedLevel (fixed_level.hpp); inline so either one's checks fold in.
+    template <typename LevelType>
+    bool move(Direction dir, const LevelType& level) {
+        Position newPos = position + getDirectionOffset(dir);
+        if (!level.canMoveTo(newPos)) {
+            return false;
+        }
+        lastPosition = position;
+        position = newPos;
+        ++moveCount;
+        return true;
+    }
+    void setPosition(const Position& pos) { position = pos; }
+
+    // Getters
+    const Position& getPosition() const { return position; }
+    const Position& getLastPosition() const { return lastPosition; }
+    int getMoveCount() const { return moveCount; }
+
+    // Reset for new level
+    void reset(const Position& startPos);
+
+private:
+    static Position getDirectionOffset(Direction dir) {
+        switch (dir) {
+            case Direction::UP:    return Position(-1, 0);
+            case Direction::DOWN:  return Position(1, 0);
+            case Direction::LEFT:  return Position(0, -1);
+            case Direction::RIGHT: return Position(0, 1);
+        }
+        return Position(0, 0);
+    }
+};
+
+// Score management class. Every finished run is appended to a RunLog and the high
+// score is the best total in it; an empty log path keeps everything in memory.
+class ScoreManager {
+private:
+    std::string runLogFile;
+    std::unique_ptr<RunLog> runLog;
+    std::string currentPlayerName;
+    int currentScore;
+    std::vector<RunLevelResult> currentLevels;
+    std::string highScorePlayerName;
+    int highScore;
+
+public:
+    explicit ScoreManager(const std::string& logFile = "../data/runs.mwlog");
+
+    // Score operations
+    void addLevelScore(int level, int moves);
+    void setPlayerName(const std::string& name) { currentPlayerName = name; }
+
+    // High score management. A new log starts with the entry from the old score.dat
+    // beside it, if there is one.
+    void loadHighScore();
+    void recordRun(); // Append the run so far to the log
+    bool isNewHighScore() const { return currentScore > highScore; }
+
+    // Getters
+    int getCurrentScore() const { return currentScore; }
+    int getHighScore() const { return highScore; }
+    const std::string& getCurrentPlayerName() const { return currentPlayerName; }
+    const std::string& getHighScorePlayerName() const { return highScorePlayerName; }
+    const std::vector<RunLevelResult>& getCurrentLevels() const { return currentLevels; }
+
+    // Reset
+    void resetScore() {
+        currentScore = 0;
+        currentLevels.clear();
+    }
+
+    // Public method for calculating level scores
+    int calculateLevelScore(int level, int moves) const;
+};
+
+
+// Map a WASD key to a direction; returns false for any other key
+bool keyToDirection(int key, Direction& dir);
+
+enum class MoveResult {
+    MOVED,
+    BLOCKED,
+    GOAL_REACHED
+};
+
+// Move validation and the goal test for one level, when a LevelSource has something
+// faster than the Level to check them on (the embedded levels hand out FixedLevels)
+class LevelRules {
+public:
+    virtual ~LevelRules() = default;
+
+    virtual bool move(Player& player, Direction dir) const = 0;
+    virtual bool isGoal(const Position& pos) const = 0;
+};
+
+// Where a GameSession gets its levels. A fixed list keeps them all in memory; a
+// LevelCache (level_cache.hpp) loads them as they are reached.
+class LevelSource {
+public:
+    virtual ~LevelSource() = default;
+
+    virtual std::size_t size() const = 0;
+    virtual std::shared_ptr<const Level> get(std::size_t index) = 0;
+
+    // `index` is likely to be needed soon
+    virtual void prefetch(std::size_t index) { (void)index; }
+
+    // Rules to play `index` by instead of its Level; null means the Level's own checks
+    virtual std::shared_ptr<const LevelRules> getRules(std::size_t index) {
+        (void)index;
+        return nullptr;
+    }
+};
+
+// Levels already in memory, in play order
+class LevelList : public LevelSource {
+private:
+    std::vector<std::shared_ptr<const Level>> levels;
+
+public:
+    explicit LevelList(std::vector<std::shared_ptr<const Level>> levelSet) : levels(std::move(levelSet)) {}
+
+    std::size_t size() const override { return levels.size(); }
+    std::shared_ptr<const Level> get(std::size_t index) override { return levels.at(index); }
+};
+
+// Headless game state machine - levels, player, score and goal detection with no
+// terminal attached. Game drives one of these interactively; batch tools drive it directly.
+class GameSession {
+private:
+    std::shared_ptr<LevelSource> levels;
+    std::shared_ptr<const Level> level; // The one being played, kept while it is
+    std::shared_ptr<const LevelRules> rules; // Its source's rules for it, or null
+    ScoreManager scoreManager;
+    Player player;
+    GameState currentState;
+    int currentLevel;
+    LatencyRecorder* latency; // Null unless latency reporting is on
+
+public:
+    GameSession(std::vector<std::shared_ptr<const Level>> levelSet,
+                const std::string& runLogFile = "../data/runs.mwlog");
+    GameSession(std::shared_ptr<LevelSource> levelSource,
+                const std::string& runLogFile = "../data/runs.mwlog");
+
+    // State transitions
+    void begin(const std::string& playerName); // MENU -> PLAYING at level 0
+    MoveResult move(Direction dir);              // PLAYING -> LEVEL_COMPLETE on the goal
+    void completeLevel();                        // LEVEL_COMPLETE -> PLAYING or WINNER
+    void finishRun();                            // WINNER: append the run to the run log
+    void setState(GameState state) { currentState = state; }
+
+    // Time move validation and the goal check into `recorder` (null turns it off)
+    void setLatencyRecorder(LatencyRecorder* recorder) { latency = recorder; }
+
+    // Getters
+    GameState getState() const { return currentState; }
+    int getCurrentLevel() const { return currentLevel; }
+    int getLevelCount() const { return static_cast<int>(levels->size()); }
+    bool isLastLevel() const { return currentLevel + 1 >= getLevelCount(); }
+    const Level& getLevel() const { return *level; }
+    std::shared_ptr<const Level> shareLevel() const { return level; } // For work that may outlive the level
+    const Player& getPlayer() const { return player; }
+    ScoreManager& getScoreManager() { return scoreManager; }
+    const ScoreManager& getScoreManager() const { return scoreManager; }
+
+private:
+    void startLevel(int index);
+};
+
+} // namespace MulaWee
@@ -0,0 +1,925 @@
+#include "game_server.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+namespace MulaWee {
+
+namespace {
+
+constexpr std::uint64_t LISTEN_ID = 0;
+constexpr std::uint64_t WAKE_ID = 1;
+constexpr std::uint64_t SPECTATE_ID = 2;
+constexpr int MAX_EVENTS = 256;
+constexpr int MAX_IOVECS = 64;
+constexpr std::size_t READ_CHUNK = 4096;
+constexpr std::uint32_t READ_EVENTS = EPOLLIN;
+constexpr std::uint32_t WRITE_EVENTS = EPOLLOUT;
+
+// Screen offset of the level's top-left cell, and the rows under it for the status
+constexpr int BOARD_ROW = 3;
+constexpr int BOARD_COL = 3;
+constexpr int UI_ROWS = 6;
+
+// Telnet commands (RFC 854). Clients are asked to send each key as typed and to
+// leave echoing to the server; the commands they send back are skipped.
+constexpr std::uint8_t TELNET_IAC = 255;
+constexpr std::uint8_t TELNET_SB = 250;
+constexpr std::uint8_t TELNET_SE = 240;
+constexpr std::uint8_t TELNET_WILL = 251;
+constexpr std::uint8_t TELNET_DONT = 254;
+constexpr const char TELNET_CHARACTER_MODE[] = "\xff\xfb\x01\xff\xfb\x03"; // WILL ECHO, WILL SGA
+
+// Connection ids carry their event loop in the low bits, so a game number typed by a
+// spectator on any loop names the loop that runs it
+constexpr unsigned LOOP_BITS = 8;
+constexpr unsigned MAX_LOOPS = 1u << LOOP_BITS;
+constexpr std::size_t MAX_GAME_DIGITS = 19;
+
+constexpr const char CHOOSE_PROMPT[] = "\r\nGame to watch (Enter for any): ";
+constexpr const char GAME_ENDED[] = "\x1b[0m\x1b[2J\x1b[H\x1b[?25hThe game has ended.\r\n";
+
+enum TelnetState { TELNET_DATA, TELNET_COMMAND, TELNET_OPTION, TELNET_SUBNEGOTIATION, TELNET_SUB_IAC };
+
+GameException systemError(const std::string& what) {
+    return GameException(what + ": " + std::strerror(errno));
+}
+
+bool isEnter(int ch) {
+    return ch == '\r' || ch == '\n';
+}
+
+} // namespace
+
+// ServerSession class implementation
+ServerSession::ServerSession(const std::vector<std::shared_ptr<const Level>>& levels, std::uint64_t id)
+    : gameId(id), session(levels, ""), screen(new AnsiRenderer(SCREEN_ROWS, SCREEN_COLS)),
+      renderer(std::unique_ptr<Renderer>(screen)), telnetState(TELNET_DATA), finished(false),
+      runFinished(false), keys(0), frames(0) {}
+
+void ServerSession::start() {
+    screen->getOutput().append(TELNET_CHARACTER_MODE, sizeof(TELNET_CHARACTER_MODE) - 1);
+    screen->reset();
+    drawWelcome();
+    renderer.refresh();
+    ++frames;
+}
+
+void ServerSession::handleInput(const std::uint8_t* data, std::size_t size) {
+    KeyBatch batch;
+    batch.start = session.getPlayer().getPosition();
+
+    for (std::size_t i = 0; i < size && !finished; ++i) {
+        int ch = filterTelnet(data[i]);
+        if (ch >= 0) {
+            ++keys;
+            handleKey(ch, batch);
+        }
+    }
+
+    if (session.getState() == GameState::PLAYING && batch.lastKey != 0) {
+        renderBatch(batch);
+    }
+    std::size_t before = screen->getOutput().size();
+    renderer.refresh(); // One frame per batch of keys
+    if (screen->getOutput().size() != before) {
+        ++frames;
+    }
+}
+
+std::string ServerSession::keyframe() {
+    AnsiRenderer fresh(SCREEN_ROWS, SCREEN_COLS);
+    fresh.reset();
+    renderer.repaint(fresh);
+    screen->forgetCursor();
+    return std::move(fresh.getOutput());
+}
+
+bool ServerSession::takeFinishedRun(RunRecord& run) {
+    if (!runFinished) {
+        return false;
+    }
+    const ScoreManager& scores = session.getScoreManager();
+    run.playerName = scores.getCurrentPlayerName();
+    run.timestamp = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    run.total = scores.getCurrentScore();
+    run.levels = scores.getCurrentLevels();
+    runFinished = false;
+    return true;
+}
+
+int ServerSession::filterTelnet(std::uint8_t byte) {
+    switch (telnetState) {
+        case TELNET_DATA:
+            if (byte == TELNET_IAC) {
+                telnetState = TELNET_COMMAND;
+                return -1;
+            }
+            return byte;
+        case TELNET_COMMAND:
+            if (byte == TELNET_SB) {
+                telnetState = TELNET_SUBNEGOTIATION;
+            } else if (byte >= TELNET_WILL && byte <= TELNET_DONT) {
+                telnetState = TELNET_OPTION;
+            } else {
+                telnetState = TELNET_DATA;
+            }
+            return -1;
+        case TELNET_OPTION:
+            telnetState = TELNET_DATA;
+            return -1;
+        case TELNET_SUBNEGOTIATION:
+            if (byte == TELNET_IAC) {
+                telnetState = TELNET_SUB_IAC;
+            }
+            return -1;
+        default:
+            telnetState = byte == TELNET_SE ? TELNET_DATA : TELNET_SUBNEGOTIATION;
+            return -1;
+    }
+}
+
+void ServerSession::handleKey(int ch, KeyBatch& batch) {
+    switch (session.getState()) {
+        case GameState::MENU:
+            if (isEnter(ch)) {
+                session.begin(typedName.empty() ? "Player" : typedName);
+                typedName.clear();
+                drawGame();
+                batch = KeyBatch();
+                batch.start = session.getPlayer().getPosition();
+            } else if ((ch == 8 || ch == 127) && !typedName.empty()) {
+                typedName.pop_back();
+                drawNamePrompt();
+            } else if (ch >= 32 && ch < 127 && typedName.size() < MAX_NAME) {
+                typedName += static_cast<char>(ch);
+                drawNamePrompt();
+            }
+            return;
+
+        case GameState::PLAYING: {
+            if (isEnter(ch) || ch == 0) {
+                return; // Line endings from clients that still send lines
+            }
+            if (ch == 'q' || ch == 'Q') {
+                finished = true;
+                return;
+            }
+            Direction dir;
+            batch.lastKey = ch;
+            batch.lastKeyValid = keyToDirection(ch, dir);
+            if (!batch.lastKeyValid) {
+                batch.blocked = true;
+                return;
+            }
+            MoveResult result = session.move(dir);
+            if (result == MoveResult::BLOCKED) {
+                batch.blocked = true;
+            } else if (result == MoveResult::GOAL_REACHED) {
+                drawLevelComplete();
+                batch = KeyBatch();
+            } else {
+                batch.moved = true;
+            }
+            return;
+        }
+
+        case GameState::LEVEL_COMPLETE:
+            // Any key continues, as on the terminal
+            session.completeLevel();
+            if (session.getState() == GameState::WINNER) {
+                runFinished = true;
+                drawWinner();
+            } else {
+                drawGame();
+                batch = KeyBatch();
+                batch.start = session.getPlayer().getPosition();
+            }
+            return;
+
+        case GameState::WINNER:
+            if (ch == 'y' || ch == 'Y') {
+                session.setState(GameState::MENU);
+                drawWelcome();
+            } else if (ch == 'n' || ch == 'N' || ch == 'q' || ch == 'Q') {
+                finished = true;
+            }
+            return;
+
+        default:
+            finished = true;
+            return;
+    }
+}
+
+void ServerSession::renderBatch(const KeyBatch& batch) {
+    int messageRow = BOARD_ROW + camera.getRows() + UI_ROWS - 1;
+    if (batch.lastKeyValid) {
+        renderer.print(messageRow, 3, ColorPair::GREEN, "Key pressed: %c                    ",
+                       batch.lastKey);
+    } else {
+        renderer.print(messageRow, 3, ColorPair::RED, "'%c' is Invalid Key.... (code: %d)",
+                       batch.lastKey >= 32 && batch.lastKey < 127 ? batch.lastKey : '?', batch.lastKey);
+    }
+
+    if (batch.moved) {
+        const Position& pos = session.getPlayer().getPosition();
+        if (camera.follow(pos)) {
+            drawBoard();
+        } else if (!(pos == batch.start)) {
+            renderer.drawChar(BOARD_ROW + batch.start.row - camera.getTop(),
+                              BOARD_COL + batch.start.col - camera.getLeft(), ColorPair::GREEN, ' ');
+        }
+        drawStatus();
+    }
+    drawPlayer();
+
+    if (batch.blocked) {
+        renderer.beep();
+    }
+}
+
+void ServerSession::drawWelcome() {
+    // No border: an idle session's screen buffers only hold what is drawn
+    renderer.clear();
+    renderer.drawText(6, 30, ColorPair::YELLOW, "MULA WEE");
+    renderer.drawText(7, 25, ColorPair::YELLOW, "Optimized Version 2.0");
+    renderer.drawText(10, 8, ColorPair::GREEN, "Navigate through the maze to reach the goal ($)");
+    renderer.drawText(12, 8, ColorPair::GREEN, "Controls: W A S D to move, Q to quit");
+    drawNamePrompt();
+}
+
+void ServerSession::drawNamePrompt() {
+    renderer.print(15, 8, ColorPair::YELLOW, "Enter your name: %-10s", typedName.c_str());
+}
+
+void ServerSession::drawGame() {
+    renderer.clear();
+    renderer.drawText(1, 30, ColorPair::RED, "MULA WEE (Optimized Version 2.0)");
+    renderer.print(2, 3, ColorPair::RED, "Level: %d", session.getCurrentLevel() + 1);
+    renderer.print(2, 60, ColorPair::RED, "Game %llu", static_cast<unsigned long long>(gameId));
+
+    const Level& level = session.getLevel();
+    camera.reset(level.getRows(), level.getCols(), SCREEN_ROWS - BOARD_ROW - UI_ROWS,
+                 SCREEN_COLS - BOARD_COL - 1);
+    camera.follow(session.getPlayer().getPosition());
+    drawBoard();
+    drawPlayer();
+    drawStatus();
+}
+
+void ServerSession::drawBoard() {
+    renderer.drawLevelWindow(session.getLevel(), BOARD_ROW, BOARD_COL, camera.getTop(), camera.getLeft(),
+                             camera.getRows(), camera.getCols());
+}
+
+void ServerSession::drawPlayer() {
+    const Position& pos = session.getPlayer().getPosition();
+    renderer.drawChar(BOARD_ROW + pos.row - camera.getTop(), BOARD_COL + pos.col - camera.getLeft(),
+                      ColorPair::YELLOW, '*');
+}
+
+void ServerSession::drawStatus() {
+    int uiRow = BOARD_ROW + camera.getRows() + 1;
+    const Player& player = session.getPlayer();
+    renderer.print(uiRow, 3, ColorPair::BLUE, "Position: (%d, %d)   ", player.getPosition().row,
+                   player.getPosition().col);
+    renderer.print(uiRow + 1, 3, ColorPair::BLUE, "Moves: %d", player.getMoveCount());
+    renderer.print(uiRow + 2, 3, ColorPair::BLUE, "Score: %d", session.getScoreManager().getCurrentScore());
+    renderer.drawText(uiRow + 3, 3, ColorPair::YELLOW, "Controls: WASD to move, Q to quit");
+}
+
+void ServerSession::drawLevelComplete() {
+    const ScoreManager& scores = session.getScoreManager();
+    int level = session.getCurrentLevel() + 1;
+    int moves = session.getPlayer().getMoveCount();
+
+    renderer.clear();
+    renderer.print(8, 25, ColorPair::GREEN, "Level %d Complete!", level);
+    renderer.print(10, 25, ColorPair::GREEN, "Moves: %d", moves);
+    renderer.print(11, 25, ColorPair::GREEN, "Level Score: %d", scores.calculateLevelScore(level, moves));
+    renderer.print(12, 25, ColorPair::GREEN, "Total Score: %d",
+                   scores.getCurrentScore() + scores.calculateLevelScore(level, moves));
+    renderer.drawText(20, 25, ColorPair::YELLOW, "Press any key to continue...");
+}
+
+void ServerSession::drawWinner() {
+    const ScoreManager& scores = session.getScoreManager();
+    renderer.clear();
+    renderer.drawText(5, 32, ColorPair::YELLOW, "---MULA WEE---");
+    renderer.drawText(7, 28, ColorPair::YELLOW, "YOU ARE THE WINNER!");
+    renderer.print(10, 28, ColorPair::GREEN, "%s: %d", scores.getCurrentPlayerName().c_str(),
+                   scores.getCurrentScore());
+    renderer.drawText(14, 28, ColorPair::YELLOW, "Play again? (y/n)");
+}
+
+// GameServer class implementation
+GameServer::GameServer(const std::vector<std::shared_ptr<const Level>>& gameLevels,
+                       const GameServerOptions& serverOptions)
+    : options(serverOptions), levels(gameLevels), runLogFailing(false), stopping(false), openSessions(0) {
+    if (!options.runLogFile.empty()) {
+        runLog = std::make_unique<RunLog>(options.runLogFile);
+    }
+
+    unsigned count = std::min(MAX_LOOPS, std::max(1u, options.threads));
+    for (unsigned i = 0; i < count; ++i) {
+        std::unique_ptr<EventLoop> loop(new EventLoop());
+        loop->index = i;
+        loop->wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->wakeFd < 0) {
+            throw systemError("eventfd");
+        }
+        loops.push_back(std::move(loop));
+    }
+}
+
+GameServer::~GameServer() {
+    for (std::unique_ptr<EventLoop>& loop : loops) {
+        closeLoop(*loop);
+        ::close(loop->wakeFd);
+    }
+}
+
+void GameServer::stop() {
+    stopping.store(true);
+    for (std::unique_ptr<EventLoop>& loop : loops) {
+        std::uint64_t one = 1;
+        ssize_t ignored = ::write(loop->wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void GameServer::run() {
+    for (std::unique_ptr<EventLoop>& loop : loops) {
+        openLoop(*loop);
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < loops.size(); ++i) {
+        EventLoop* loop = loops[i].get();
+        threads.emplace_back([this, loop] {
+            try {
+                runLoop(*loop);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                loopError = std::current_exception();
+                stop();
+            }
+        });
+    }
+    try {
+        runLoop(*loops[0]);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        loopError = std::current_exception();
+        stop();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (loopError) {
+        std::rethrow_exception(loopError);
+    }
+
+    stats = GameServerStats();
+    for (std::unique_ptr<EventLoop>& loop : loops) {
+        closeLoop(*loop);
+        const GameServerStats& part = loop->stats;
+        stats.sessions += part.sessions;
+        stats.refused += part.refused;
+        stats.peakSessions = std::max(stats.peakSessions, part.peakSessions);
+        stats.keys += part.keys;
+        stats.frames += part.frames;
+        stats.bytesSent += part.bytesSent;
+        stats.runs += part.runs;
+        stats.runsNotLogged += part.runsNotLogged;
+        stats.pauses += part.pauses;
+        stats.spectators += part.spectators;
+        stats.framesShared += part.framesShared;
+        stats.framesSkipped += part.framesSkipped;
+        stats.keyframes += part.keyframes;
+    }
+}
+
+int GameServer::openListener(const std::string& host, int port) {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw GameException("Bad listen address: " + host);
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(fd, SOMAXCONN) < 0) {
+        GameException error = systemError("Cannot listen on " + host + ":" + std::to_string(port));
+        ::close(fd);
+        throw error;
+    }
+    return fd;
+}
+
+void GameServer::openLoop(EventLoop& loop) {
+    loop.listenFd = openListener(options.host, options.port);
+    if (options.spectatePort > 0) {
+        loop.spectateFd = openListener(options.host, options.spectatePort);
+    }
+
+    loop.epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (loop.epollFd < 0) {
+        throw systemError("epoll_create1");
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    ::epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.listenFd, &event);
+    event.data.u64 = WAKE_ID;
+    ::epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.wakeFd, &event);
+    if (loop.spectateFd >= 0) {
+        event.data.u64 = SPECTATE_ID;
+        ::epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.spectateFd, &event);
+    }
+}
+
+void GameServer::runLoop(EventLoop& loop) {
+    epoll_event events[MAX_EVENTS];
+    while (!stopping.load()) {
+        int count = ::epoll_wait(loop.epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("epoll_wait");
+        }
+        for (int i = 0; i < count; ++i) {
+            std::uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptConnections(loop, loop.listenFd, Role::PLAYER);
+            } else if (id == SPECTATE_ID) {
+                acceptConnections(loop, loop.spectateFd, Role::CHOOSING);
+            } else if (id == WAKE_ID) {
+                std::uint64_t value;
+                ssize_t ignored = ::read(loop.wakeFd, &value, sizeof(value));
+                (void)ignored;
+                takeHandoffs(loop);
+            } else {
+                handleEvents(loop, id, events[i].events);
+            }
+        }
+        flushViewers(loop);
+        appendFinishedRuns(loop);
+    }
+}
+
+std::uint64_t GameServer::addConnection(EventLoop& loop, int fd, Role role) {
+    std::uint64_t id = (++loop.nextConnection << LOOP_BITS) | loop.index;
+    Connection& conn = loop.connections[id];
+    conn.fd = fd;
+    conn.role = role;
+    loop.stats.peakSessions = std::max(loop.stats.peakSessions, ++openSessions);
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.data.u64 = id;
+    ::epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &event);
+    return id;
+}
+
+void GameServer::acceptConnections(EventLoop& loop, int listenFd, Role role) {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // EAGAIN, or out of descriptors until a client leaves
+        }
+        if (loop.connections.size() >= options.maxSessions) {
+            ::close(fd);
+            ++loop.stats.refused;
+            continue;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Frames are small
+
+        std::uint64_t id = addConnection(loop, fd, role);
+        Connection& conn = loop.connections[id];
+        if (role == Role::PLAYER) {
+            conn.session = std::make_unique<ServerSession>(levels, id);
+            conn.session->start();
+            ++loop.stats.sessions;
+            publish(loop, conn);
+        } else {
+            enqueue(conn, std::make_shared<const std::string>(
+                              std::string(TELNET_CHARACTER_MODE, sizeof(TELNET_CHARACTER_MODE) - 1) + CHOOSE_PROMPT));
+        }
+        if (!flushOutput(loop, conn)) {
+            closeConnection(loop, id);
+            continue;
+        }
+        updateInterest(loop, id, conn);
+    }
+}
+
+void GameServer::handleEvents(EventLoop& loop, std::uint64_t id, std::uint32_t events) {
+    auto found = loop.connections.find(id);
+    if (found == loop.connections.end()) {
+        return;
+    }
+    Connection& conn = found->second;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeConnection(loop, id);
+        return;
+    }
+    if (events & EPOLLIN) {
+        // One read per wakeup keeps a fast typist from starving the others
+        std::uint8_t chunk[READ_CHUNK];
+        ssize_t got;
+        do {
+            got = ::read(conn.fd, chunk, sizeof(chunk));
+        } while (got < 0 && errno == EINTR);
+
+        if (got > 0) {
+            std::size_t size = static_cast<std::size_t>(got);
+            if (conn.role == Role::PLAYER) {
+                handlePlayerInput(loop, conn, chunk, size);
+            } else if (conn.role == Role::CHOOSING) {
+                handleChoice(loop, id, conn, chunk, size);
+                if (loop.connections.find(id) == loop.connections.end()) {
+                    return; // Handed to the loop that runs the game
+                }
+            } else if (std::find(chunk, chunk + size, 'q') != chunk + size ||
+                       std::find(chunk, chunk + size, 'Q') != chunk + size) {
+                conn.closing = true;
+            }
+        } else if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            conn.peerClosed = true;
+        }
+    }
+
+    bool flushed = conn.role == Role::SPECTATOR ? flushSpectator(loop, conn) : flushOutput(loop, conn);
+    bool done = conn.queuedBytes == 0 && (conn.closing || (conn.session && conn.session->isFinished()));
+    if (!flushed || conn.peerClosed || done) {
+        closeConnection(loop, id);
+        return;
+    }
+    updateInterest(loop, id, conn);
+}
+
+void GameServer::handlePlayerInput(EventLoop& loop, Connection& conn, const std::uint8_t* data,
+                                   std::size_t size) {
+    conn.session->handleInput(data, size);
+    RunRecord run;
+    if (conn.session->takeFinishedRun(run)) {
+        ++loop.stats.runs;
+        if (runLog) {
+            loop.finishedRuns.push_back(std::move(run));
+        }
+    }
+    publish(loop, conn);
+}
+
+void GameServer::handleChoice(EventLoop& loop, std::uint64_t id, Connection& conn, const std::uint8_t* data,
+                              std::size_t size) {
+    std::string echo;
+    for (std::size_t i = 0; i < size; ++i) {
+        int ch = data[i];
+        if (ch >= '0' && ch <= '9' && conn.typed.size() < MAX_GAME_DIGITS) {
+            conn.typed += static_cast<char>(ch);
+            echo += static_cast<char>(ch);
+        } else if ((ch == 8 || ch == 127) && !conn.typed.empty()) {
+            conn.typed.pop_back();
+            echo += "\b \b";
+        } else if (ch == 'q' || ch == 'Q') {
+            conn.closing = true;
+            break;
+        } else if (isEnter(ch)) {
+            std::uint64_t game = 0;
+            if (!conn.typed.empty()) {
+                game = std::strtoull(conn.typed.c_str(), nullptr, 10);
+            } else {
+                for (const auto& entry : loop.connections) {
+                    if (entry.second.role == Role::PLAYER) {
+                        game = entry.first;
+                        break;
+                    }
+                }
+            }
+            unsigned owner = static_cast<unsigned>(game & (MAX_LOOPS - 1));
+            if (game >= MAX_LOOPS && owner < loops.size() && owner != loop.index) {
+                // The game runs on another loop: move the socket there
+                ::epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+                EventLoop& target = *loops[owner];
+                {
+                    std::lock_guard<std::mutex> lock(target.handoffMutex);
+                    target.handoffs.push_back(Handoff{conn.fd, game});
+                }
+                loop.connections.erase(id);
+                --openSessions;
+                std::uint64_t one = 1;
+                ssize_t ignored = ::write(target.wakeFd, &one, sizeof(one));
+                (void)ignored;
+                return;
+            }
+            if (!echo.empty()) {
+                enqueue(conn, std::make_shared<const std::string>(std::move(echo)));
+            }
+            watch(loop, id, game);
+            return;
+        }
+    }
+    if (!echo.empty()) {
+        enqueue(conn, std::make_shared<const std::string>(std::move(echo)));
+    }
+}
+
+void GameServer::watch(EventLoop& loop, std::uint64_t id, std::uint64_t game) {
+    Connection& conn = loop.connections[id];
+    auto found = loop.connections.find(game);
+    if (game == 0 || found == loop.connections.end() || found->second.role != Role::PLAYER) {
+        std::string reply = game == 0 ? std::string("\r\nNo games are being played")
+                                      : "\r\nNo game " + conn.typed;
+        enqueue(conn, std::make_shared<const std::string>(reply + CHOOSE_PROMPT));
+        conn.typed.clear();
+        return;
+    }
+    Connection& player = found->second;
+    conn.role = Role::SPECTATOR;
+    conn.watching = game;
+    conn.typed.clear();
+    player.spectators.push_back(id);
+    enqueue(conn, keyframeOf(player));
+    ++loop.stats.spectators;
+    ++loop.stats.keyframes;
+}
+
+void GameServer::takeHandoffs(EventLoop& loop) {
+    std::vector<Handoff> handoffs;
+    {
+        std::lock_guard<std::mutex> lock(loop.handoffMutex);
+        handoffs.swap(loop.handoffs);
+    }
+    for (const Handoff& handoff : handoffs) {
+        std::uint64_t id = addConnection(loop, handoff.fd, Role::CHOOSING);
+        Connection& conn = loop.connections[id];
+        conn.typed = std::to_string(handoff.game);
+        watch(loop, id, handoff.game);
+        if (!flushOutput(loop, conn)) {
+            closeConnection(loop, id);
+            continue;
+        }
+        updateInterest(loop, id, conn);
+    }
+}
+
+void GameServer::publish(EventLoop& loop, Connection& player) {
+    std::string& output = player.session->getOutput();
+    if (output.empty()) {
+        return;
+    }
+    // Encoded once; the player and every spectator queue the same bytes
+    Frame frame = std::make_shared<const std::string>(std::move(output));
+    output.clear();
+    player.keyframe.reset();
+    enqueue(player, frame);
+
+    for (std::uint64_t viewerId : player.spectators) {
+        Connection& viewer = loop.connections[viewerId];
+        bool idle = viewer.queuedBytes == 0 && !viewer.needsKeyframe;
+        if (viewer.needsKeyframe) {
+            ++loop.stats.framesSkipped;
+        } else if (viewer.queuedBytes + frame->size() > options.maxSpectatorLag) {
+            // Too far behind: finish only the frame on the wire, then resync from a keyframe
+            std::size_t keep = viewer.head + (viewer.sent > 0 ? 1 : 0);
+            loop.stats.framesSkipped += viewer.queue.size() - keep + 1;
+            viewer.queue.erase(viewer.queue.begin() + static_cast<std::ptrdiff_t>(keep), viewer.queue.end());
+            viewer.queuedBytes = keep > viewer.head ? viewer.queue[viewer.head]->size() - viewer.sent : 0;
+            viewer.needsKeyframe = true;
+        } else {
+            enqueue(viewer, frame);
+            ++loop.stats.framesShared;
+        }
+        if (idle) {
+            loop.viewersToFlush.push_back(viewerId);
+        }
+    }
+}
+
+void GameServer::flushViewers(EventLoop& loop) {
+    // One send per viewer per wakeup, however many frames its game made meanwhile
+    for (std::uint64_t id : loop.viewersToFlush) {
+        auto found = loop.connections.find(id);
+        if (found == loop.connections.end() || found->second.role != Role::SPECTATOR) {
+            continue;
+        }
+        if (!flushSpectator(loop, found->second)) {
+            closeConnection(loop, id);
+            continue;
+        }
+        updateInterest(loop, id, found->second);
+    }
+    loop.viewersToFlush.clear();
+}
+
+Frame GameServer::keyframeOf(Connection& player) {
+    if (!player.keyframe) {
+        player.keyframe = std::make_shared<const std::string>(player.session->keyframe());
+    }
+    return player.keyframe;
+}
+
+void GameServer::enqueue(Connection& conn, Frame frame) {
+    if (frame->empty()) {
+        return;
+    }
+    if (conn.head > 32 && conn.head * 2 > conn.queue.size()) {
+        conn.queue.erase(conn.queue.begin(), conn.queue.begin() + static_cast<std::ptrdiff_t>(conn.head));
+        conn.head = 0;
+    }
+    conn.queuedBytes += frame->size();
+    conn.queue.push_back(std::move(frame));
+}
+
+bool GameServer::flushOutput(EventLoop& loop, Connection& conn) {
+    while (conn.head < conn.queue.size()) {
+        // Every queued frame in one call, straight from the shared buffers
+        iovec parts[MAX_IOVECS];
+        int count = 0;
+        for (std::size_t i = conn.head; i < conn.queue.size() && count < MAX_IOVECS; ++i, ++count) {
+            std::size_t skip = i == conn.head ? conn.sent : 0;
+            parts[count].iov_base = const_cast<char*>(conn.queue[i]->data() + skip);
+            parts[count].iov_len = conn.queue[i]->size() - skip;
+        }
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = static_cast<std::size_t>(count);
+        ssize_t wrote = ::sendmsg(conn.fd, &message, MSG_NOSIGNAL);
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else if (wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else if (wrote <= 0) {
+            return false;
+        }
+
+        std::size_t left = static_cast<std::size_t>(wrote);
+        conn.queuedBytes -= left;
+        loop.stats.bytesSent += left;
+        while (left > 0) {
+            std::size_t rest = conn.queue[conn.head]->size() - conn.sent;
+            if (left < rest) {
+                conn.sent += left;
+                break;
+            }
+            left -= rest;
+            conn.queue[conn.head++].reset();
+            conn.sent = 0;
+        }
+    }
+    conn.queue.clear();
+    conn.head = 0;
+    return true;
+}
+
+bool GameServer::flushSpectator(EventLoop& loop, Connection& conn) {
+    if (!flushOutput(loop, conn)) {
+        return false;
+    }
+    if (!conn.needsKeyframe || conn.queuedBytes > 0) {
+        return true;
+    }
+    // Caught up after skipping frames: start again from the whole screen
+    conn.needsKeyframe = false;
+    auto player = loop.connections.find(conn.watching);
+    if (player == loop.connections.end()) {
+        return true;
+    }
+    enqueue(conn, keyframeOf(player->second));
+    ++loop.stats.keyframes;
+    return flushOutput(loop, conn);
+}
+
+void GameServer::updateInterest(EventLoop& loop, std::uint64_t id, Connection& conn) {
+    std::size_t pending = conn.queuedBytes;
+    bool playing = conn.role == Role::PLAYER && !conn.session->isFinished();
+    bool reading = conn.role == Role::PLAYER ? playing && pending < options.maxOutputBytes : !conn.closing;
+    std::uint32_t events = (reading ? READ_EVENTS : 0) | (pending > 0 ? WRITE_EVENTS : 0);
+    if (events == conn.events) {
+        return;
+    }
+    if (!reading && (conn.events & READ_EVENTS) && playing) {
+        ++loop.stats.pauses;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = id;
+    ::epoll_ctl(loop.epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+    conn.events = events;
+}
+
+void GameServer::closeConnection(EventLoop& loop, std::uint64_t id) {
+    auto found = loop.connections.find(id);
+    if (found == loop.connections.end()) {
+        return;
+    }
+    Connection& conn = found->second;
+    if (conn.session) {
+        loop.stats.keys += conn.session->getKeys();
+        loop.stats.frames += conn.session->getFrames();
+    }
+    if (conn.role == Role::SPECTATOR) {
+        auto player = loop.connections.find(conn.watching);
+        if (player != loop.connections.end()) {
+            std::vector<std::uint64_t>& viewers = player->second.spectators;
+            viewers.erase(std::remove(viewers.begin(), viewers.end(), id), viewers.end());
+        }
+    }
+    std::vector<std::uint64_t> viewers = std::move(conn.spectators);
+    ::close(conn.fd); // Also drops it from the epoll set
+    loop.connections.erase(found);
+    --openSessions;
+
+    if (viewers.empty()) {
+        return;
+    }
+    Frame ended = std::make_shared<const std::string>(GAME_ENDED);
+    for (std::uint64_t viewerId : viewers) {
+        Connection& viewer = loop.connections[viewerId];
+        viewer.watching = 0;
+        viewer.needsKeyframe = false;
+        viewer.closing = true;
+        enqueue(viewer, ended);
+        if (!flushOutput(loop, viewer) || viewer.queuedBytes == 0) {
+            closeConnection(loop, viewerId);
+        } else {
+            updateInterest(loop, viewerId, viewer);
+        }
+    }
+}
+
+void GameServer::appendFinishedRuns(EventLoop& loop) {
+    if (loop.finishedRuns.empty()) {
+        return;
+    }
+    // One write and one fdatasync for every run that ended during this wakeup
+    std::lock_guard<std::mutex> lock(runLogMutex);
+    try {
+        runLog->append(loop.finishedRuns);
+        if (runLogFailing) {
+            std::cerr << "Run log " << options.runLogFile << " is being written again" << std::endl;
+            runLogFailing = false;
+        }
+    } catch (const std::exception& e) {
+        // A full or failing disk costs the records, never the games; reported once per outage
+        loop.stats.runsNotLogged += loop.finishedRuns.size();
+        if (!runLogFailing) {
+            std::cerr << "Run log write failed, finished runs are not being recorded: " << e.what() << std::endl;
+            runLogFailing = true;
+        }
+    }
+    loop.finishedRuns.clear();
+}
+
+void GameServer::closeLoop(EventLoop& loop) {
+    while (!loop.connections.empty()) {
+        closeConnection(loop, loop.connections.begin()->first);
+    }
+    for (const Handoff& handoff : loop.handoffs) {
+        ::close(handoff.fd);
+    }
+    loop.handoffs.clear();
+    for (int* fd : {&loop.listenFd, &loop.spectateFd, &loop.epollFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+} // namespace MulaWee
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "ansi_renderer.hpp"
+#include "camera.hpp"
+#include "game_core.hpp"
+#include "run_log.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MulaWee {
+
+// One player's game over a byte stream. Keys go in as raw bytes (telnet commands are
+// dropped) and the screen comes out as ANSI escape sequences through a DiffRenderer,
+// so every batch of keys costs only the cells it changed. Nothing blocks: the state
+// machine of Game is kept here as data, around a GameSession on shared levels.
+class ServerSession {
+private:
+    std::uint64_t gameId;  // Shown on screen; spectators pick the game by it
+    GameSession session;
+    AnsiRenderer* screen; // Owned by renderer
+    DiffRenderer renderer;
+    Camera camera;
+    std::string typedName;
+    int telnetState;       // Position inside a telnet command being skipped
+    bool finished;         // Quit; close once the output is sent
+    bool runFinished;      // A run ended since takeFinishedRun
+    std::size_t keys;
+    std::size_t frames;
+
+    // What one batch of keys changed while playing
+    struct KeyBatch {
+        Position start;
+        int lastKey = 0;
+        bool lastKeyValid = true;
+        bool moved = false;
+        bool blocked = false;
+    };
+
+public:
+    static constexpr int SCREEN_ROWS = 24;
+    static constexpr int SCREEN_COLS = 80;
+    static constexpr std::size_t MAX_NAME = 10;
+
+    ServerSession(const std::vector<std::shared_ptr<const Level>>& levels, std::uint64_t id);
+
+    ServerSession(const ServerSession&) = delete;
+    ServerSession& operator=(const ServerSession&) = delete;
+
+    // Reset the terminal and show the name prompt
+    void start();
+
+    // Apply every key in `data` in order, then draw the result once
+    void handleInput(const std::uint8_t* data, std::size_t size);
+
+    // Encoded frames not yet sent
+    std::string& getOutput() { return screen->getOutput(); }
+
+    // The whole current screen from a cleared terminal, for a viewer joining late. The
+    // frames after it no longer rely on the cursor and color the previous ones left.
+    std::string keyframe();
+
+    bool isFinished() const { return finished; }
+
+    // The run that just ended, once; false if none did
+    bool takeFinishedRun(RunRecord& run);
+
+    std::size_t getKeys() const { return keys; }
+    std::size_t getFrames() const { return frames; }
+
+private:
+    int filterTelnet(std::uint8_t byte);
+    void handleKey(int ch, KeyBatch& batch);
+    void renderBatch(const KeyBatch& batch);
+
+    void drawWelcome();
+    void drawNamePrompt();
+    void drawGame();
+    void drawBoard();
+    void drawPlayer();
+    void drawStatus();
+    void drawLevelComplete();
+    void drawWinner();
+};
+
+// Encoded output shared by the player and every spectator of a game; sent by reference
+using Frame = std::shared_ptr<const std::string>;
+
+struct GameServerOptions {
+    std::string host = "127.0.0.1";
+    int port = 7777;
+    int spectatePort = 7778;                // Spectators connect here (0 = no spectating)
+    unsigned threads = 1;                   // Event loops, each on its own SO_REUSEPORT listener
+    std::size_t maxSessions = 20000;        // Per event loop
+    std::size_t maxOutputBytes = 64 * 1024; // Unsent frames before a session stops being read
+    std::size_t maxSpectatorLag = 64 * 1024; // Unsent frames before a spectator skips to a keyframe
+    std::string runLogFile;                 // Finished runs are appended here if set
+};
+
+struct GameServerStats {
+    std::size_t sessions = 0;     // Accepted over the server's lifetime
+    std::size_t refused = 0;      // Closed at once because maxSessions were open
+    std::size_t peakSessions = 0; // Most open at once (summed over loops)
+    std::size_t keys = 0;
+    std::size_t frames = 0;       // Screen updates encoded
+    std::uint64_t bytesSent = 0;
+    std::size_t runs = 0;         // Runs played to the end
+    std::size_t runsNotLogged = 0; // Finished runs the run log failed to store
+    std::size_t pauses = 0;       // Times a session stopped being read for unsent output
+    std::size_t spectators = 0;   // Spectator connections accepted
+    std::size_t framesShared = 0; // Frames queued to spectators (by reference)
+    std::size_t framesSkipped = 0; // Frames a lagging spectator never got
+    std::size_t keyframes = 0;    // Sent to spectators joining or catching up
+};
+
+// Multi-session game server on TCP. Each event loop owns a listening socket (the kernel
+// spreads connections across them), an epoll set and its sessions, so loops share
+// nothing but the read-only levels and the run log. A session costs its GameSession
+// and two screen buffers; an idle one uses no CPU. A client that stops reading has
+// its keys left in the kernel once maxOutputBytes of frames are waiting for it.
+//
+// Spectators connect to spectatePort and type a game number. They are handed to the
+// loop that runs that game, and each frame the game produces is encoded once into a
+// Frame that the player's and every spectator's send queue point at. A spectator more
+// than maxSpectatorLag behind drops its queued frames and, once its socket drains,
+// gets a fresh keyframe of the whole screen, so the player never waits for it.
+class GameServer {
+private:
+    enum class Role { PLAYER, CHOOSING, SPECTATOR };
+
+    struct Connection {
+        int fd = -1;
+        std::uint32_t events = 0;
+        Role role = Role::PLAYER;
+        std::unique_ptr<ServerSession> session; // Players
+        std::vector<Frame> queue;               // Frames to send, from queue[head]
+        std::size_t head = 0;
+        std::size_t sent = 0;                   // Bytes of queue[head] already sent
+        std::size_t queuedBytes = 0;            // Unsent bytes in the queue
+        std::vector<std::uint64_t> spectators;  // Players: who is watching
+        std::uint64_t watching = 0;             // Spectators: the player's connection id
+        bool needsKeyframe = false;             // Spectators: skipped frames, resync when drained
+        std::string typed;                      // Choosing: game number so far
+        Frame keyframe;                         // Players: cached until the next frame
+        bool peerClosed = false;
+        bool closing = false;                   // Close once the queue is sent
+    };
+
+    // A spectator moving to the loop that runs the game it picked
+    struct Handoff {
+        int fd;
+        std::uint64_t game;
+    };
+
+    struct EventLoop {
+        unsigned index = 0;
+        int listenFd = -1;
+        int spectateFd = -1;
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::unordered_map<std::uint64_t, Connection> connections;
+        std::uint64_t nextConnection = 0;
+        std::vector<RunRecord> finishedRuns; // Appended once per wakeup
+        std::mutex handoffMutex;
+        std::vector<Handoff> handoffs;       // Filled by other loops
+        std::vector<std::uint64_t> viewersToFlush; // Got frames this wakeup; sent after the players
+        GameServerStats stats;
+    };
+
+    GameServerOptions options;
+    std::vector<std::shared_ptr<const Level>> levels;
+    std::unique_ptr<RunLog> runLog; // Null without runLogFile
+    std::mutex runLogMutex;
+    bool runLogFailing;             // The last append failed (guarded by runLogMutex)
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    std::atomic<bool> stopping;
+    std::atomic<std::size_t> openSessions;
+    std::mutex errorMutex;
+    std::exception_ptr loopError;   // First failure of any loop; stops the others
+    GameServerStats stats;
+
+public:
+    GameServer(const std::vector<std::shared_ptr<const Level>>& gameLevels, const GameServerOptions& serverOptions);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Bind every loop's listener, then serve until stop()
+    void run();
+
+    // Async-signal-safe
+    void stop();
+
+    // Totals over all loops (valid after run() returns)
+    const GameServerStats& getStats() const { return stats; }
+
+private:
+    static int openListener(const std::string& host, int port);
+    void openLoop(EventLoop& loop);
+    void runLoop(EventLoop& loop);
+    std::uint64_t addConnection(EventLoop& loop, int fd, Role role);
+    void acceptConnections(EventLoop& loop, int listenFd, Role role);
+    void handleEvents(EventLoop& loop, std::uint64_t id, std::uint32_t events);
+    void handlePlayerInput(EventLoop& loop, Connection& conn, const std::uint8_t* data, std::size_t size);
+    void handleChoice(EventLoop& loop, std::uint64_t id, Connection& conn, const std::uint8_t* data,
+                      std::size_t size);
+    void watch(EventLoop& loop, std::uint64_t id, std::uint64_t game);
+    void takeHandoffs(EventLoop& loop);
+    void publish(EventLoop& loop, Connection& player);
+    void flushViewers(EventLoop& loop);
+    Frame keyframeOf(Connection& player);
+    static void enqueue(Connection& conn, Frame frame);
+    bool flushOutput(EventLoop& loop, Connection& conn);
+    bool flushSpectator(EventLoop& loop, Connection& conn);
+    void updateInterest(EventLoop& loop, std::uint64_t id, Connection& conn);
+    void closeConnection(EventLoop& loop, std::uint64_t id);
+    void appendFinishedRuns(EventLoop& loop);
+    void closeLoop(EventLoop& loop);
+};
+
+} // namespace MulaWee
@@ -0,0 +1,64 @@
+#include "maze_generator.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// Maze generator - writes seeded levels in text (.dat) or compiled (.mwl) form
+//
+//   mulavee_genmaze [--algorithm backtracker|wilson|eller] [--rows N] [--cols N]
+//                   [--seed S] [--threads N] -o OUTPUT
+//
+// Sizes count maze cells; the level grid is (2N + 1) on each axis. Eller streams rows
+// to the output, so its memory stays flat however tall the maze is. Text output needs
+// at least 9 rows, since .dat files always start at (17, 1). Every level is checked
+// with LevelValidator before it replaces the output.
+
+int main(int argc, char* argv[]) {
+    MulaWee::MazeSpec spec;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--algorithm") == 0 && hasValue &&
+            MulaWee::parseMazeAlgorithm(argv[i + 1], spec.algorithm)) {
+            ++i;
+        } else if (std::strcmp(argv[i], "--rows") == 0 && hasValue) {
+            spec.cellRows = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cols") == 0 && hasValue) {
+            spec.cellCols = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            spec.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            output = argv[++i];
+        } else {
+            output.clear();
+            break;
+        }
+    }
+
+    if (output.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--algorithm backtracker|wilson|eller]"
+                  << " [--rows N] [--cols N] [--seed S] [--threads N] -o OUTPUT" << std::endl;
+        return 2;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        MulaWee::writeMaze(spec, output);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cerr << output << ": " << MulaWee::mazeAlgorithmName(spec.algorithm) << " "
+                  << spec.gridRows() << "x" << spec.gridCols() << " seed " << spec.seed
+                  << " in " << std::fixed << std::setprecision(3) << elapsed.count() << " s"
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
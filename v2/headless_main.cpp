@@ -0,0 +1,147 @@
+#include "optimized_game.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+// Headless driver - runs the game with no terminal
+//
+//   mulavee_headless [--data DIR | --pack FILE | --embedded] [--name NAME] [--runs FILE] [--no-coalesce]
+//                    [--latency FILE] [--replays DIR] KEYS|-
+//       Play the full game (menus included) from a scripted key string
+//   mulavee_headless [--data DIR] --bench MOVES
+//       Measure raw GameSession move throughput with random moves
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--data DIR | --pack FILE | --embedded] [--name NAME] [--runs FILE] [--no-coalesce]"
+              << " [--latency FILE] [--replays DIR] KEYS|-\n"
+              << "       " << program << " [--data DIR] --bench MOVES" << std::endl;
+}
+
+const char* stateName(MulaWee::GameState state) {
+    switch (state) {
+        case MulaWee::GameState::MENU: return "menu";
+        case MulaWee::GameState::PLAYING: return "playing";
+        case MulaWee::GameState::LEVEL_COMPLETE: return "level-complete";
+        case MulaWee::GameState::GAME_OVER: return "game-over";
+        case MulaWee::GameState::WINNER: return "winner";
+        case MulaWee::GameState::QUIT: return "quit";
+    }
+    return "unknown";
+}
+
+int runScript(const MulaWee::GameOptions& options, const std::string& keys, const std::string& name) {
+    auto input = std::make_unique<MulaWee::ScriptedInput>(keys, name);
+    MulaWee::ScriptedInput* script = input.get();
+
+    MulaWee::Game game(std::make_unique<MulaWee::NullRenderer>(), std::move(input), options);
+    game.run();
+
+    const MulaWee::GameSession* session = game.getSession();
+    if (!session) {
+        return 1;
+    }
+
+    std::cout << "keys: " << script->getKeysConsumed() << "/" << keys.size()
+              << "\nlevel: " << session->getCurrentLevel() + 1
+              << "\nmoves: " << session->getPlayer().getMoveCount()
+              << "\nscore: " << session->getScoreManager().getCurrentScore()
+              << "\nstate: " << stateName(session->getState())
+              << "\nkeys/refresh: " << game.getInputStats().keysPerRefresh() << std::endl;
+    return 0;
+}
+
+int runBenchmark(const MulaWee::GameOptions& options, long long moves) {
+    std::vector<std::shared_ptr<const MulaWee::Level>> levels;
+    for (int i = 1; i <= 3; ++i) {
+        levels.push_back(std::make_shared<const MulaWee::Level>(
+            options.dataDir + "/level" + std::to_string(i) + ".dat"));
+    }
+
+    MulaWee::GameSession session(levels, options.runLogFile);
+    session.begin("bench");
+
+    std::uint32_t rng = 2463534242u;
+    long long goals = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < moves; ++i) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if (session.move(static_cast<MulaWee::Direction>(rng & 3)) == MulaWee::MoveResult::GOAL_REACHED) {
+            ++goals;
+            session.completeLevel();
+            if (session.getState() == MulaWee::GameState::WINNER) {
+                session.begin("bench");
+            }
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << moves << " moves in " << elapsed.count() << " s ("
+              << static_cast<long long>(moves / elapsed.count()) << " moves/s), "
+              << goals << " goals reached" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    MulaWee::GameOptions options;
+    options.runLogFile = ""; // Never touch the real run log unless asked
+    std::string name = "Headless";
+    std::string keys;
+    long long benchMoves = 0;
+    bool haveKeys = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            options.dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--pack") == 0 && hasValue) {
+            options.levelPack = argv[++i];
+        } else if (std::strcmp(argv[i], "--embedded") == 0) {
+            options.embeddedLevels = true;
+        } else if (std::strcmp(argv[i], "--name") == 0 && hasValue) {
+            name = argv[++i];
+        } else if (std::strcmp(argv[i], "--runs") == 0 && hasValue) {
+            options.runLogFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--replays") == 0 && hasValue) {
+            options.replayDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--latency") == 0 && hasValue) {
+            options.latencyFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-coalesce") == 0) {
+            options.coalesceInput = false;
+        } else if (std::strcmp(argv[i], "--bench") == 0 && hasValue) {
+            benchMoves = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "-") == 0) {
+            keys.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+            haveKeys = true;
+        } else if (argv[i][0] != '-') {
+            keys = argv[i];
+            haveKeys = true;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        if (benchMoves > 0) {
+            return runBenchmark(options, benchMoves);
+        }
+        if (!haveKeys) {
+            printUsage(argv[0]);
+            return 2;
+        }
+        return runScript(options, keys, name);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,388 @@
+#include "hierarchical_solver.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+// HierarchicalSolver class implementation
+
+namespace MulaWee {
+
+constexpr std::uint32_t HierarchicalSolver::NONE;
+constexpr std::uint16_t HierarchicalSolver::FAR;
+constexpr int HierarchicalSolver::ROW_STEP[4];
+constexpr int HierarchicalSolver::COL_STEP[4];
+constexpr int HierarchicalSolver::DEFAULT_CLUSTER_SIZE;
+
+namespace {
+
+// Runs of open border pairs at least this long get an entrance at each end
+constexpr int LONG_RUN = 6;
+
+} // namespace
+
+HierarchicalSolver::HierarchicalSolver(const Level& level, int clusterEdge)
+    : rows(level.getRows()), cols(level.getCols()), clusterSize(clusterEdge), clusterRows(0), clusterCols(0),
+      localTop(0), localLeft(0), localWidth(0), generation(0) {
+    // Distances inside a cluster must fit in 16 bits
+    if (clusterEdge < 4 || clusterEdge > 255) {
+        throw GameException("Cluster size must be 4..255, not " + std::to_string(clusterEdge));
+    }
+    if (static_cast<std::size_t>(rows) * cols >= NONE) {
+        throw GameException("Level too large for HierarchicalSolver: " + level.getFilename());
+    }
+    clusterRows = (rows + clusterSize - 1) / clusterSize;
+    clusterCols = (cols + clusterSize - 1) / clusterSize;
+    clusters.resize(static_cast<std::size_t>(clusterRows) * clusterCols);
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        buildCluster(level, static_cast<int>(c));
+    }
+    numberNodes();
+}
+
+int HierarchicalSolver::neighbourCluster(int cluster, int side) const {
+    int r = cluster / clusterCols + ROW_STEP[side];
+    int c = cluster % clusterCols + COL_STEP[side];
+    return r < 0 || r >= clusterRows || c < 0 || c >= clusterCols ? -1 : r * clusterCols + c;
+}
+
+void HierarchicalSolver::entrances(const Level& level, int cluster, int side, std::vector<std::uint32_t>& cells) const {
+    if (neighbourCluster(cluster, side) < 0) {
+        return;
+    }
+    const int top = cluster / clusterCols * clusterSize;
+    const int left = cluster % clusterCols * clusterSize;
+    const int bottom = std::min(rows, top + clusterSize);
+    const int right = std::min(cols, left + clusterSize);
+
+    // The border is a row pair (UP, DOWN) or a column pair (LEFT, RIGHT); both
+    // clusters walk it in the same order, so their entrances pair up by position
+    const bool acrossRows = side == static_cast<int>(Direction::UP) || side == static_cast<int>(Direction::DOWN);
+    const int inner = side == static_cast<int>(Direction::UP) ? top
+                    : side == static_cast<int>(Direction::DOWN) ? bottom - 1
+                    : side == static_cast<int>(Direction::LEFT) ? left : right - 1;
+    const int outer = inner + ROW_STEP[side] + COL_STEP[side];
+    const int end = acrossRows ? right : bottom;
+    auto cellAt = [&](int line, int p) {
+        return acrossRows ? static_cast<std::uint32_t>(line) * cols + p : static_cast<std::uint32_t>(p) * cols + line;
+    };
+    auto passable = [&](int p) { return isOpen(level, cellAt(inner, p)) && isOpen(level, cellAt(outer, p)); };
+
+    for (int p = acrossRows ? left : top; p < end;) {
+        if (!passable(p)) {
+            ++p;
+            continue;
+        }
+        int runStart = p;
+        while (p < end && passable(p)) {
+            ++p;
+        }
+        int length = p - runStart;
+        if (length >= LONG_RUN) {
+            cells.push_back(cellAt(inner, runStart));
+            cells.push_back(cellAt(inner, p - 1));
+        } else {
+            cells.push_back(cellAt(inner, runStart + (length - 1) / 2));
+        }
+    }
+}
+
+void HierarchicalSolver::buildCluster(const Level& level, int cluster) {
+    Cluster& built = clusters[cluster];
+    built.nodes.clear();
+    for (int side = 0; side < 4; ++side) {
+        built.sideStart[side] = static_cast<std::uint16_t>(built.nodes.size());
+        entrances(level, cluster, side, built.nodes);
+    }
+    const std::size_t count = built.nodes.size();
+    built.sideStart[4] = static_cast<std::uint16_t>(count);
+    built.nodes.shrink_to_fit();
+
+    built.distance.assign(count * count, FAR);
+    built.distance.shrink_to_fit();
+    built.deadEnd.assign(count, 1);
+    built.deadEnd.shrink_to_fit();
+    if (count == 0) {
+        return;
+    }
+    loadCluster(level, cluster);
+    for (std::size_t i = 0; i < count; ++i) {
+        searchLocal(built.nodes[i], NONE);
+        for (std::size_t j = 0; j < count; ++j) {
+            built.distance[i * count + j] = localDistance[toLocal(built.nodes[j])];
+            if (j != i && built.distance[i * count + j] != FAR) {
+                built.deadEnd[i] = 0;
+            }
+        }
+    }
+}
+
+void HierarchicalSolver::numberNodes() {
+    nodeBase.resize(clusters.size() + 1);
+    nodeCluster.clear();
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        nodeBase[c] = static_cast<std::uint32_t>(nodeCluster.size());
+        nodeCluster.insert(nodeCluster.end(), clusters[c].nodes.size(), static_cast<std::uint32_t>(c));
+    }
+    nodeBase[clusters.size()] = static_cast<std::uint32_t>(nodeCluster.size());
+    stamp.assign(nodeCluster.size(), 0);
+    bestG.resize(nodeCluster.size());
+    parent.resize(nodeCluster.size());
+}
+
+void HierarchicalSolver::loadCluster(const Level& level, int cluster) {
+    localTop = cluster / clusterCols * clusterSize;
+    localLeft = cluster % clusterCols * clusterSize;
+    const int height = std::min(clusterSize, rows - localTop);
+    const int width = std::min(clusterSize, cols - localLeft);
+    localWidth = width + 2;
+
+    const std::size_t size = static_cast<std::size_t>(height + 2) * localWidth;
+    localOpen.assign(size, 0);
+    localDistance.resize(size);
+    localVia.resize(size);
+    localQueue.resize(size);
+    for (int r = 0; r < height; ++r) {
+        std::uint32_t cell = static_cast<std::uint32_t>(localTop + r) * cols + localLeft;
+        std::uint8_t* row = &localOpen[static_cast<std::size_t>(r + 1) * localWidth + 1];
+        for (int c = 0; c < width; ++c) {
+            row[c] = isOpen(level, cell + c);
+        }
+    }
+}
+
+std::size_t HierarchicalSolver::searchLocal(std::uint32_t from, std::uint32_t to) {
+    const int step[4] = {-localWidth, localWidth, -1, 1};
+    std::fill(localDistance.begin(), localDistance.end(), FAR);
+    std::uint32_t start = toLocal(from);
+    const std::uint32_t stop = to == NONE ? NONE : toLocal(to);
+    localDistance[start] = 0;
+    localQueue[0] = start;
+
+    std::size_t head = 0, tail = 1;
+    while (head < tail) {
+        std::uint32_t cell = localQueue[head++];
+        if (cell == stop) {
+            break;
+        }
+        for (int dir = 0; dir < 4; ++dir) {
+            std::uint32_t next = cell + step[dir];
+            if (localOpen[next] && localDistance[next] == FAR) {
+                localDistance[next] = static_cast<std::uint16_t>(localDistance[cell] + 1);
+                localVia[next] = static_cast<std::uint8_t>(dir);
+                localQueue[tail++] = next;
+            }
+        }
+    }
+    return head;
+}
+
+void HierarchicalSolver::traceLocal(std::uint32_t from, std::uint32_t to, std::vector<Position>& out) {
+    const int step[4] = {-localWidth, localWidth, -1, 1};
+    const std::size_t first = out.size();
+    const std::uint32_t origin = toLocal(from);
+    for (std::uint32_t cell = toLocal(to); cell != origin; cell -= step[localVia[cell]]) {
+        out.push_back(Position(static_cast<int>(cell) / localWidth - 1 + localTop,
+                               static_cast<int>(cell) % localWidth - 1 + localLeft));
+    }
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+}
+
+void HierarchicalSolver::refine(const Level& level, std::uint32_t from, std::uint32_t to, std::vector<Position>& out,
+                                std::size_t& expanded) {
+    if (from == to) {
+        return;
+    }
+    loadCluster(level, clusterOf(from));
+    expanded += searchLocal(from, to);
+    traceLocal(from, to, out);
+}
+
+void HierarchicalSolver::relax(std::uint32_t node, std::uint32_t g, std::uint32_t from, const Position& goal) {
+    if (stamp[node] == generation && bestG[node] <= g) {
+        return;
+    }
+    stamp[node] = generation;
+    bestG[node] = g;
+    parent[node] = from;
+
+    const Cluster& cluster = clusters[nodeCluster[node]];
+    std::uint32_t cell = cluster.nodes[node - nodeBase[nodeCluster[node]]];
+    std::uint32_t h = static_cast<std::uint32_t>(std::abs(static_cast<int>(cell / cols) - goal.row) +
+                                                 std::abs(static_cast<int>(cell % cols) - goal.col));
+    heap.push_back(HeapNode{g + h, g, node});
+    std::push_heap(heap.begin(), heap.end(), HeapOrder());
+}
+
+void HierarchicalSolver::checkLevel(const Level& level) const {
+    if (level.getRows() != rows || level.getCols() != cols) {
+        throw GameException("HierarchicalSolver was built for another level than " + level.getFilename());
+    }
+}
+
+SolveResult HierarchicalSolver::solve(const Level& level) {
+    return solve(level, level.getStartPosition(), level.getGoalPosition());
+}
+
+SolveResult HierarchicalSolver::solve(const Level& level, const Position& start, const Position& goal) {
+    checkLevel(level);
+    SolveResult result;
+    if (!level.canMoveTo(start) || !level.canMoveTo(goal)) {
+        return result;
+    }
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * cols + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * cols + goal.col;
+    result.path.push_back(start);
+    if (source == target) {
+        result.found = true;
+        return result;
+    }
+
+    // Join the goal, then the start, to the nodes of their clusters; moves are
+    // reversible, so a search from the goal gives the distances to it
+    const int goalCluster = clusterOf(target);
+    const int startCluster = clusterOf(source);
+    const Cluster& last = clusters[goalCluster];
+    loadCluster(level, goalCluster);
+    result.expanded += searchLocal(target, NONE);
+    goalDistance.resize(last.nodes.size());
+    for (std::size_t i = 0; i < last.nodes.size(); ++i) {
+        goalDistance[i] = localDistance[toLocal(last.nodes[i])];
+    }
+
+    const Cluster& first = clusters[startCluster];
+    loadCluster(level, startCluster);
+    result.expanded += searchLocal(source, NONE);
+    std::uint32_t best = NONE;
+    if (startCluster == goalCluster && localDistance[toLocal(target)] != FAR) {
+        best = localDistance[toLocal(target)];
+    }
+
+    if (generation == std::numeric_limits<std::uint32_t>::max()) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 0;
+    }
+    ++generation;
+    heap.clear();
+    for (std::size_t i = 0; i < first.nodes.size(); ++i) {
+        std::uint16_t distance = localDistance[toLocal(first.nodes[i])];
+        if (distance != FAR) {
+            relax(nodeBase[startCluster] + static_cast<std::uint32_t>(i), distance, NONE, goal);
+        }
+    }
+
+    std::uint32_t exit = NONE; // Goal-cluster node the best route leaves the graph at
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), HeapOrder());
+        HeapNode top = heap.back();
+        heap.pop_back();
+        if (top.g != bestG[top.node]) {
+            continue;
+        }
+        if (top.f >= best) {
+            break;
+        }
+        ++result.expanded;
+
+        const std::uint32_t c = nodeCluster[top.node];
+        const Cluster& cluster = clusters[c];
+        const std::size_t count = cluster.nodes.size();
+        const std::size_t i = top.node - nodeBase[c];
+        if (static_cast<int>(c) == goalCluster && goalDistance[i] != FAR && top.g + goalDistance[i] < best) {
+            best = top.g + goalDistance[i];
+            exit = top.node;
+        }
+
+        const std::uint16_t* row = &cluster.distance[i * count];
+        for (std::size_t j = 0; j < count; ++j) {
+            if (j != i && row[j] != FAR) {
+                relax(nodeBase[c] + static_cast<std::uint32_t>(j), top.g + row[j], top.node, goal);
+            }
+        }
+        int side = 0;
+        while (i >= cluster.sideStart[side + 1]) {
+            ++side;
+        }
+        int across = neighbourCluster(static_cast<int>(c), side);
+        // Sides pair up as UP/DOWN and LEFT/RIGHT, so ^ 1 is the facing side
+        std::uint32_t k = clusters[across].sideStart[side ^ 1] + static_cast<std::uint32_t>(i - cluster.sideStart[side]);
+        // An entrance that reaches no other inside its cluster only matters there
+        if (!clusters[across].deadEnd[k] || across == goalCluster) {
+            relax(nodeBase[across] + k, top.g + 1, top.node, goal);
+        }
+    }
+
+    if (best == NONE) {
+        result.path.clear();
+        return result;
+    }
+    if (exit == NONE) {
+        traceLocal(source, target, result.path); // Still loaded from the start's search
+    } else {
+        // Only the clusters on the route are searched again, cell by cell
+        std::vector<std::uint32_t> route;
+        for (std::uint32_t node = exit; node != NONE; node = parent[node]) {
+            route.push_back(node);
+        }
+        std::reverse(route.begin(), route.end());
+        auto cellOf = [this](std::uint32_t node) {
+            return clusters[nodeCluster[node]].nodes[node - nodeBase[nodeCluster[node]]];
+        };
+
+        refine(level, source, cellOf(route.front()), result.path, result.expanded);
+        for (std::size_t k = 1; k < route.size(); ++k) {
+            if (nodeCluster[route[k]] == nodeCluster[route[k - 1]]) {
+                refine(level, cellOf(route[k - 1]), cellOf(route[k]), result.path, result.expanded);
+            } else {
+                result.path.push_back(toPosition(cellOf(route[k])));
+            }
+        }
+        refine(level, cellOf(exit), target, result.path, result.expanded);
+    }
+    result.found = true;
+    return result;
+}
+
+std::size_t HierarchicalSolver::update(const Level& level, const Position& first, const Position& last) {
+    checkLevel(level);
+    // One cell of margin reaches across any border a changed cell lies on
+    const int top = std::max(0, std::min(first.row, last.row) - 1);
+    const int bottom = std::min(rows - 1, std::max(first.row, last.row) + 1);
+    const int left = std::max(0, std::min(first.col, last.col) - 1);
+    const int right = std::min(cols - 1, std::max(first.col, last.col) + 1);
+
+    std::size_t rebuilt = 0;
+    for (int r = top / clusterSize; r <= bottom / clusterSize; ++r) {
+        for (int c = left / clusterSize; c <= right / clusterSize; ++c) {
+            buildCluster(level, r * clusterCols + c);
+            ++rebuilt;
+        }
+    }
+    numberNodes();
+    return rebuilt;
+}
+
+std::size_t HierarchicalSolver::getEdgeCount() const {
+    std::size_t edges = nodeCluster.size(); // One across a border per node
+    for (const Cluster& cluster : clusters) {
+        const std::size_t count = cluster.nodes.size();
+        for (std::size_t k = 0; k < cluster.distance.size(); ++k) {
+            edges += cluster.distance[k] != FAR && k / count != k % count;
+        }
+    }
+    return edges;
+}
+
+std::size_t HierarchicalSolver::memoryUsage() const {
+    std::size_t bytes = clusters.capacity() * sizeof(Cluster);
+    for (const Cluster& cluster : clusters) {
+        bytes += cluster.nodes.capacity() * sizeof(std::uint32_t) + cluster.distance.capacity() * sizeof(std::uint16_t) +
+                 cluster.deadEnd.capacity();
+    }
+    return bytes +
+           (nodeBase.capacity() + nodeCluster.capacity() + stamp.capacity() + bestG.capacity() + parent.capacity() +
+            localQueue.capacity()) * sizeof(std::uint32_t) +
+           (localDistance.capacity() + goalDistance.capacity()) * sizeof(std::uint16_t) +
+           localOpen.capacity() + localVia.capacity() + heap.capacity() * sizeof(HeapNode);
+}
+
+} // namespace MulaWee
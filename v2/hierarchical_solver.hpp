@@ -0,0 +1,124 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "maze_solver.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MulaWee {
+
+// HPA* (hierarchical path-finding A*) for levels too big to search cell by cell on
+// every request. The grid is cut into square clusters. Where open cells face each
+// other across a cluster border, each run of them gets an entrance: one pair of
+// cells in the middle, or one at each end of a long run. Those cells are the
+// abstract graph's nodes. A node is joined to the facing node across the border
+// (one move) and to every node of its own cluster it can reach without leaving
+// the cluster, with the distance precomputed.
+//
+// A query connects the start and goal to the nodes of their clusters, runs A* on
+// the abstract graph, and then searches cell by cell only inside the clusters on
+// the chosen route. Routes stay inside clusters between entrances, so they can be
+// a little longer than the shortest one. Edits call update(), which rebuilds only
+// the clusters that can see the changed cells.
+class HierarchicalSolver {
+private:
+    struct Cluster {
+        std::vector<std::uint32_t> nodes;     // Cell of each node, grouped by side (UP, DOWN, LEFT, RIGHT)
+        std::uint16_t sideStart[5];           // First node of each side, then the end
+        std::vector<std::uint16_t> distance;  // nodes x nodes moves inside the cluster, or FAR
+        std::vector<std::uint8_t> deadEnd;    // Per node: no other node reachable inside the cluster
+    };
+
+    struct HeapNode {
+        std::uint32_t f;
+        std::uint32_t g;
+        std::uint32_t node;
+    };
+
+    struct HeapOrder {
+        bool operator()(const HeapNode& a, const HeapNode& b) const {
+            return a.f != b.f ? a.f > b.f : a.g < b.g;
+        }
+    };
+
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr std::uint16_t FAR = 0xFFFF;
+    static constexpr int ROW_STEP[4] = {-1, 1, 0, 0};
+    static constexpr int COL_STEP[4] = {0, 0, -1, 1};
+
+    int rows;
+    int cols;
+    int clusterSize;
+    int clusterRows;
+    int clusterCols;
+    std::vector<Cluster> clusters;
+    std::vector<std::uint32_t> nodeBase;     // First global node of each cluster, then the total
+    std::vector<std::uint32_t> nodeCluster;  // Cluster of each global node
+
+    // One cluster's cells with a wall border, for the searches inside it
+    std::vector<std::uint8_t> localOpen;
+    std::vector<std::uint16_t> localDistance;
+    std::vector<std::uint8_t> localVia;
+    std::vector<std::uint32_t> localQueue;
+    int localTop, localLeft, localWidth;     // localWidth includes the border
+
+    // Abstract search state, by global node
+    std::vector<std::uint32_t> stamp;
+    std::vector<std::uint32_t> bestG;
+    std::vector<std::uint32_t> parent;
+    std::vector<HeapNode> heap;
+    std::vector<std::uint16_t> goalDistance;   // Goal cluster's nodes to the goal
+    std::uint32_t generation;
+
+public:
+    static constexpr int DEFAULT_CLUSTER_SIZE = 32;
+
+    // Throws GameException for a cluster size outside 4..255 or a level too large
+    explicit HierarchicalSolver(const Level& level, int clusterEdge = DEFAULT_CLUSTER_SIZE);
+
+    SolveResult solve(const Level& level);
+    // `expanded` counts abstract nodes plus the cells searched inside clusters
+    SolveResult solve(const Level& level, const Position& start, const Position& goal);
+
+    // Cells from `first` to `last` (inclusive corners) changed in `level`: rebuild
+    // the clusters holding them, and those across a border they lie on. Returns how
+    // many clusters were rebuilt.
+    std::size_t update(const Level& level, const Position& first, const Position& last);
+
+    int getClusterSize() const { return clusterSize; }
+    std::size_t getClusterCount() const { return clusters.size(); }
+    std::size_t getNodeCount() const { return nodeCluster.size(); }
+    std::size_t getEdgeCount() const; // Inside clusters and across borders, each way
+
+    // Bytes held by the abstract graph and the search buffers
+    std::size_t memoryUsage() const;
+
+private:
+    int clusterOf(std::uint32_t cell) const {
+        return static_cast<int>(cell / cols) / clusterSize * clusterCols + static_cast<int>(cell % cols) / clusterSize;
+    }
+    int neighbourCluster(int cluster, int side) const;
+    static bool isOpen(const Level& level, std::uint32_t cell) { return level.cellAt(cell) != CellType::WALL; }
+    void entrances(const Level& level, int cluster, int side, std::vector<std::uint32_t>& cells) const;
+    void buildCluster(const Level& level, int cluster);
+    void numberNodes();
+
+    void loadCluster(const Level& level, int cluster);
+    std::uint32_t toLocal(std::uint32_t cell) const {
+        return static_cast<std::uint32_t>((static_cast<int>(cell / cols) - localTop + 1) * localWidth +
+                                          static_cast<int>(cell % cols) - localLeft + 1);
+    }
+    // BFS inside the loaded cluster, stopping early at `to` unless that is NONE
+    std::size_t searchLocal(std::uint32_t from, std::uint32_t to);
+    void traceLocal(std::uint32_t from, std::uint32_t to, std::vector<Position>& out);
+    void refine(const Level& level, std::uint32_t from, std::uint32_t to, std::vector<Position>& out,
+                std::size_t& expanded);
+    void relax(std::uint32_t node, std::uint32_t g, std::uint32_t from, const Position& goal);
+    void checkLevel(const Level& level) const;
+    Position toPosition(std::uint32_t cell) const {
+        return Position(static_cast<int>(cell / cols), static_cast<int>(cell % cols));
+    }
+};
+
+} // namespace MulaWee
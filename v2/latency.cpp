@@ -0,0 +1,98 @@
+#include "latency.hpp"
+#include "game_core.hpp"
+#include <cmath>
+#include <cstdio>
+
+namespace MulaWee {
+
+// LatencyHistogram class implementation
+int LatencyHistogram::bucketFor(std::uint64_t value) {
+    if (value < static_cast<std::uint64_t>(SUB_COUNT)) {
+        return static_cast<int>(value);
+    }
+    const std::uint64_t limit = (1ull << MAX_BITS) - 1;
+    if (value > limit) {
+        value = limit;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BITS;
+    int mantissa = static_cast<int>(value >> shift); // In [SUB_COUNT, 2 * SUB_COUNT)
+    return (shift + 1) * SUB_COUNT + (mantissa - SUB_COUNT);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return static_cast<std::uint64_t>(bucket);
+    }
+    int shift = bucket / SUB_COUNT - 1;
+    std::uint64_t mantissa = static_cast<std::uint64_t>(SUB_COUNT + bucket % SUB_COUNT);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds) {
+    ++counts[static_cast<std::size_t>(bucketFor(nanoseconds))];
+    ++total;
+    if (nanoseconds > maxValue) {
+        maxValue = nanoseconds;
+    }
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    std::uint64_t wanted = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+    if (wanted < 1) {
+        wanted = 1;
+    }
+    std::uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += counts[static_cast<std::size_t>(b)];
+        if (seen >= wanted) {
+            std::uint64_t bound = bucketUpperBound(b);
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+const char* latencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::INPUT: return "input";
+        case LatencyStage::VALIDATION: return "validation";
+        case LatencyStage::GOAL_CHECK: return "goal-check";
+        case LatencyStage::HINT: return "hint";
+        case LatencyStage::RENDER: return "render";
+        case LatencyStage::REFRESH: return "refresh";
+        case LatencyStage::TOTAL: return "total";
+        case LatencyStage::COUNT: break;
+    }
+    return "unknown";
+}
+
+// LatencyRecorder class implementation
+void LatencyRecorder::writeReport(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        throw FileException(path);
+    }
+
+    std::fprintf(file, "# Keypress-to-screen latency in nanoseconds\n");
+    std::fprintf(file, "%-12s %10s %12s %12s %12s %12s\n", "stage", "count", "p50", "p99", "p999", "max");
+    for (int s = 0; s < static_cast<int>(LatencyStage::COUNT); ++s) {
+        const LatencyHistogram& h = stages[static_cast<std::size_t>(s)];
+        std::fprintf(file, "%-12s %10llu %12llu %12llu %12llu %12llu\n",
+                     latencyStageName(static_cast<LatencyStage>(s)),
+                     static_cast<unsigned long long>(h.getCount()),
+                     static_cast<unsigned long long>(h.percentile(0.50)),
+                     static_cast<unsigned long long>(h.percentile(0.99)),
+                     static_cast<unsigned long long>(h.percentile(0.999)),
+                     static_cast<unsigned long long>(h.getMax()));
+    }
+
+    if (std::fclose(file) != 0) {
+        throw FileException(path);
+    }
+}
+
+} // namespace MulaWee
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace MulaWee {
+
+// Monotonic timestamp in nanoseconds
+inline std::uint64_t latencyNow() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Fixed-bucket log-linear histogram (HDR style): values below 32 ns get a bucket each,
+// above that every power of two is split into 32 buckets, so any recorded value is
+// within about 3% of its bucket. Recording is an index computation and an increment.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int MAX_BITS = 40; // Values are clamped below 2^40 ns (about 18 minutes)
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+private:
+    std::array<std::uint64_t, BUCKETS> counts;
+    std::uint64_t total;
+    std::uint64_t maxValue;
+
+public:
+    LatencyHistogram() : total(0), maxValue(0) { counts.fill(0); }
+
+    void record(std::uint64_t nanoseconds);
+
+    std::uint64_t getCount() const { return total; }
+    std::uint64_t getMax() const { return maxValue; }
+
+    // Smallest bucket upper bound covering `fraction` of the samples (0 when empty)
+    std::uint64_t percentile(double fraction) const;
+
+    static int bucketFor(std::uint64_t value);
+    static std::uint64_t bucketUpperBound(int bucket);
+};
+
+// Stages between getKey() returning and the screen being updated
+enum class LatencyStage : int {
+    INPUT,       // Reading the typed-ahead keys
+    VALIDATION,  // Player::move against the level
+    GOAL_CHECK,  // Goal test after a successful move
+    HINT,        // Best-move lookup for the hint key
+    RENDER,      // Drawing the batch into the renderer
+    REFRESH,     // Renderer::refresh
+    TOTAL,       // Keypress to screen
+    COUNT
+};
+
+const char* latencyStageName(LatencyStage stage);
+
+// One histogram per stage. Only created when latency reporting is on; everything that
+// records holds a pointer that is null otherwise, so the off path is a null check.
+class LatencyRecorder {
+private:
+    std::array<LatencyHistogram, static_cast<std::size_t>(LatencyStage::COUNT)> stages;
+
+public:
+    void record(LatencyStage stage, std::uint64_t startNs, std::uint64_t endNs) {
+        stages[static_cast<std::size_t>(stage)].record(endNs - startNs);
+    }
+
+    const LatencyHistogram& getHistogram(LatencyStage stage) const {
+        return stages[static_cast<std::size_t>(stage)];
+    }
+
+    // count, p50, p99, p999 and max per stage, in nanoseconds
+    void writeReport(const std::string& path) const;
+};
+
+} // namespace MulaWee
@@ -0,0 +1,349 @@
+#include "leaderboard.hpp"
+#include "temp_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <unordered_map>
+
+namespace MulaWee {
+
+using LeaderboardFormat::Header;
+using LeaderboardFormat::PlayerEntry;
+using LeaderboardFormat::ScoreEntry;
+
+namespace {
+
+// Best first; the earlier run wins a tie
+bool scoreBefore(const ScoreEntry& a, const ScoreEntry& b) {
+    return a.score != b.score ? a.score > b.score : a.offset < b.offset;
+}
+
+bool playerBetter(const PlayerEntry& a, const PlayerEntry& b) {
+    return a.best != b.best ? a.best > b.best : a.offset < b.offset;
+}
+
+std::uint64_t nameHash(const std::string& name) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Entries in `sorted` that come before `entry`
+std::size_t countBefore(const ScoreEntry* sorted, std::size_t count, const ScoreEntry& entry) {
+    return static_cast<std::size_t>(std::lower_bound(sorted, sorted + count, entry, scoreBefore) - sorted);
+}
+
+} // namespace
+
+// Leaderboard class implementation
+Leaderboard::Leaderboard(const std::string& runLogPath)
+    : logPath(runLogPath), basePath(runLogPath + LeaderboardFormat::BASE_EXTENSION),
+      deltaPath(runLogPath + LeaderboardFormat::DELTA_EXTENSION), rebuilt(false), lastIndexed(0) {
+    refresh();
+}
+
+void Leaderboard::refresh() {
+    rebuilt = false;
+    lastIndexed = 0;
+    base = IndexView();
+    delta = IndexView();
+    log.reset();
+
+    struct stat info;
+    if (::stat(logPath.c_str(), &info) != 0 ||
+        static_cast<std::uint64_t>(info.st_size) <= RunLogFormat::HEADER_BYTES) {
+        return; // No runs yet
+    }
+    std::uint64_t device = static_cast<std::uint64_t>(info.st_dev);
+    std::uint64_t inode = static_cast<std::uint64_t>(info.st_ino);
+
+    bool usable = mapIndex(basePath, base) && mapIndex(deltaPath, delta) &&
+                  base.header->logDevice == device && base.header->logInode == inode &&
+                  delta.header->logDevice == device && delta.header->logInode == inode &&
+                  base.header->baseCoveredUpTo == base.header->coveredUpTo &&
+                  delta.header->baseCoveredUpTo == base.header->coveredUpTo &&
+                  delta.header->coveredUpTo <= static_cast<std::uint64_t>(info.st_size);
+
+    if (!usable) {
+        base = IndexView();
+        delta = IndexView();
+        IndexData all;
+        std::uint64_t covered = scan(logPath, RunLogFormat::HEADER_BYTES, all);
+        writeIndex(basePath, all, device, inode, covered, covered);
+        writeIndex(deltaPath, IndexData(), device, inode, covered, covered);
+        rebuilt = true;
+        lastIndexed = all.totals.size();
+    } else if (delta.header->coveredUpTo < static_cast<std::uint64_t>(info.st_size)) {
+        IndexData added;
+        std::uint64_t covered = scan(logPath, delta.header->coveredUpTo, added);
+        if (!added.totals.empty()) {
+            IndexData merged = merge(load(delta), added);
+            std::uint64_t baseCovered = base.header->coveredUpTo;
+            if (merged.totals.size() > std::max(LeaderboardFormat::MIN_DELTA_MERGE, base.runCount() / 8)) {
+                IndexData all = merge(load(base), merged);
+                writeIndex(basePath, all, device, inode, covered, covered);
+                writeIndex(deltaPath, IndexData(), device, inode, covered, covered);
+            } else {
+                writeIndex(deltaPath, merged, device, inode, baseCovered, covered);
+            }
+            lastIndexed = added.totals.size();
+        }
+    }
+
+    if (rebuilt || lastIndexed > 0) {
+        base = IndexView();
+        delta = IndexView();
+        if (!mapIndex(basePath, base) || !mapIndex(deltaPath, delta)) {
+            throw GameException("Failed to reopen leaderboard index " + basePath);
+        }
+    }
+    log = std::make_unique<MappedFile>(logPath);
+}
+
+std::vector<LeaderboardEntry> Leaderboard::topRuns(std::size_t count) const {
+    return topOf(base.totals, base.runCount(), delta.totals, delta.runCount(), count);
+}
+
+std::vector<LeaderboardEntry> Leaderboard::topLevel(int level, std::size_t count) const {
+    std::size_t index = static_cast<std::size_t>(level - 1);
+    if (level < 1) {
+        return std::vector<LeaderboardEntry>();
+    }
+    bool inBase = index < base.levels.size();
+    bool inDelta = index < delta.levels.size();
+    return topOf(inBase ? base.levels[index] : nullptr, inBase ? base.levelCounts[index] : 0,
+                 inDelta ? delta.levels[index] : nullptr, inDelta ? delta.levelCounts[index] : 0, count);
+}
+
+bool Leaderboard::playerBest(const std::string& name, LeaderboardEntry& best) const {
+    PlayerEntry entry;
+    RunRecord record;
+    if (!findBest(name, entry) || !readRun(entry.offset, record)) {
+        return false;
+    }
+    best.playerName = record.playerName;
+    best.score = entry.best;
+    best.timestamp = record.timestamp;
+    return true;
+}
+
+std::size_t Leaderboard::playerRank(const std::string& name) const {
+    PlayerEntry entry;
+    if (!findBest(name, entry)) {
+        return 0;
+    }
+    ScoreEntry run{entry.best, 0, entry.offset};
+    return countBefore(base.totals, base.runCount(), run) + countBefore(delta.totals, delta.runCount(), run) + 1;
+}
+
+bool Leaderboard::mapIndex(const std::string& path, IndexView& view) const {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        return false;
+    }
+    view.file = std::make_unique<MappedFile>(path);
+    const std::uint8_t* data = view.file->data();
+    std::size_t size = view.file->size();
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, LeaderboardFormat::MAGIC, sizeof(LeaderboardFormat::MAGIC)) != 0 ||
+        header->version != LeaderboardFormat::VERSION || header->headerSize != sizeof(Header) ||
+        header->levelCount > 0xffff || header->runCount > size || header->playerCount > size) {
+        return false;
+    }
+
+    // Section sizes must add up to the file size exactly
+    const std::uint64_t* levelCounts = reinterpret_cast<const std::uint64_t*>(data + sizeof(Header));
+    std::uint64_t expected = sizeof(Header) + 8ull * header->levelCount;
+    if (expected > size) {
+        return false;
+    }
+    expected += header->runCount * sizeof(ScoreEntry) + header->playerCount * sizeof(PlayerEntry);
+    for (std::uint32_t i = 0; i < header->levelCount; ++i) {
+        if (levelCounts[i] > header->runCount) {
+            return false;
+        }
+        expected += levelCounts[i] * sizeof(ScoreEntry);
+    }
+    if (expected != size) {
+        return false;
+    }
+
+    const std::uint8_t* at = data + sizeof(Header) + 8ull * header->levelCount;
+    view.header = header;
+    view.totals = reinterpret_cast<const ScoreEntry*>(at);
+    at += header->runCount * sizeof(ScoreEntry);
+    view.players = reinterpret_cast<const PlayerEntry*>(at);
+    at += header->playerCount * sizeof(PlayerEntry);
+    for (std::uint32_t i = 0; i < header->levelCount; ++i) {
+        view.levels.push_back(reinterpret_cast<const ScoreEntry*>(at));
+        view.levelCounts.push_back(static_cast<std::size_t>(levelCounts[i]));
+        at += levelCounts[i] * sizeof(ScoreEntry);
+    }
+    return true;
+}
+
+void Leaderboard::writeIndex(const std::string& path, const IndexData& data, std::uint64_t device,
+                             std::uint64_t inode, std::uint64_t baseCoveredUpTo,
+                             std::uint64_t coveredUpTo) const {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LeaderboardFormat::MAGIC, sizeof(LeaderboardFormat::MAGIC));
+    header.version = LeaderboardFormat::VERSION;
+    header.headerSize = sizeof(Header);
+    header.levelCount = static_cast<std::uint32_t>(data.levels.size());
+    header.logDevice = device;
+    header.logInode = inode;
+    header.baseCoveredUpTo = baseCoveredUpTo;
+    header.coveredUpTo = coveredUpTo;
+    header.runCount = data.totals.size();
+    header.playerCount = data.players.size();
+
+    // Its own temporary file, so two processes refreshing one log never mix their indexes
+    TempFile temp(path);
+    {
+        std::ofstream file(temp.getPath(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw FileException(temp.getPath());
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const std::vector<ScoreEntry>& level : data.levels) {
+            std::uint64_t count = level.size();
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        file.write(reinterpret_cast<const char*>(data.totals.data()),
+                   static_cast<std::streamsize>(data.totals.size() * sizeof(ScoreEntry)));
+        file.write(reinterpret_cast<const char*>(data.players.data()),
+                   static_cast<std::streamsize>(data.players.size() * sizeof(PlayerEntry)));
+        for (const std::vector<ScoreEntry>& level : data.levels) {
+            file.write(reinterpret_cast<const char*>(level.data()),
+                       static_cast<std::streamsize>(level.size() * sizeof(ScoreEntry)));
+        }
+        if (!file.flush()) {
+            throw GameException("Failed to write leaderboard index " + temp.getPath());
+        }
+    }
+    temp.commit();
+}
+
+std::uint64_t Leaderboard::scan(const std::string& path, std::uint64_t from, IndexData& data) {
+    std::unordered_map<std::uint64_t, PlayerEntry> bests;
+    std::uint64_t covered = RunLog::forEachFrom(path, from, [&](const RunRecord& record, std::uint64_t offset) {
+        data.totals.push_back(ScoreEntry{record.total, 0, offset});
+        if (data.levels.size() < record.levels.size()) {
+            data.levels.resize(record.levels.size());
+        }
+        for (std::size_t i = 0; i < record.levels.size(); ++i) {
+            data.levels[i].push_back(ScoreEntry{record.levels[i].score, 0, offset});
+        }
+
+        PlayerEntry entry{nameHash(record.playerName), record.total, 0, offset};
+        auto found = bests.emplace(entry.nameHash, entry);
+        if (!found.second && playerBetter(entry, found.first->second)) {
+            found.first->second = entry;
+        }
+    });
+
+    std::sort(data.totals.begin(), data.totals.end(), scoreBefore);
+    for (std::vector<ScoreEntry>& level : data.levels) {
+        std::sort(level.begin(), level.end(), scoreBefore);
+    }
+    data.players.reserve(bests.size());
+    for (const auto& best : bests) {
+        data.players.push_back(best.second);
+    }
+    std::sort(data.players.begin(), data.players.end(),
+              [](const PlayerEntry& a, const PlayerEntry& b) { return a.nameHash < b.nameHash; });
+    return std::max(covered, from);
+}
+
+Leaderboard::IndexData Leaderboard::load(const IndexView& view) {
+    IndexData data;
+    data.totals.assign(view.totals, view.totals + view.runCount());
+    data.players.assign(view.players, view.players + view.playerCount());
+    for (std::size_t i = 0; i < view.levels.size(); ++i) {
+        data.levels.emplace_back(view.levels[i], view.levels[i] + view.levelCounts[i]);
+    }
+    return data;
+}
+
+Leaderboard::IndexData Leaderboard::merge(const IndexData& older, const IndexData& newer) {
+    IndexData merged;
+    merged.totals.reserve(older.totals.size() + newer.totals.size());
+    std::merge(older.totals.begin(), older.totals.end(), newer.totals.begin(), newer.totals.end(),
+               std::back_inserter(merged.totals), scoreBefore);
+
+    merged.levels.resize(std::max(older.levels.size(), newer.levels.size()));
+    for (std::size_t i = 0; i < merged.levels.size(); ++i) {
+        static const std::vector<ScoreEntry> none;
+        const std::vector<ScoreEntry>& a = i < older.levels.size() ? older.levels[i] : none;
+        const std::vector<ScoreEntry>& b = i < newer.levels.size() ? newer.levels[i] : none;
+        merged.levels[i].reserve(a.size() + b.size());
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged.levels[i]), scoreBefore);
+    }
+
+    // Both sides are ordered by hash; a player in both keeps the better run
+    merged.players.reserve(older.players.size() + newer.players.size());
+    auto a = older.players.begin();
+    auto b = newer.players.begin();
+    while (a != older.players.end() || b != newer.players.end()) {
+        if (b == newer.players.end() || (a != older.players.end() && a->nameHash < b->nameHash)) {
+            merged.players.push_back(*a++);
+        } else if (a == older.players.end() || b->nameHash < a->nameHash) {
+            merged.players.push_back(*b++);
+        } else {
+            merged.players.push_back(playerBetter(*b, *a) ? *b : *a);
+            ++a;
+            ++b;
+        }
+    }
+    return merged;
+}
+
+std::vector<LeaderboardEntry> Leaderboard::topOf(const ScoreEntry* first, std::size_t firstCount,
+                                                 const ScoreEntry* second, std::size_t secondCount,
+                                                 std::size_t count) const {
+    std::vector<LeaderboardEntry> top;
+    std::size_t i = 0, j = 0;
+    RunRecord record;
+    while (top.size() < count && (i < firstCount || j < secondCount)) {
+        bool takeFirst = j == secondCount || (i < firstCount && scoreBefore(first[i], second[j]));
+        const ScoreEntry& entry = takeFirst ? first[i++] : second[j++];
+        if (!readRun(entry.offset, record)) {
+            continue;
+        }
+        LeaderboardEntry line;
+        line.playerName = record.playerName;
+        line.score = entry.score;
+        line.timestamp = record.timestamp;
+        top.push_back(std::move(line));
+    }
+    return top;
+}
+
+bool Leaderboard::findBest(const std::string& name, PlayerEntry& best) const {
+    // The hash picks the entry; the name is checked against the run it points at
+    std::uint64_t hash = nameHash(name);
+    bool found = false;
+    for (const IndexView* view : {&base, &delta}) {
+        const PlayerEntry* end = view->players + view->playerCount();
+        const PlayerEntry* at = std::lower_bound(
+            view->players, end, hash, [](const PlayerEntry& entry, std::uint64_t key) { return entry.nameHash < key; });
+        if (at != end && at->nameHash == hash && (!found || playerBetter(*at, best))) {
+            best = *at;
+            found = true;
+        }
+    }
+
+    RunRecord record;
+    return found && readRun(best.offset, record) && record.playerName == name;
+}
+
+bool Leaderboard::readRun(std::uint64_t offset, RunRecord& record) const {
+    return log && RunLog::readAt(log->data(), log->size(), offset, record);
+}
+
+} // namespace MulaWee
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "level_format.hpp"
+#include "run_log.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// Leaderboard index files (<log>.idx and <log>.delta)
+//
+// Both files have the same layout: a 64-byte header, one run count per level
+// (8 bytes each), then sorted arrays that are used in place through mmap:
+//
+//   totals   ScoreEntry per run, best total first
+//   players  PlayerEntry per player (their best run), ordered by name hash
+//   levels   ScoreEntry per run that played level N, best level score first
+//
+// Entries point at records in the run log by offset. The base file (.idx) covers
+// the log up to some offset and the delta file covers the runs appended after that;
+// new runs are merged into the small delta, and the delta into the base only once it
+// has grown to an eighth of it. A compacted or replaced log is re-indexed from scratch.
+namespace LeaderboardFormat {
+
+constexpr char MAGIC[4] = {'M', 'W', 'I', 'X'};
+constexpr std::uint16_t VERSION = 1;
+constexpr const char* BASE_EXTENSION = ".idx";
+constexpr const char* DELTA_EXTENSION = ".delta";
+constexpr std::size_t MIN_DELTA_MERGE = 4096; // Runs a delta may hold whatever the base size
+
+struct Header {
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t headerSize;
+    std::uint32_t levelCount;
+    std::uint32_t reserved0;
+    std::uint64_t logDevice;       // Identity of the log file indexed
+    std::uint64_t logInode;
+    std::uint64_t baseCoveredUpTo; // Delta: the base it extends; base: same as coveredUpTo
+    std::uint64_t coveredUpTo;     // Log offset just past the last run indexed
+    std::uint64_t runCount;
+    std::uint64_t playerCount;
+};
+
+static_assert(sizeof(Header) == 64, "leaderboard index header must stay 64 bytes");
+
+struct ScoreEntry {
+    std::int32_t score;
+    std::uint32_t reserved;
+    std::uint64_t offset; // Run record in the log (earlier run first on equal scores)
+};
+
+struct PlayerEntry {
+    std::uint64_t nameHash; // FNV-1a 64 of the player name
+    std::int32_t best;
+    std::uint32_t reserved;
+    std::uint64_t offset;   // The player's best run
+};
+
+static_assert(sizeof(ScoreEntry) == 16, "score entries must stay 16 bytes");
+static_assert(sizeof(PlayerEntry) == 24, "player entries must stay 24 bytes");
+
+} // namespace LeaderboardFormat
+
+// One line of a leaderboard table
+struct LeaderboardEntry {
+    std::string playerName;
+    int score = 0;               // Run total, or the level score for per-level tables
+    std::uint64_t timestamp = 0;
+};
+
+// Top-K queries over a run log through its sorted index files. Every query is a binary
+// search or a merge of the first K entries of the base and delta arrays, so nothing
+// scans the history; refresh() indexes only the runs appended since the last call.
+class Leaderboard {
+private:
+    // One mapped index file
+    struct IndexView {
+        std::unique_ptr<MappedFile> file;
+        const LeaderboardFormat::Header* header = nullptr;
+        const LeaderboardFormat::ScoreEntry* totals = nullptr;
+        const LeaderboardFormat::PlayerEntry* players = nullptr;
+        std::vector<const LeaderboardFormat::ScoreEntry*> levels;
+        std::vector<std::size_t> levelCounts;
+
+        std::size_t runCount() const { return header ? static_cast<std::size_t>(header->runCount) : 0; }
+        std::size_t playerCount() const { return header ? static_cast<std::size_t>(header->playerCount) : 0; }
+    };
+
+    // An index held in memory while it is being merged and written
+    struct IndexData {
+        std::vector<LeaderboardFormat::ScoreEntry> totals;
+        std::vector<LeaderboardFormat::PlayerEntry> players;
+        std::vector<std::vector<LeaderboardFormat::ScoreEntry>> levels;
+    };
+
+    std::string logPath;
+    std::string basePath;
+    std::string deltaPath;
+    std::unique_ptr<MappedFile> log; // For names and timestamps
+    IndexView base;
+    IndexView delta;
+    bool rebuilt;
+    std::size_t lastIndexed;
+
+public:
+    explicit Leaderboard(const std::string& runLogPath);
+
+    // Index runs appended since the last refresh (or rebuild the index if the log was
+    // compacted or the index files are missing, damaged or out of step)
+    void refresh();
+
+    std::vector<LeaderboardEntry> topRuns(std::size_t count) const;
+    std::vector<LeaderboardEntry> topLevel(int level, std::size_t count) const; // level from 1
+
+    // False if the player has no runs
+    bool playerBest(const std::string& name, LeaderboardEntry& best) const;
+
+    // Position of the player's best run among all runs (1 = top); 0 if they have none
+    std::size_t playerRank(const std::string& name) const;
+
+    std::size_t getRunCount() const { return base.runCount() + delta.runCount(); }
+    bool wasRebuilt() const { return rebuilt; }             // By the last refresh
+    std::size_t getLastIndexed() const { return lastIndexed; } // Runs added by the last refresh
+
+private:
+    bool mapIndex(const std::string& path, IndexView& view) const;
+    void writeIndex(const std::string& path, const IndexData& data, std::uint64_t device, std::uint64_t inode,
+                    std::uint64_t baseCoveredUpTo, std::uint64_t coveredUpTo) const;
+    static std::uint64_t scan(const std::string& path, std::uint64_t from, IndexData& data);
+    static IndexData load(const IndexView& view);
+    static IndexData merge(const IndexData& older, const IndexData& newer);
+    std::vector<LeaderboardEntry> topOf(const LeaderboardFormat::ScoreEntry* first, std::size_t firstCount,
+                                        const LeaderboardFormat::ScoreEntry* second, std::size_t secondCount,
+                                        std::size_t count) const;
+    bool findBest(const std::string& name, LeaderboardFormat::PlayerEntry& best) const;
+    bool readRun(std::uint64_t offset, RunRecord& record) const;
+};
+
+} // namespace MulaWee
@@ -0,0 +1,298 @@
+#include "level_cache.hpp"
+#include "level_format.hpp"
+#include "level_validator.hpp"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MulaWee {
+
+namespace {
+
+std::string directoryOf(const std::string& path) {
+    std::string::size_type slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// How inotify names the file: its directory, a slash and the name
+std::string watchKey(const std::string& path) {
+    std::string::size_type slash = path.find_last_of('/');
+    return directoryOf(path) + "/" + (slash == std::string::npos ? path : path.substr(slash + 1));
+}
+
+bool newerThan(const struct stat& a, const struct stat& b) {
+    return a.st_mtim.tv_sec != b.st_mtim.tv_sec ? a.st_mtim.tv_sec > b.st_mtim.tv_sec
+                                                : a.st_mtim.tv_nsec > b.st_mtim.tv_nsec;
+}
+
+// The compiled level beside a text level, unless the text was edited after it
+std::string resolve(const std::string& textPath) {
+    std::string compiled = LevelFormat::compiledPathFor(textPath);
+    struct stat text, binary;
+    if (::stat(compiled.c_str(), &binary) != 0 || !LevelFormat::isCompiled(compiled)) {
+        return textPath;
+    }
+    if (::stat(textPath.c_str(), &text) == 0 && newerThan(text, binary)) {
+        return textPath;
+    }
+    return compiled;
+}
+
+// The level and its packed grid
+std::size_t footprint(const Level& level) {
+    return sizeof(Level) + level.getFilename().size() + PackedGrid::bytesFor(level.getRows(), level.getCols());
+}
+
+} // namespace
+
+// LevelCache class implementation
+LevelCache::LevelCache(std::vector<std::string> levelPaths, std::size_t budgetBytes, bool watchFiles)
+    : paths(std::move(levelPaths)), memoryBudget(budgetBytes), entries(paths.size()), cachedBytes(0),
+      inotifyFd(-1), wakeFd(-1), stopping(false) {
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        byFile[watchKey(paths[i])] = i;
+        byFile[watchKey(LevelFormat::compiledPathFor(paths[i]))] = i;
+    }
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        throw GameException(std::string("eventfd: ") + std::strerror(errno));
+    }
+    if (watchFiles) {
+        watch();
+    }
+    worker = std::thread([this] { workerLoop(); });
+}
+
+LevelCache::~LevelCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake();
+    worker.join();
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);
+    }
+    ::close(wakeFd);
+}
+
+std::vector<std::string> LevelCache::discover(const std::string& dataDir) {
+    std::vector<std::string> found;
+    for (int i = 1;; ++i) {
+        std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0 &&
+            ::stat(LevelFormat::compiledPathFor(path).c_str(), &info) != 0) {
+            return found;
+        }
+        found.push_back(path);
+    }
+}
+
+std::shared_ptr<const Level> LevelCache::get(std::size_t index) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Entry& entry = entries.at(index);
+    loaded.wait(lock, [&entry] { return !entry.loading; }); // Prefetch already on it
+    if (entry.level) {
+        ++stats.hits;
+        touch(index);
+        return entry.level;
+    }
+    ++stats.misses;
+    return load(index, lock);
+}
+
+void LevelCache::prefetch(std::size_t index) {
+    if (index >= entries.size()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries[index].level || entries[index].loading) {
+            return;
+        }
+        prefetchQueue.push_back(index);
+    }
+    wake();
+}
+
+LevelCacheStats LevelCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::size_t LevelCache::getCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cachedBytes;
+}
+
+std::size_t LevelCache::getCachedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recent.size();
+}
+
+std::shared_ptr<const Level> LevelCache::load(std::size_t index, std::unique_lock<std::mutex>& lock) {
+    // Parsing happens unlocked, so a hit on another level never waits for it
+    Entry& entry = entries[index];
+    entry.loading = true;
+    unsigned generation = entry.generation;
+    lock.unlock();
+
+    std::shared_ptr<const Level> level;
+    try {
+        level = std::make_shared<const Level>(resolve(paths[index]));
+        LevelValidator().check(*level); // Edited levels are checked too, before anyone plays them
+    } catch (...) {
+        lock.lock();
+        entry.loading = false;
+        loaded.notify_all();
+        throw;
+    }
+
+    lock.lock();
+    entry.loading = false;
+    store(index, level, generation);
+    loaded.notify_all();
+    return level;
+}
+
+void LevelCache::store(std::size_t index, const std::shared_ptr<const Level>& level, unsigned generation) {
+    Entry& entry = entries[index];
+    if (generation != entry.generation || entry.level) {
+        return; // Edited while loading; the reload queued by the edit caches the new one
+    }
+    entry.level = level;
+    entry.bytes = footprint(*level);
+    recent.push_front(index);
+    entry.recent = recent.begin();
+    cachedBytes += entry.bytes;
+    evict(index);
+}
+
+void LevelCache::touch(std::size_t index) {
+    recent.splice(recent.begin(), recent, entries[index].recent);
+}
+
+void LevelCache::evict(std::size_t keep) {
+    while (cachedBytes > memoryBudget && !recent.empty() && recent.back() != keep) {
+        drop(recent.back());
+        ++stats.evictions;
+    }
+}
+
+void LevelCache::drop(std::size_t index) {
+    Entry& entry = entries[index];
+    cachedBytes -= entry.bytes;
+    recent.erase(entry.recent);
+    entry.level.reset(); // A session playing it keeps its own reference
+    entry.bytes = 0;
+}
+
+void LevelCache::watch() {
+    inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        return; // Still a cache, just without hot reload
+    }
+    for (const std::string& path : paths) {
+        std::string directory = directoryOf(path);
+        bool watched = false;
+        for (const auto& entry : watchedDirs) {
+            watched = watched || entry.second == directory;
+        }
+        if (watched) {
+            continue;
+        }
+        // Editors either rewrite the file or rename a new one over it
+        int wd = ::inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) {
+            watchedDirs[wd] = directory;
+        }
+    }
+}
+
+void LevelCache::workerLoop() {
+    pollfd fds[2];
+    fds[0].fd = wakeFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = inotifyFd;
+    fds[1].events = POLLIN;
+    nfds_t count = inotifyFd >= 0 ? 2 : 1;
+
+    while (true) {
+        if (::poll(fds, count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[0].revents & POLLIN) {
+            std::uint64_t value;
+            ssize_t ignored = ::read(wakeFd, &value, sizeof(value));
+            (void)ignored;
+        }
+        if (count > 1 && (fds[1].revents & POLLIN)) {
+            readChanges();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping && !prefetchQueue.empty()) {
+            std::size_t index = prefetchQueue.front();
+            prefetchQueue.pop_front();
+            if (entries[index].level || entries[index].loading) {
+                continue;
+            }
+            try {
+                load(index, lock);
+                ++stats.prefetched;
+            } catch (const std::exception&) {
+                // Left uncached; get() loads it again and reports the error
+            }
+        }
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void LevelCache::readChanges() {
+    alignas(inotify_event) char buffer[4096];
+    ssize_t got;
+    while ((got = ::read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char* next = buffer; next < buffer + got;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+            next += sizeof(inotify_event) + event->len;
+            auto directory = watchedDirs.find(event->wd);
+            if (event->len == 0 || directory == watchedDirs.end()) {
+                continue;
+            }
+            auto file = byFile.find(directory->second + "/" + event->name);
+            if (file == byFile.end()) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            Entry& entry = entries[file->second];
+            ++entry.generation;
+            ++stats.reloads;
+            if (entry.level) {
+                drop(file->second);
+                prefetchQueue.push_back(file->second); // Keep it warm
+            }
+        }
+    }
+}
+
+void LevelCache::wake() {
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+} // namespace MulaWee
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MulaWee {
+
+struct LevelCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;     // Loaded by the caller of get()
+    std::size_t prefetched = 0; // Loaded in the background
+    std::size_t evictions = 0;
+    std::size_t reloads = 0;    // Edited on disk while the game ran
+};
+
+// Levels loaded on first use. Only the ones used most recently are kept, up to a
+// memory budget; the level being played stays alive through its shared_ptr even if
+// it is evicted. A background thread loads prefetched levels and watches the level
+// directories with inotify: an edited file is dropped from the cache (and loaded
+// again if it was cached), so the next start of that level plays the new version.
+class LevelCache : public LevelSource {
+private:
+    struct Entry {
+        std::shared_ptr<const Level> level; // Null unless cached
+        std::size_t bytes = 0;
+        std::list<std::size_t>::iterator recent;
+        bool loading = false;
+        unsigned generation = 0;            // Bumped on every edit of the file
+    };
+
+    std::vector<std::string> paths;          // Text level paths, in play order
+    std::unordered_map<std::string, std::size_t> byFile; // Text and compiled paths -> index
+    std::size_t memoryBudget;
+
+    mutable std::mutex mutex;
+    std::condition_variable loaded;
+    std::vector<Entry> entries;
+    std::list<std::size_t> recent;           // Cached indexes, most recently used first
+    std::size_t cachedBytes;
+    std::deque<std::size_t> prefetchQueue;
+    LevelCacheStats stats;
+
+    int inotifyFd;                           // -1 when not watching
+    std::unordered_map<int, std::string> watchedDirs; // Watch descriptor -> directory
+    int wakeFd;
+    bool stopping;
+    std::thread worker;
+
+public:
+    static constexpr std::size_t DEFAULT_BUDGET = 64 << 20;
+
+    // `levelPaths` are text levels; a compiled level beside one is used while it is
+    // at least as new. With `watchFiles`, edits on disk are picked up as they happen.
+    explicit LevelCache(std::vector<std::string> levelPaths, std::size_t budgetBytes = DEFAULT_BUDGET,
+                        bool watchFiles = true);
+    ~LevelCache() override;
+
+    LevelCache(const LevelCache&) = delete;
+    LevelCache& operator=(const LevelCache&) = delete;
+
+    // DIR/level1.dat, level2.dat, ... up to the first number with neither a text
+    // nor a compiled file
+    static std::vector<std::string> discover(const std::string& dataDir);
+
+    std::size_t size() const override { return paths.size(); }
+    std::shared_ptr<const Level> get(std::size_t index) override;
+    void prefetch(std::size_t index) override;
+
+    LevelCacheStats getStats() const;
+    std::size_t getCachedBytes() const;
+    std::size_t getCachedCount() const;
+
+private:
+    std::shared_ptr<const Level> load(std::size_t index, std::unique_lock<std::mutex>& lock);
+    void store(std::size_t index, const std::shared_ptr<const Level>& level, unsigned generation);
+    void touch(std::size_t index);
+    void evict(std::size_t keep);
+    void drop(std::size_t index);
+    void watch();
+    void workerLoop();
+    void readChanges();
+    void wake();
+};
+
+} // namespace MulaWee
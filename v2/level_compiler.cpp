@@ -0,0 +1,201 @@
+#include "level_format.hpp"
+#include "level_validator.hpp"
+#include "temp_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+// Level compiler - turns text .dat levels into mmap-ready .mwl files
+//
+//   mulavee_levelc [-o OUTPUT] LEVEL.dat...   compile (default output: LEVEL.mwl)
+//   mulavee_levelc --check LEVEL...           verify header, checksum and playability
+//   mulavee_levelc --embed -o OUTPUT LEVEL... constexpr tables for embedded_levels.cpp
+//   mulavee_levelc --embed-sizes -o OUTPUT LEVEL...
+//                                             their FixedLevel sizes, for FixedLevelSizes dispatch
+//
+// Levels LevelValidator finds unplayable are not compiled or embedded.
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [-o OUTPUT] LEVEL.dat...\n"
+              << "       " << program << " --check LEVEL...\n"
+              << "       " << program << " --embed -o OUTPUT LEVEL...\n"
+              << "       " << program << " --embed-sizes -o OUTPUT LEVEL..." << std::endl;
+}
+
+void describe(const MulaWee::Level& level) {
+    std::cout << level.getFilename() << ": " << level.getRows() << "x" << level.getCols()
+              << " start (" << level.getStartPosition().row << ", " << level.getStartPosition().col
+              << ") goal (" << level.getGoalPosition().row << ", " << level.getGoalPosition().col
+              << ") checksum " << std::hex << level.getChecksum() << std::dec << std::endl;
+}
+
+bool check(const std::string& path) {
+    MulaWee::Level level(path);
+    const MulaWee::PackedGrid& grid = level.getGrid();
+    std::uint32_t actual = MulaWee::LevelFormat::checksum(grid.data(), grid.byteSize());
+
+    describe(level);
+    if (actual != level.getChecksum()) {
+        std::cerr << path << ": checksum mismatch (computed " << std::hex << actual << std::dec
+                  << ")" << std::endl;
+        return false;
+    }
+
+    MulaWee::LevelReport report = MulaWee::LevelValidator().validate(level);
+    for (const std::string& problem : report.problems()) {
+        std::cerr << path << ": " << problem << std::endl;
+    }
+    return report.isPlayable();
+}
+
+// Level i's cells and EmbeddedLevel as C++, each check a static_assert naming the file
+void embedLevel(std::ostream& out, const MulaWee::Level& level, const std::string& path, std::size_t i) {
+    const MulaWee::PackedGrid& grid = level.getGrid();
+    out << "\n// " << path << "\nconstexpr std::uint8_t CELLS_" << i << "[] = {";
+    for (std::size_t b = 0; b < grid.byteSize(); ++b) {
+        out << (b % 16 == 0 ? "\n    " : " ") << "0x" << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<unsigned>(grid.data()[b]) << std::dec << ",";
+    }
+    out << "\n};\nconstexpr EmbeddedLevel LEVEL_" << i << " = {\"" << MulaWee::LevelFormat::levelName(path) << "\", "
+        << level.getRows() << ", " << level.getCols() << ", " << level.getGoalPosition().row << ", "
+        << level.getGoalPosition().col << ", " << level.getStartPosition().row << ", "
+        << level.getStartPosition().col << ", 0x" << std::hex << level.getChecksum() << std::dec
+        << "u, CELLS_" << i << ", sizeof(CELLS_" << i << ")};\n";
+
+    const char* checks[][2] = {
+        {"hasValidSize", "grid size does not match its rows and columns"},
+        {"hasKnownCells", "unknown cell type or stray bits past the last cell"},
+        {"hasOneGoal", "needs exactly one goal, at the goal position"},
+        {"hasOpenStart", "start is outside the level or in a wall"},
+        {"hasChecksum", "checksum does not match the cells"},
+    };
+    for (const auto& check : checks) {
+        out << "static_assert(" << check[0] << "(LEVEL_" << i << "), \"" << path << ": " << check[1]
+            << "\");\n";
+    }
+}
+
+// Replaces `output` with `text` in one rename, so make never sees half a file
+void writeGenerated(const std::string& text, const std::string& output) {
+    MulaWee::TempFile temp(output);
+    {
+        std::ofstream file(temp.getPath(), std::ios::trunc);
+        if (!(file << text) || !file.flush()) {
+            throw MulaWee::FileException(temp.getPath());
+        }
+    }
+    temp.commit();
+}
+
+int embed(const std::vector<std::string>& inputs, const std::string& output) {
+    std::ostringstream out;
+    out << "// Generated by mulavee_levelc --embed; edit the level files instead\n";
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        MulaWee::Level level(inputs[i]);
+        MulaWee::LevelValidator().check(level);
+        embedLevel(out, level, inputs[i], i + 1);
+    }
+    out << "\nconstexpr const EmbeddedLevel* LEVELS[] = {";
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        out << (i ? ", " : "") << "&LEVEL_" << i + 1;
+    }
+    out << "};\n";
+
+    writeGenerated(out.str(), output);
+    std::cout << inputs.size() << " levels -> " << output << std::endl;
+    return 0;
+}
+
+// The distinct sizes of the levels, in order, as one FixedLevelSizes type
+int embedSizes(const std::vector<std::string>& inputs, const std::string& output) {
+    std::vector<std::pair<int, int>> sizes;
+    std::ostringstream out;
+    out << "// Generated by mulavee_levelc --embed-sizes; edit the level files instead\n";
+    for (const std::string& input : inputs) {
+        MulaWee::Level level(input);
+        MulaWee::LevelValidator().check(level);
+        std::pair<int, int> size(level.getRows(), level.getCols());
+        out << "// " << input << ": " << size.first << "x" << size.second << "\n";
+        if (std::find(sizes.begin(), sizes.end(), size) == sizes.end()) {
+            sizes.push_back(size);
+        }
+    }
+    out << "using EmbeddedLevelSizes = MulaWee::FixedLevelSizes<";
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        out << (i ? ", " : "") << sizes[i].first << ", " << sizes[i].second;
+    }
+    out << ">;\n";
+
+    writeGenerated(out.str(), output);
+    std::cout << sizes.size() << " level sizes -> " << output << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool checkMode = false;
+    bool embedMode = false;
+    bool sizesMode = false;
+    std::string output;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--check") == 0) {
+            checkMode = true;
+        } else if (std::strcmp(argv[i], "--embed") == 0) {
+            embedMode = true;
+        } else if (std::strcmp(argv[i], "--embed-sizes") == 0) {
+            sizesMode = true;
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (embedMode != sizesMode && !checkMode && !inputs.empty() && !output.empty()) {
+        try {
+            return embedMode ? embed(inputs, output) : embedSizes(inputs, output);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (embedMode || sizesMode || inputs.empty() || (!output.empty() && inputs.size() != 1)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (const std::string& input : inputs) {
+        try {
+            if (checkMode) {
+                failures += check(input) ? 0 : 1;
+                continue;
+            }
+
+            MulaWee::Level level(input);
+            MulaWee::LevelValidator().check(level);
+            std::string target = output.empty() ? MulaWee::LevelFormat::compiledPathFor(input) : output;
+            MulaWee::LevelFormat::write(level, target);
+            std::cout << input << " -> " << target << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
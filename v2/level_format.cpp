@@ -0,0 +1,120 @@
+#include "level_format.hpp"
+#include "temp_file.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MulaWee {
+namespace LevelFormat {
+
+bool isCompiled(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void write(const Level& level, const std::string& path) {
+    const PackedGrid& grid = level.getGrid();
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.rows = level.getRows();
+    header.cols = level.getCols();
+    header.goalRow = level.getGoalPosition().row;
+    header.goalCol = level.getGoalPosition().col;
+    header.startRow = level.getStartPosition().row;
+    header.startCol = level.getStartPosition().col;
+    header.checksum = checksum(grid.data(), grid.byteSize());
+    header.gridBytes = grid.byteSize();
+
+    TempFile temp(path);
+    {
+        std::ofstream file(temp.getPath(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw FileException(temp.getPath());
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(grid.data()),
+                   static_cast<std::streamsize>(grid.byteSize()));
+        if (!file.flush()) {
+            throw GameException("Failed to write compiled level " + temp.getPath());
+        }
+    }
+    temp.commit();
+}
+
+void validateHeader(const Header& header, std::size_t fileSize, const std::string& path) {
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw GameException("Not a compiled level: " + path);
+    }
+    if (header.version != VERSION) {
+        throw GameException("Unsupported compiled level version " +
+                            std::to_string(header.version) + " in " + path);
+    }
+    if (header.rows <= 0 || header.cols <= 0 || header.headerSize < sizeof(Header)) {
+        throw GameException("Invalid level dimensions in " + path);
+    }
+    if (header.gridBytes != PackedGrid::bytesFor(header.rows, header.cols) ||
+        fileSize < header.headerSize + header.gridBytes) {
+        throw GameException("Truncated level data in " + path);
+    }
+}
+
+std::string compiledPathFor(const std::string& textPath) {
+    std::string::size_type dot = textPath.find_last_of('.');
+    std::string::size_type slash = textPath.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return textPath + EXTENSION;
+    }
+    return textPath.substr(0, dot) + EXTENSION;
+}
+
+std::string levelName(const std::string& path) {
+    std::string::size_type slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    std::string::size_type dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+} // namespace LevelFormat
+
+// MappedFile implementation
+MappedFile::MappedFile(const std::string& path) : address(nullptr), length(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw FileException(path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        throw GameException("Cannot map empty or unreadable file " + path);
+    }
+
+    length = static_cast<std::size_t>(info.st_size);
+    address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (address == MAP_FAILED) {
+        address = nullptr;
+        throw GameException("Failed to map " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (address) {
+        ::munmap(address, length);
+    }
+}
+
+} // namespace MulaWee
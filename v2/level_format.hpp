@@ -0,0 +1,93 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace MulaWee {
+
+// Compiled level format (.mwl)
+//
+// A fixed 64-byte little-endian header followed by the PackedGrid bytes, so a
+// level can be mapped and used in place without parsing:
+//
+//   offset  size  field
+//        0     4  magic "MWLV"
+//        4     2  version
+//        6     2  header size (offset of the grid bytes)
+//        8    24  rows, cols, goal row/col, start row/col (int32 each)
+//       32     4  FNV-1a checksum of the grid bytes
+//       36     4  reserved
+//       40     8  grid byte count
+//       48    16  reserved
+namespace LevelFormat {
+
+constexpr char MAGIC[4] = {'M', 'W', 'L', 'V'};
+constexpr std::uint16_t VERSION = 1;
+constexpr const char* EXTENSION = ".mwl";
+
+struct Header {
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t headerSize;
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t goalRow;
+    std::int32_t goalCol;
+    std::int32_t startRow;
+    std::int32_t startCol;
+    std::uint32_t checksum;
+    std::uint32_t reserved0;
+    std::uint64_t gridBytes;
+    std::uint8_t reserved[16];
+};
+
+static_assert(sizeof(Header) == 64, "compiled level header must stay 64 bytes");
+
+// FNV-1a over the packed grid bytes (constexpr so embedded levels are checked at build time)
+constexpr std::uint32_t checksum(const std::uint8_t* data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// True if the file starts with the compiled level magic
+bool isCompiled(const std::string& path);
+
+// Write a loaded level in compiled form (via a temporary file and rename)
+void write(const Level& level, const std::string& path);
+
+// Validate a header against the size of the file it came from
+void validateHeader(const Header& header, std::size_t fileSize, const std::string& path);
+
+// "levels/level1.dat" -> "levels/level1.mwl"
+std::string compiledPathFor(const std::string& textPath);
+
+// "../data/level1.dat" -> "level1": the name a level goes by in packs and embedded tables
+std::string levelName(const std::string& path);
+
+} // namespace LevelFormat
+
+// RAII read-only memory mapping of a whole file
+class MappedFile {
+private:
+    void* address;
+    std::size_t length;
+
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::uint8_t* data() const { return static_cast<const std::uint8_t*>(address); }
+    std::size_t size() const { return length; }
+};
+
+} // namespace MulaWee
@@ -0,0 +1,332 @@
+#include "level_pack.hpp"
+#include "level_validator.hpp"
+#include "temp_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace MulaWee {
+namespace LevelPackFormat {
+
+namespace {
+
+constexpr std::size_t MAX_RUN = 128;
+
+// Bit k of a byte moved to bit 2k: eight open/wall bits as eight 2-bit PATH/WALL cells
+struct SpreadTable {
+    std::uint16_t table[256];
+
+    SpreadTable() {
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            std::uint16_t spread = 0;
+            for (unsigned bit = 0; bit < 8; ++bit) {
+                if (byte & (1u << bit)) {
+                    spread = static_cast<std::uint16_t>(spread | (static_cast<unsigned>(CellType::PATH) << (2 * bit)));
+                }
+            }
+            table[byte] = spread;
+        }
+    }
+};
+
+const SpreadTable SPREAD;
+
+// 0..127: that many plus one literal bytes follow; 129..255: the next byte repeats
+// 257 - n times
+std::vector<std::uint8_t> runLengthEncode(const std::uint8_t* data, std::size_t size) {
+    std::vector<std::uint8_t> out;
+    out.reserve(size + size / 128 + 1);
+    std::size_t i = 0;
+    while (i < size) {
+        std::size_t run = 1;
+        while (i + run < size && run < MAX_RUN && data[i + run] == data[i]) {
+            ++run;
+        }
+        if (run >= 3) {
+            out.push_back(static_cast<std::uint8_t>(257 - run));
+            out.push_back(data[i]);
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of three
+        std::size_t start = i;
+        while (i < size && i - start < MAX_RUN) {
+            if (i + 2 < size && data[i] == data[i + 1] && data[i] == data[i + 2]) {
+                break;
+            }
+            ++i;
+        }
+        out.push_back(static_cast<std::uint8_t>(i - start - 1));
+        out.insert(out.end(), data + start, data + i);
+    }
+    return out;
+}
+
+// False unless the input expands to exactly `outputSize` bytes
+bool runLengthDecode(const std::uint8_t* data, std::size_t size, std::uint8_t* output, std::size_t outputSize) {
+    std::size_t in = 0, out = 0;
+    while (in < size) {
+        std::uint8_t control = data[in++];
+        if (control < 128) {
+            std::size_t count = control + 1u;
+            if (in + count > size || out + count > outputSize) {
+                return false;
+            }
+            std::memcpy(output + out, data + in, count);
+            in += count;
+            out += count;
+        } else if (control > 128) {
+            std::size_t count = 257u - control;
+            if (in >= size || out + count > outputSize) {
+                return false;
+            }
+            std::memset(output + out, data[in++], count);
+            out += count;
+        }
+    }
+    return out == outputSize;
+}
+
+} // namespace
+
+bool compress(const Level& level, std::vector<std::uint8_t>& out) {
+    const PackedGrid& grid = level.getGrid();
+    std::size_t cells = static_cast<std::size_t>(level.getRows()) * level.getCols();
+    const Position& goal = level.getGoalPosition();
+    if (!level.isValidPosition(goal) || level.getCellType(goal) != CellType::GOAL) {
+        return false;
+    }
+
+    std::vector<std::uint8_t> bits((cells + 7) / 8);
+    std::size_t goals = 0;
+    for (std::size_t i = 0; i < cells; ++i) {
+        CellType type = grid.at(i);
+        goals += type == CellType::GOAL;
+        if (type != CellType::WALL) {
+            bits[i >> 3] = static_cast<std::uint8_t>(bits[i >> 3] | (1u << (i & 7)));
+        }
+    }
+    if (goals != 1) {
+        return false;
+    }
+    out = runLengthEncode(bits.data(), bits.size());
+    return true;
+}
+
+bool decompress(const IndexEntry& entry, const std::uint8_t* data, std::uint8_t* grid) {
+    std::size_t cells = static_cast<std::size_t>(entry.rows) * entry.cols;
+    std::vector<std::uint8_t> bits((cells + 7) / 8);
+    if (!runLengthDecode(data, entry.storedBytes, bits.data(), bits.size())) {
+        return false;
+    }
+
+    // Each byte of 8 open/wall bits becomes two grid bytes of PATH/WALL cells
+    std::size_t gridBytes = PackedGrid::bytesFor(entry.rows, entry.cols);
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        std::uint16_t spread = SPREAD.table[bits[i]];
+        grid[2 * i] = static_cast<std::uint8_t>(spread);
+        if (2 * i + 1 < gridBytes) {
+            grid[2 * i + 1] = static_cast<std::uint8_t>(spread >> 8);
+        }
+    }
+    if (entry.goalRow < 0 || entry.goalRow >= entry.rows || entry.goalCol < 0 || entry.goalCol >= entry.cols) {
+        return false;
+    }
+    std::size_t goal = static_cast<std::size_t>(entry.goalRow) * entry.cols + entry.goalCol;
+    grid[goal >> 2] = static_cast<std::uint8_t>((grid[goal >> 2] & ~(3u << ((goal & 3) << 1))) |
+                                                (static_cast<unsigned>(CellType::GOAL) << ((goal & 3) << 1)));
+    return true;
+}
+
+bool isPack(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+} // namespace LevelPackFormat
+
+// LevelPack class implementation
+LevelPack::LevelPack(const std::string& packPath)
+    : path(packPath), mapping(std::make_shared<MappedFile>(packPath)), index(nullptr), count(0),
+      namesOffset(0) {
+    using namespace LevelPackFormat;
+
+    if (mapping->size() < sizeof(Header)) {
+        throw GameException("Truncated level pack " + path);
+    }
+    Header header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw GameException("Not a level pack: " + path);
+    }
+    if (header.version != VERSION || header.entrySize != sizeof(IndexEntry)) {
+        throw GameException("Unsupported level pack version " + std::to_string(header.version) + " in " + path);
+    }
+
+    std::uint64_t fileSize = mapping->size();
+    if (header.indexOffset % alignof(IndexEntry) != 0 || header.indexOffset > fileSize ||
+        header.levelCount > (fileSize - header.indexOffset) / sizeof(IndexEntry) ||
+        header.namesOffset > fileSize) {
+        throw GameException("Truncated level pack index in " + path);
+    }
+    index = reinterpret_cast<const IndexEntry*>(mapping->data() + header.indexOffset);
+    count = header.levelCount;
+
+    // Checked once here, so get() can trust every entry
+    for (std::size_t i = 0; i < count; ++i) {
+        const IndexEntry& entry = index[i];
+        std::string which = "level " + std::to_string(i + 1) + " of " + path;
+        if (entry.rows <= 0 || entry.cols <= 0) {
+            throw GameException("Invalid level dimensions in " + which);
+        }
+        if (entry.offset > fileSize || entry.storedBytes > fileSize - entry.offset ||
+            header.namesOffset + entry.nameOffset + entry.nameLength > fileSize) {
+            throw GameException("Truncated level data in " + which);
+        }
+        if (entry.compression == STORED ? entry.storedBytes != PackedGrid::bytesFor(entry.rows, entry.cols)
+                                        : entry.compression != OPEN_CELLS) {
+            throw GameException("Unsupported level encoding in " + which);
+        }
+        // A stored byte expands to at most 64 bytes of eight cells each
+        if (entry.compression == OPEN_CELLS &&
+            static_cast<std::uint64_t>(entry.rows) * static_cast<std::uint64_t>(entry.cols) > entry.storedBytes * 64 * 8) {
+            throw GameException("Invalid level dimensions in " + which);
+        }
+        if (entry.startRow < 0 || entry.startRow >= entry.rows || entry.startCol < 0 || entry.startCol >= entry.cols ||
+            entry.goalRow < 0 || entry.goalRow >= entry.rows || entry.goalCol < 0 || entry.goalCol >= entry.cols) {
+            throw GameException("Start or goal outside " + which);
+        }
+    }
+    namesOffset = header.namesOffset;
+}
+
+void LevelPack::build(const std::vector<std::string>& levelPaths, const std::string& packPath,
+                      bool compressGrids) {
+    using namespace LevelPackFormat;
+
+    std::vector<IndexEntry> entries(levelPaths.size());
+    std::string names;
+    for (std::size_t i = 0; i < levelPaths.size(); ++i) {
+        std::string name = LevelFormat::levelName(levelPaths[i]);
+        std::memset(&entries[i], 0, sizeof(IndexEntry));
+        entries[i].nameOffset = static_cast<std::uint32_t>(names.size());
+        entries[i].nameLength = static_cast<std::uint16_t>(std::min<std::size_t>(name.size(), 0xffff));
+        names.append(name, 0, entries[i].nameLength);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.levelCount = static_cast<std::uint32_t>(levelPaths.size());
+    header.entrySize = sizeof(IndexEntry);
+    header.indexOffset = sizeof(Header);
+    header.namesOffset = header.indexOffset + entries.size() * sizeof(IndexEntry);
+    header.dataOffset = header.namesOffset + names.size();
+
+    // A temporary file of its own beside the pack, so concurrent builds never share one
+    TempFile temp(packPath);
+
+    // Grids are streamed one level at a time; the index goes in last
+    {
+        std::ofstream file(temp.getPath(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw FileException(temp.getPath());
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+        file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        LevelValidator validator;
+        std::uint64_t offset = header.dataOffset;
+        for (std::size_t i = 0; i < levelPaths.size(); ++i) {
+            Level level(levelPaths[i]);
+            validator.check(level); // A pack only holds playable levels
+            const PackedGrid& grid = level.getGrid();
+            IndexEntry& entry = entries[i];
+            entry.rows = level.getRows();
+            entry.cols = level.getCols();
+            entry.goalRow = level.getGoalPosition().row;
+            entry.goalCol = level.getGoalPosition().col;
+            entry.startRow = level.getStartPosition().row;
+            entry.startCol = level.getStartPosition().col;
+            entry.checksum = level.getChecksum();
+            entry.offset = offset;
+
+            std::vector<std::uint8_t> packed;
+            if (compressGrids && compress(level, packed) && packed.size() < grid.byteSize()) {
+                entry.compression = OPEN_CELLS;
+                entry.storedBytes = packed.size();
+                file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+            } else {
+                entry.compression = STORED;
+                entry.storedBytes = grid.byteSize();
+                file.write(reinterpret_cast<const char*>(grid.data()), static_cast<std::streamsize>(grid.byteSize()));
+            }
+            offset += entry.storedBytes;
+        }
+
+        file.seekp(static_cast<std::streamoff>(header.indexOffset));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+        if (!file.flush()) {
+            throw GameException("Failed to write level pack " + temp.getPath());
+        }
+    }
+    temp.commit();
+}
+
+std::shared_ptr<const Level> LevelPack::get(std::size_t level) {
+    std::shared_ptr<const Level> loaded = load(level);
+    LevelValidator().check(*loaded);
+    return loaded;
+}
+
+std::shared_ptr<const Level> LevelPack::load(std::size_t level) {
+    const LevelPackFormat::IndexEntry& entry = getEntry(level);
+    const std::uint8_t* stored = mapping->data() + entry.offset;
+    std::size_t gridBytes = PackedGrid::bytesFor(entry.rows, entry.cols);
+
+    PackedGrid grid;
+    if (entry.compression == LevelPackFormat::STORED) {
+        // Used in place, like a compiled level
+        grid = PackedGrid(std::shared_ptr<const std::uint8_t>(mapping, stored), entry.rows, entry.cols);
+    } else {
+        std::shared_ptr<std::uint8_t> cells(new std::uint8_t[gridBytes], std::default_delete<std::uint8_t[]>());
+        if (!LevelPackFormat::decompress(entry, stored, cells.get())) {
+            throw GameException("Corrupt level " + std::to_string(level + 1) + " in " + path);
+        }
+        grid = PackedGrid(std::shared_ptr<const std::uint8_t>(cells), entry.rows, entry.cols);
+    }
+
+    auto loaded = std::make_shared<const Level>(std::move(grid), Position(entry.startRow, entry.startCol),
+                                                Position(entry.goalRow, entry.goalCol),
+                                                path + ":" + getName(level));
+    if (loaded->getChecksum() != entry.checksum) {
+        throw GameException("Checksum mismatch for level " + std::to_string(level + 1) + " in " + path);
+    }
+    return loaded;
+}
+
+const LevelPackFormat::IndexEntry& LevelPack::getEntry(std::size_t level) const {
+    if (level >= count) {
+        throw GameException("No level " + std::to_string(level + 1) + " in " + path);
+    }
+    return index[level];
+}
+
+std::string LevelPack::getName(std::size_t level) const {
+    const LevelPackFormat::IndexEntry& entry = getEntry(level);
+    const char* names = reinterpret_cast<const char*>(mapping->data() + namesOffset);
+    return std::string(names + entry.nameOffset, entry.nameLength);
+}
+
+} // namespace MulaWee
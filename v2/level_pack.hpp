@@ -0,0 +1,110 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "level_format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// Level pack format (.mwpk) - many levels in one file
+//
+//   offset          size         field
+//        0            64         header
+//       64     count * 64        index, one entry per level in play order
+//        -             -         level names (not terminated; see the entry)
+//        -             -         level grids, each stored raw or compressed
+//
+// Level N's entry sits at a fixed offset, so any level is found without reading the
+// others, and a raw grid is used in place from the mapping. A compressed grid keeps
+// one bit per cell (open or wall; the single goal cell comes from the entry) and
+// run-length codes those bits, PackBits style; levels it cannot describe, or does
+// not shrink, are stored raw.
+namespace LevelPackFormat {
+
+constexpr char MAGIC[4] = {'M', 'W', 'P', 'K'};
+constexpr std::uint16_t VERSION = 1;
+constexpr const char* EXTENSION = ".mwpk";
+
+enum Compression : std::uint8_t {
+    STORED = 0,
+    OPEN_CELLS = 1
+};
+
+struct Header {
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t headerSize;
+    std::uint32_t levelCount;
+    std::uint32_t entrySize;
+    std::uint64_t indexOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t dataOffset;
+    std::uint8_t reserved[24];
+};
+
+struct IndexEntry {
+    std::uint64_t offset;      // Of the stored grid, from the start of the file
+    std::uint64_t storedBytes;
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t goalRow;
+    std::int32_t goalCol;
+    std::int32_t startRow;
+    std::int32_t startCol;
+    std::uint32_t checksum;    // FNV-1a of the unpacked grid, as in the compiled format
+    std::uint32_t nameOffset;  // From namesOffset
+    std::uint16_t nameLength;
+    std::uint8_t compression;
+    std::uint8_t reserved[13];
+};
+
+static_assert(sizeof(Header) == 64, "level pack header must stay 64 bytes");
+static_assert(sizeof(IndexEntry) == 64, "level pack index entry must stay 64 bytes");
+
+// The OPEN_CELLS form of a level; false if it has other than one goal cell
+bool compress(const Level& level, std::vector<std::uint8_t>& out);
+
+// Unpack an OPEN_CELLS grid into PackedGrid::bytesFor(rows, cols) bytes; false if
+// the data is corrupt
+bool decompress(const IndexEntry& entry, const std::uint8_t* data, std::uint8_t* grid);
+
+// True if the file starts with the level pack magic
+bool isPack(const std::string& path);
+
+} // namespace LevelPackFormat
+
+// A mapped level pack; also a LevelSource, so a GameSession can play it directly
+class LevelPack : public LevelSource {
+private:
+    std::string path;
+    std::shared_ptr<MappedFile> mapping;
+    const LevelPackFormat::IndexEntry* index;
+    std::size_t count;
+    std::uint64_t namesOffset;
+
+public:
+    // Maps the pack and checks the header and every index entry against its size
+    explicit LevelPack(const std::string& packPath);
+
+    // Write the levels (text or compiled level files) as a pack, via a temporary file;
+    // throws GameException at the first one LevelValidator finds unplayable
+    static void build(const std::vector<std::string>& levelPaths, const std::string& packPath,
+                      bool compressGrids = true);
+
+    std::size_t size() const override { return count; }
+    // The level checked with LevelValidator as well as its checksum, so nothing unplayable
+    // reaches a game; throws GameException if it fails either
+    std::shared_ptr<const Level> get(std::size_t level) override;
+    // Checksum only, for the pack tools that report or extract broken levels
+    std::shared_ptr<const Level> load(std::size_t level);
+
+    const LevelPackFormat::IndexEntry& getEntry(std::size_t level) const;
+    std::string getName(std::size_t level) const;
+    const std::string& getPath() const { return path; }
+};
+
+} // namespace MulaWee
@@ -0,0 +1,355 @@
+#include "level_validator.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define MULAVEE_HAVE_AVX2 1
+#endif
+
+namespace MulaWee {
+
+namespace {
+
+// Spread reached bits along the open bits of one word, toward bit 63 and toward bit 0
+// (Kogge-Stone occluded fill: six shift/AND/OR steps cover any run in the word)
+inline std::uint64_t fillUp(std::uint64_t reached, std::uint64_t open) {
+    reached |= open & (reached << 1);
+    open &= open << 1;
+    reached |= open & (reached << 2);
+    open &= open << 2;
+    reached |= open & (reached << 4);
+    open &= open << 4;
+    reached |= open & (reached << 8);
+    open &= open << 8;
+    reached |= open & (reached << 16);
+    open &= open << 16;
+    return reached | (open & (reached << 32));
+}
+
+inline std::uint64_t fillDown(std::uint64_t reached, std::uint64_t open) {
+    reached |= open & (reached >> 1);
+    open &= open >> 1;
+    reached |= open & (reached >> 2);
+    open &= open >> 2;
+    reached |= open & (reached >> 4);
+    open &= open >> 4;
+    reached |= open & (reached >> 8);
+    open &= open >> 8;
+    reached |= open & (reached >> 16);
+    open &= open >> 16;
+    return reached | (open & (reached >> 32));
+}
+
+inline std::uint64_t fillRun(std::uint64_t reached, std::uint64_t open) {
+    return fillDown(fillUp(reached, open), open);
+}
+
+constexpr std::uint64_t TOP_BIT = std::uint64_t(1) << 63;
+constexpr std::uint64_t EVEN_BITS = 0x5555555555555555ULL; // Low bit of each packed cell
+
+// Bits 0, 2, 4, ... of `bits` packed into the low 32 bits
+inline std::uint32_t compactEvenBits(std::uint64_t bits) {
+    bits = (bits | bits >> 1) & 0x3333333333333333ULL;
+    bits = (bits | bits >> 2) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | bits >> 4) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | bits >> 8) & 0x0000FFFF0000FFFFULL;
+    return static_cast<std::uint32_t>(bits | bits >> 16);
+}
+
+std::size_t countBits(const std::vector<std::uint64_t>& bits) {
+    std::size_t count = 0;
+    for (std::uint64_t word : bits) {
+        count += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return count;
+}
+
+#ifdef MULAVEE_HAVE_AVX2
+__attribute__((target("avx2"))) inline __m256i fillUp4(__m256i reached, __m256i open) {
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 1)));
+    open = _mm256_and_si256(open, _mm256_slli_epi64(open, 1));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 2)));
+    open = _mm256_and_si256(open, _mm256_slli_epi64(open, 2));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 4)));
+    open = _mm256_and_si256(open, _mm256_slli_epi64(open, 4));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 8)));
+    open = _mm256_and_si256(open, _mm256_slli_epi64(open, 8));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 16)));
+    open = _mm256_and_si256(open, _mm256_slli_epi64(open, 16));
+    return _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_slli_epi64(reached, 32)));
+}
+
+__attribute__((target("avx2"))) inline __m256i fillDown4(__m256i reached, __m256i open) {
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 1)));
+    open = _mm256_and_si256(open, _mm256_srli_epi64(open, 1));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 2)));
+    open = _mm256_and_si256(open, _mm256_srli_epi64(open, 2));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 4)));
+    open = _mm256_and_si256(open, _mm256_srli_epi64(open, 4));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 8)));
+    open = _mm256_and_si256(open, _mm256_srli_epi64(open, 8));
+    reached = _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 16)));
+    open = _mm256_and_si256(open, _mm256_srli_epi64(open, 16));
+    return _mm256_or_si256(reached, _mm256_and_si256(open, _mm256_srli_epi64(reached, 32)));
+}
+
+// LevelValidator::spreadGroup for four words at once: new seeds from the rows above
+// and below, spread along the runs of each word; false if nothing was new
+__attribute__((target("avx2"))) bool spreadFourWords(std::uint64_t* row, const std::uint64_t* above,
+                                                     const std::uint64_t* below, const std::uint64_t* open,
+                                                     std::uint64_t* added) {
+    __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+    __m256i seeds = _mm256_setzero_si256();
+    if (above) {
+        seeds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(above));
+    }
+    if (below) {
+        seeds = _mm256_or_si256(seeds, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below)));
+    }
+    __m256i openBits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(open));
+    seeds = _mm256_andnot_si256(current, _mm256_and_si256(seeds, openBits));
+    if (_mm256_testz_si256(seeds, seeds)) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(added), seeds);
+        return false;
+    }
+    __m256i filled = fillDown4(fillUp4(_mm256_or_si256(current, seeds), openBits), openBits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(row), filled);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(added), _mm256_andnot_si256(current, filled));
+    return true;
+}
+#endif
+
+} // namespace
+
+std::vector<std::string> LevelReport::problems() const {
+    std::vector<std::string> out;
+    if (!startOpen) {
+        out.push_back("start is outside the level or in a wall");
+    }
+    if (goals == 0) {
+        out.push_back("no goal");
+    } else if (goals > 1) {
+        out.push_back(std::to_string(goals) + " goals");
+    }
+    if (startOpen && goals > 0 && !goalReachable) {
+        out.push_back("goal unreachable from the start");
+    }
+    if (unreachableRegions > 0) {
+        out.push_back(std::to_string(openCells - reachableCells) + " open cells in " +
+                      (unreachableRegions >= LevelValidator::MAX_REGIONS ? "at least " : "") +
+                      std::to_string(unreachableRegions) + " regions unreachable from the start");
+    }
+    if (unknownCells > 0) {
+        out.push_back(std::to_string(unknownCells) + " unknown characters read as walls");
+    }
+    return out;
+}
+
+// LevelValidator class implementation
+LevelValidator::LevelValidator(bool allowAvx2)
+    : head(0), size(0), rows(0), words(0), groupWords(1), groups(0), avx2(allowAvx2 && cpuHasAvx2()) {}
+
+bool LevelValidator::cpuHasAvx2() {
+#ifdef MULAVEE_HAVE_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+LevelReport LevelValidator::validate(const Level& level) {
+    LevelReport report;
+    report.unknownCells = level.getUnknownCells();
+    loadCells(level, report);
+
+    const Position& start = level.getStartPosition();
+    report.startOpen = level.canMoveTo(start);
+    if (!report.startOpen) {
+        return report;
+    }
+
+    reached.assign(open.size(), 0);
+    fill(start.row, start.col, report.groupUpdates);
+    report.reachableCells = countBits(reached);
+    const Position& goal = level.getGoalPosition();
+    report.goalReachable = level.isValidPosition(goal) && level.getCellType(goal) == CellType::GOAL &&
+                           ((reached[static_cast<std::size_t>(goal.row) * words + goal.col / 64] >>
+                             (goal.col % 64)) & 1);
+
+    // Fill each cut-off region in turn from its first open cell. Regions never touch,
+    // so each fill only adds its own region to the bits already reached.
+    std::size_t next = 0;
+    while (report.unreachableRegions < MAX_REGIONS) {
+        while (next < open.size() && (open[next] & ~reached[next]) == 0) {
+            ++next;
+        }
+        if (next == open.size()) {
+            break;
+        }
+        int bit = __builtin_ctzll(open[next] & ~reached[next]);
+        fill(static_cast<int>(next / words), static_cast<int>(next % words) * 64 + bit, report.groupUpdates);
+        ++report.unreachableRegions;
+    }
+    return report;
+}
+
+void LevelValidator::check(const Level& level) {
+    LevelReport report = validate(level);
+    if (report.isPlayable()) {
+        return;
+    }
+    std::string message = "Unplayable level " + level.getFilename() + ":";
+    for (const std::string& problem : report.problems()) {
+        message += " " + problem + ";";
+    }
+    message.pop_back();
+    throw GameException(message);
+}
+
+void LevelValidator::loadCells(const Level& level, LevelReport& report) {
+    rows = level.getRows();
+    words = (level.getCols() + 63) / 64;
+    groupWords = avx2 && words >= 4 ? 4 : 1;
+    groups = (words + groupWords - 1) / groupWords;
+    const int cols = level.getCols();
+
+    // Packed cells to one open bit per cell, 32 cells per 64-bit load; the padding
+    // after the last cell is zero, a wall
+    const PackedGrid& grid = level.getGrid();
+    const std::size_t bytes = grid.byteSize();
+    dense.assign(bytes / 8 + 2, 0);
+    for (std::size_t i = 0; i < bytes; i += 8) {
+        std::uint64_t cells = 0;
+        std::memcpy(&cells, grid.data() + i, std::min<std::size_t>(8, bytes - i));
+        report.goals += __builtin_popcountll((cells >> 1) & ~cells & EVEN_BITS);
+        std::uint32_t half = compactEvenBits((cells | cells >> 1) & EVEN_BITS);
+        dense[i / 16] |= static_cast<std::uint64_t>(half) << (i % 16 * 4);
+    }
+
+    // Then each row out of the stream into its own words
+    open.assign(static_cast<std::size_t>(rows) * words, 0);
+    for (int r = 0; r < rows; ++r) {
+        std::uint64_t* row = &open[static_cast<std::size_t>(r) * words];
+        for (int j = 0; j < words; ++j) {
+            std::size_t bit = static_cast<std::size_t>(r) * cols + j * 64;
+            std::uint64_t value = dense[bit / 64] >> (bit % 64);
+            if (bit % 64 != 0) {
+                value |= dense[bit / 64 + 1] << (64 - bit % 64);
+            }
+            int left = cols - j * 64;
+            row[j] = left >= 64 ? value : value & ((std::uint64_t(1) << left) - 1);
+        }
+    }
+    report.openCells = countBits(open);
+}
+
+void LevelValidator::fill(int row, int col, std::size_t& groupUpdates) {
+    // The seed is spread along its own word first and then handed on like any other
+    // change: its word's group is requeued for the carries and the groups above and
+    // below take the new bits
+    std::size_t word = static_cast<std::size_t>(row) * words + col / 64;
+    std::uint64_t before = reached[word];
+    reached[word] = fillRun(before | std::uint64_t(1) << (col % 64), open[word]);
+
+    queue.resize(static_cast<std::size_t>(rows) * groups);
+    queued.assign(queue.size(), 0);
+    head = 0;
+    size = 0;
+    int group = col / 64 / groupWords;
+    push(row, group);
+    changed(row, group, col / 64 == group * groupWords ? reached[word] & ~before : 0,
+            col / 64 == std::min(words, (group + 1) * groupWords) - 1 ? reached[word] & ~before : 0);
+
+    while (size > 0) {
+        std::uint32_t item = queue[head];
+        head = head + 1 == queue.size() ? 0 : head + 1;
+        --size;
+        queued[item] = 0;
+        ++groupUpdates;
+        spreadGroup(static_cast<int>(item / groups), static_cast<int>(item % groups));
+    }
+}
+
+void LevelValidator::push(int row, int group) {
+    if (row < 0 || row >= rows || group < 0 || group >= groups) {
+        return;
+    }
+    std::uint32_t item = static_cast<std::uint32_t>(row) * groups + group;
+    if (!queued[item]) {
+        queued[item] = 1;
+        std::size_t tail = head + size;
+        queue[tail >= queue.size() ? tail - queue.size() : tail] = item;
+        ++size;
+    }
+}
+
+void LevelValidator::changed(int row, int group, std::uint64_t firstAdded, std::uint64_t lastAdded) {
+    push(row - 1, group);
+    push(row + 1, group);
+    // A run that reaches the edge of the group may go on in the next word
+    if (firstAdded & 1) {
+        push(row, group - 1);
+    }
+    if (lastAdded & TOP_BIT) {
+        push(row, group + 1);
+    }
+}
+
+void LevelValidator::spreadGroup(int r, int g) {
+    const int first = g * groupWords;
+    const int last = std::min(words, first + groupWords); // One past
+    std::uint64_t* row = &reached[static_cast<std::size_t>(r) * words];
+    const std::uint64_t* above = r > 0 ? row - words : nullptr;
+    const std::uint64_t* below = r + 1 < rows ? row + words : nullptr;
+    const std::uint64_t* openRow = &open[static_cast<std::size_t>(r) * words];
+
+    std::uint64_t added[4] = {0, 0, 0, 0};
+    bool any = false;
+#ifdef MULAVEE_HAVE_AVX2
+    if (last - first == 4) {
+        any = spreadFourWords(row + first, above ? above + first : nullptr, below ? below + first : nullptr,
+                              openRow + first, added);
+    } else
+#endif
+    {
+        for (int j = first; j < last; ++j) {
+            std::uint64_t seeds = ((above ? above[j] : 0) | (below ? below[j] : 0)) & openRow[j] & ~row[j];
+            if (seeds != 0) {
+                std::uint64_t filled = fillRun(row[j] | seeds, openRow[j]);
+                added[j - first] = filled & ~row[j];
+                row[j] = filled;
+                any = true;
+            }
+        }
+    }
+
+    // Runs crossing a word boundary: in from the neighbouring groups' edge words, then
+    // between the words of this group in both directions
+    auto carry = [&](int from, int to, std::uint64_t fromBit, std::uint64_t toBit) {
+        if ((row[from] & fromBit) && (openRow[to] & toBit) && !(row[to] & toBit)) {
+            std::uint64_t filled = fillRun(row[to] | toBit, openRow[to]);
+            added[to - first] |= filled & ~row[to];
+            row[to] = filled;
+            any = true;
+        }
+    };
+    if (first > 0) {
+        carry(first - 1, first, TOP_BIT, 1);
+    }
+    if (last < words) {
+        carry(last, last - 1, 1, TOP_BIT);
+    }
+    for (int j = first; j + 1 < last; ++j) {
+        carry(j, j + 1, TOP_BIT, 1);
+    }
+    for (int j = last - 1; j > first; --j) {
+        carry(j, j - 1, 1, TOP_BIT);
+    }
+
+    if (any) {
+        changed(r, g, added[0], added[last - 1 - first]);
+    }
+}
+
+} // namespace MulaWee
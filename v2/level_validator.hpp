@@ -0,0 +1,72 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// What LevelValidator found in one level
+struct LevelReport {
+    std::size_t goals = 0;
+    bool startOpen = false;              // Inside the level and not a wall
+    bool goalReachable = false;          // From the start
+    std::size_t openCells = 0;
+    std::size_t reachableCells = 0;      // From the start
+    std::size_t unreachableRegions = 0;  // Open areas cut off from the start, at most MAX_REGIONS
+    std::size_t unknownCells = 0;        // Text cells other than * $ | %, read as walls
+    std::size_t groupUpdates = 0;        // Work done by the fills
+
+    // Start open, exactly one goal, and the goal reachable
+    bool isPlayable() const { return startOpen && goals == 1 && goalReachable; }
+
+    // One line per problem, errors first; empty when there are none
+    std::vector<std::string> problems() const;
+};
+
+// Checks that a level can be played, on bitboards. Each row is stored as 64-bit words
+// of open-cell bits, and the flood fill from the start works on groups of words (one,
+// or four with AVX2): a group takes the bits newly reached in the same words of the
+// rows above and below, spreads them along its open runs with shift/AND/OR steps, and
+// queues its neighbours when it changed, until nothing does. Work follows the front of
+// the fill, so a narrow maze costs about as much as a cell-by-cell search would and a
+// wide open area goes 64 or 256 cells a step.
+class LevelValidator {
+private:
+    std::vector<std::uint64_t> open;     // rows * words; bit c % 64 of word c / 64
+    std::vector<std::uint64_t> reached;  // Every fill so far
+    std::vector<std::uint64_t> dense;    // Open bits of all cells back to back, while loading
+    std::vector<std::uint32_t> queue;    // Groups to update (row * groups + group), circular
+    std::vector<std::uint8_t> queued;
+    std::size_t head, size;
+    int rows;
+    int words;                           // Per row
+    int groupWords;                      // Words updated together
+    int groups;                          // Per row
+    bool avx2;
+
+public:
+    static constexpr std::size_t MAX_REGIONS = 1000;
+
+    // AVX2 is used when `allowAvx2` and the CPU has it
+    explicit LevelValidator(bool allowAvx2 = true);
+
+    LevelReport validate(const Level& level);
+
+    // Throws GameException naming the level and its problems unless it is playable
+    void check(const Level& level);
+
+    bool usesAvx2() const { return avx2; }
+    static bool cpuHasAvx2();
+
+private:
+    void loadCells(const Level& level, LevelReport& report);
+    void fill(int row, int col, std::size_t& groupUpdates);
+    void push(int row, int group);
+    void changed(int row, int group, std::uint64_t firstAdded, std::uint64_t lastAdded);
+    void spreadGroup(int row, int group);
+};
+
+} // namespace MulaWee
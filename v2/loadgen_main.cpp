@@ -0,0 +1,291 @@
+#include "game_core.hpp"
+#include "latency.hpp"
+#include "level_format.hpp"
+#include "maze_solver.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Load generator for mulavee_server
+//
+//   mulavee_loadgen [--host ADDR] [--port N] [--idle N] [--active N] [--rate K]
+//                   [--seconds S] [--data DIR] [--spectate-port N] [--spectators N]
+//                   [--stalled N]
+//
+// Opens N idle sessions that only take their welcome screen, and N active ones that
+// play the shipped levels along their shortest paths, round after round, at K keys per
+// second each. An active session sends its next key only once the previous one has
+// been answered, so the reported latency is keypress to screen update on the wire.
+// Spectators press Enter on the spectator port to watch a game and read everything;
+// stalled ones do the same and then never read, to show they do not slow the players.
+
+namespace {
+
+using namespace MulaWee;
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--host ADDR] [--port N] [--idle N] [--active N] [--rate K]"
+              << " [--seconds S] [--data DIR] [--spectate-port N] [--spectators N] [--stalled N]" << std::endl;
+}
+
+void raiseDescriptorLimit() {
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+char directionKey(const Position& from, const Position& to) {
+    if (to.row < from.row) return 'w';
+    if (to.row > from.row) return 's';
+    if (to.col < from.col) return 'a';
+    return 'd';
+}
+
+// Keys for one full round: name, each level's shortest path and the key that
+// dismisses its "complete" screen, then "play again"
+std::string roundScript(const std::string& dataDir) {
+    std::string script = "bot\r";
+    MazeSolver solver;
+    for (int i = 1; i <= 3; ++i) {
+        std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+        std::string compiled = LevelFormat::compiledPathFor(path);
+        Level level(LevelFormat::isCompiled(compiled) ? compiled : path);
+        SolveResult result = solver.solve(SolverAlgorithm::BFS, level);
+        if (!result.found) {
+            throw GameException("Level " + std::to_string(i) + " has no route to its goal");
+        }
+        for (std::size_t step = 1; step < result.path.size(); ++step) {
+            script += directionKey(result.path[step - 1], result.path[step]);
+        }
+        script += 'x';
+    }
+    return script + 'y';
+}
+
+int connectTo(const sockaddr_in& address) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw GameException(std::string("socket: ") + std::strerror(errno));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(fd);
+        throw GameException("Cannot connect: " + error);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ::fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+struct Client {
+    int fd = -1;
+    bool active = false;
+    bool spectator = false;
+    bool waiting = true;        // Sent a key (or connected) and no answer yet
+    bool greeted = false;       // Welcome screen arrived
+    std::size_t next = 0;       // Position in the round script
+    std::uint64_t sentAt = 0;
+    std::uint64_t due = 0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    std::string dataDir = "../data";
+    int port = 7777;
+    int spectatePort = 7778;
+    std::size_t idle = 0;
+    std::size_t spectators = 0;
+    std::size_t stalled = 0;
+    std::size_t active = 100;
+    double rate = 10;
+    double seconds = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+            host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--idle") == 0 && hasValue) {
+            idle = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--active") == 0 && hasValue) {
+            active = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+            rate = std::max(0.1, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--spectate-port") == 0 && hasValue) {
+            spectatePort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spectators") == 0 && hasValue) {
+            spectators = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--stalled") == 0 && hasValue) {
+            stalled = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        std::string script = roundScript(dataDir);
+        raiseDescriptorLimit();
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+            throw GameException("Bad address: " + host);
+        }
+
+        int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        std::vector<Client> clients(idle + active);
+        std::uint64_t connectStart = latencyNow();
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client& client = clients[i];
+            client.fd = connectTo(address);
+            client.active = i >= idle;
+            client.sentAt = latencyNow();
+            epoll_event event;
+            std::memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+        }
+        double connectSeconds = static_cast<double>(latencyNow() - connectStart) / 1e9;
+
+        // Viewers join once the games exist; Enter alone watches one of them
+        sockaddr_in spectateAddress = address;
+        spectateAddress.sin_port = htons(static_cast<std::uint16_t>(spectatePort));
+        std::vector<int> stalledFds;
+        for (std::size_t i = 0; i < spectators + stalled; ++i) {
+            int fd = connectTo(spectateAddress);
+            char enter = '\r';
+            if (::send(fd, &enter, 1, MSG_NOSIGNAL) != 1) {
+                throw GameException("Cannot choose a game to watch");
+            }
+            if (i >= spectators) {
+                stalledFds.push_back(fd);
+                continue;
+            }
+            Client viewer;
+            viewer.fd = fd;
+            viewer.spectator = true;
+            clients.push_back(viewer);
+            epoll_event event;
+            std::memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.u64 = clients.size() - 1;
+            ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+
+        // Active sessions start spread over one key interval, so keys do not arrive in waves
+        std::uint64_t interval = static_cast<std::uint64_t>(1e9 / rate);
+        std::uint64_t start = latencyNow();
+        std::uint64_t end = start + static_cast<std::uint64_t>(seconds * 1e9);
+        std::mt19937_64 random(42);
+        for (Client& client : clients) {
+            client.due = start + random() % interval;
+        }
+
+        LatencyHistogram latency;
+        std::size_t keysSent = 0, rounds = 0, greeted = 0, closed = 0;
+        std::uint64_t bytesReceived = 0, spectatorBytes = 0;
+        std::vector<epoll_event> events(1024);
+        char buffer[16384];
+
+        while (latencyNow() < end) {
+            int count = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 1);
+            std::uint64_t now = latencyNow();
+            for (int e = 0; e < count; ++e) {
+                Client& client = clients[events[e].data.u64];
+                ssize_t got;
+                while ((got = ::read(client.fd, buffer, sizeof(buffer))) > 0) {
+                    (client.spectator ? spectatorBytes : bytesReceived) += static_cast<std::uint64_t>(got);
+                }
+                if (got == 0) {
+                    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+                    client.waiting = true; // Never send to it again
+                    client.active = false;
+                    ++closed;
+                    continue;
+                }
+                if (!client.waiting || client.spectator) {
+                    continue;
+                }
+                if (!client.greeted) {
+                    client.greeted = true;
+                    ++greeted;
+                } else {
+                    latency.record(now - client.sentAt);
+                }
+                client.waiting = false;
+            }
+
+            for (Client& client : clients) {
+                if (!client.active || client.waiting || now < client.due) {
+                    continue;
+                }
+                char key = script[client.next];
+                if (::send(client.fd, &key, 1, MSG_NOSIGNAL) != 1) {
+                    continue;
+                }
+                client.next = (client.next + 1) % script.size();
+                rounds += client.next == 0;
+                client.waiting = true;
+                client.sentAt = now;
+                client.due = std::max(client.due + interval, now - interval); // Catch up, but not in a burst
+                ++keysSent;
+            }
+        }
+        double elapsed = static_cast<double>(latencyNow() - start) / 1e9;
+
+        std::cout << idle + active << " sessions (" << idle << " idle, " << active << " active) connected in "
+                  << std::fixed << std::setprecision(2) << connectSeconds << " s; " << greeted << " greeted, "
+                  << closed << " closed by the server" << std::endl;
+        std::cout << keysSent << " keys in " << elapsed << " s (" << std::setprecision(0)
+                  << keysSent / elapsed << " keys/s), " << rounds << " full games, " << bytesReceived
+                  << " bytes received" << std::endl;
+        std::cout << std::setprecision(1) << "key to screen: p50 " << latency.percentile(0.50) / 1e3
+                  << " us, p99 " << latency.percentile(0.99) / 1e3 << " us, p999 "
+                  << latency.percentile(0.999) / 1e3 << " us, max " << latency.getMax() / 1e3 << " us"
+                  << std::endl;
+        if (spectators + stalled > 0) {
+            std::cout << spectators << " spectators received " << spectatorBytes << " bytes ("
+                      << std::setprecision(0) << spectatorBytes / elapsed / 1e3 << " KB/s), " << stalled
+                      << " stalled" << std::endl;
+        }
+
+        for (Client& client : clients) {
+            ::close(client.fd);
+        }
+        for (int fd : stalledFds) {
+            ::close(fd);
+        }
+        ::close(epollFd);
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,9 +1,38 @@
 #include "optimized_game.hpp"
+#include "ncurses_backend.hpp"
+#include <cstring>
 #include <iostream>
 
-int main() {
+//   mulavee_optimized [--latency FILE] [--replays DIR] [--pack FILE | --embedded]
+//       --latency writes keypress-to-screen percentiles per stage to FILE on exit
+//       --replays saves every run to DIR as a compact replay (see mulavee_replay)
+//       --pack plays the levels in a level pack (see mulavee_pack) instead of ../data
+//       --embedded plays the levels built into the binary and reads no level files
+
+int main(int argc, char* argv[]) {
+    MulaWee::GameOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            options.latencyFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--replays") == 0 && i + 1 < argc) {
+            options.replayDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            options.levelPack = argv[++i];
+        } else if (std::strcmp(argv[i], "--embedded") == 0) {
+            options.embeddedLevels = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--latency FILE] [--replays DIR] [--pack FILE | --embedded]"
+                      << std::endl;
+            return 2;
+        }
+    }
+
     try {
-        MulaWee::Game game;
+        // Only changed cells reach ncurses; clear() no longer forces a full repaint
+        auto renderer = std::make_unique<MulaWee::DiffRenderer>(
+            std::make_unique<MulaWee::NCursesRenderer>());
+        auto input = std::make_unique<MulaWee::NCursesInput>();
+        MulaWee::Game game(std::move(renderer), std::move(input), options);
         game.run();
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
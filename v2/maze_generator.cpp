@@ -0,0 +1,576 @@
+#include "maze_generator.hpp"
+#include "level_format.hpp"
+#include "level_validator.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace MulaWee {
+
+namespace {
+
+// splitmix64 finalizer: turns (seed, stream ids) into well-spread stream seeds
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t a, std::uint64_t b = 0) {
+    return mix(seed ^ mix(a * 0x9E3779B97F4A7C15ull + b));
+}
+
+// Stream ids so different uses of one seed never share random numbers
+enum : std::uint64_t {
+    STREAM_TILE = 1,
+    STREAM_TILE_TREE = 2,
+    STREAM_TILE_DOOR = 3,
+    STREAM_BAND = 4,
+    STREAM_BAND_DOOR = 5
+};
+
+// xorshift64*
+class MazeRandom {
+private:
+    std::uint64_t state;
+
+public:
+    explicit MazeRandom(std::uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    std::uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    std::uint32_t below(std::uint32_t bound) {
+        return static_cast<std::uint32_t>((next() >> 32) % bound);
+    }
+
+    bool coin() { return (next() >> 63) != 0; }
+};
+
+// Per-cell flags while carving one tile
+const std::uint8_t OPEN_EAST = 1;
+const std::uint8_t OPEN_SOUTH = 2;
+const std::uint8_t IN_MAZE = 4;
+
+const int ROW_STEP[4] = {-1, 1, 0, 0};
+const int COL_STEP[4] = {0, 0, -1, 1};
+
+struct Tile {
+    int rowStart, colStart; // In cells
+    int rows, cols;
+    std::vector<std::uint8_t> flags;
+
+    bool neighbor(int cell, int dir, int& next) const {
+        int r = cell / cols + ROW_STEP[dir];
+        int c = cell % cols + COL_STEP[dir];
+        if (r < 0 || r >= rows || c < 0 || c >= cols) {
+            return false;
+        }
+        next = r * cols + c;
+        return true;
+    }
+
+    void carve(int cell, int next, int dir) {
+        switch (dir) {
+            case 0: flags[next] |= OPEN_SOUTH; break; // up
+            case 1: flags[cell] |= OPEN_SOUTH; break; // down
+            case 2: flags[next] |= OPEN_EAST; break;  // left
+            case 3: flags[cell] |= OPEN_EAST; break;  // right
+        }
+    }
+};
+
+void carveBacktracker(Tile& tile, MazeRandom& rng) {
+    int count = tile.rows * tile.cols;
+    std::vector<int> stack;
+    stack.reserve(static_cast<std::size_t>(count));
+
+    int first = static_cast<int>(rng.below(static_cast<std::uint32_t>(count)));
+    tile.flags[first] |= IN_MAZE;
+    stack.push_back(first);
+
+    while (!stack.empty()) {
+        int cell = stack.back();
+        int options[4], targets[4];
+        int found = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            int next = cell;
+            if (tile.neighbor(cell, dir, next) && !(tile.flags[next] & IN_MAZE)) {
+                options[found] = dir;
+                targets[found++] = next;
+            }
+        }
+        if (found == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int pick = static_cast<int>(rng.below(static_cast<std::uint32_t>(found)));
+        tile.carve(cell, targets[pick], options[pick]);
+        tile.flags[targets[pick]] |= IN_MAZE;
+        stack.push_back(targets[pick]);
+    }
+}
+
+void carveWilson(Tile& tile, MazeRandom& rng) {
+    int count = tile.rows * tile.cols;
+    std::vector<std::uint8_t> exitDir(static_cast<std::size_t>(count), 0);
+    tile.flags[rng.below(static_cast<std::uint32_t>(count))] |= IN_MAZE;
+
+    for (int start = 0; start < count; ++start) {
+        if (tile.flags[start] & IN_MAZE) {
+            continue;
+        }
+
+        // Random walk until the maze is hit; overwriting exits erases loops
+        int cell = start;
+        while (!(tile.flags[cell] & IN_MAZE)) {
+            int dir, next = cell;
+            do {
+                dir = static_cast<int>(rng.below(4));
+            } while (!tile.neighbor(cell, dir, next));
+            exitDir[cell] = static_cast<std::uint8_t>(dir);
+            cell = next;
+        }
+
+        // Carve the loop-erased path
+        cell = start;
+        while (!(tile.flags[cell] & IN_MAZE)) {
+            int next = cell;
+            tile.neighbor(cell, exitDir[cell], next);
+            tile.carve(cell, next, exitDir[cell]);
+            tile.flags[cell] |= IN_MAZE;
+            cell = next;
+        }
+    }
+}
+
+char cellChar(CellType type) {
+    switch (type) {
+        case CellType::PATH: return '*';
+        case CellType::GOAL: return '$';
+        case CellType::WALL:
+        default:             return '|';
+    }
+}
+
+// Collects streamed rows into a PackedGrid
+class GridSink : public MazeRowSink {
+private:
+    PackedGrid& grid;
+    int row;
+
+public:
+    explicit GridSink(PackedGrid& target) : grid(target), row(0) {}
+
+    void writeRow(const char* cells, int cols) override {
+        for (int c = 0; c < cols; ++c) {
+            if (cells[c] == '*') {
+                grid.set(row, c, CellType::PATH);
+            } else if (cells[c] == '$') {
+                grid.set(row, c, CellType::GOAL);
+            }
+        }
+        ++row;
+    }
+};
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+const char* mazeAlgorithmName(MazeAlgorithm algorithm) {
+    switch (algorithm) {
+        case MazeAlgorithm::BACKTRACKER: return "backtracker";
+        case MazeAlgorithm::WILSON: return "wilson";
+        case MazeAlgorithm::ELLER: return "eller";
+    }
+    return "unknown";
+}
+
+bool parseMazeAlgorithm(const std::string& name, MazeAlgorithm& algorithm) {
+    if (name == "backtracker") { algorithm = MazeAlgorithm::BACKTRACKER; return true; }
+    if (name == "wilson") { algorithm = MazeAlgorithm::WILSON; return true; }
+    if (name == "eller") { algorithm = MazeAlgorithm::ELLER; return true; }
+    return false;
+}
+
+Position MazeSpec::start() const {
+    Position start = Level::defaultStart();
+    return gridRows() > start.row + 1 ? start : Position(gridRows() - 2, 1);
+}
+
+// TextLevelSink implementation
+TextLevelSink::TextLevelSink(const std::string& levelPath, int rows, int cols)
+    : path(levelPath), temp(levelPath), file(temp.getPath(), std::ios::trunc) {
+    if (!file.is_open()) {
+        throw FileException(temp.getPath());
+    }
+    file << rows << ' ' << cols << '\n';
+}
+
+void TextLevelSink::writeRow(const char* cells, int cols) {
+    file.write(cells, cols);
+    file.put('\n');
+}
+
+void TextLevelSink::finish() {
+    file.close();
+    if (!file) {
+        throw GameException("Failed to write level " + path);
+    }
+    LevelValidator().check(Level(temp.getPath())); // As the game will read it back
+    temp.commit();
+}
+
+// CompiledLevelSink implementation
+CompiledLevelSink::CompiledLevelSink(const std::string& levelPath, int levelRows, int levelCols,
+                                     const Position& levelStart, const Position& levelGoal)
+    : path(levelPath), temp(levelPath),
+      file(temp.getPath(), std::ios::binary | std::ios::trunc),
+      rows(levelRows), cols(levelCols), start(levelStart), goal(levelGoal),
+      checksum(LevelFormat::checksum(nullptr, 0)), pending(0), pendingCells(0) {
+    if (!file.is_open()) {
+        throw FileException(temp.getPath());
+    }
+    // Header is rewritten by finish() once the checksum is known
+    LevelFormat::Header header;
+    std::memset(&header, 0, sizeof(header));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer.reserve(1 << 16);
+}
+
+void CompiledLevelSink::writeRow(const char* cells, int count) {
+    for (int c = 0; c < count; ++c) {
+        int value = cells[c] == '*' ? 1 : cells[c] == '$' ? 2 : 0;
+        pending = static_cast<std::uint8_t>(pending | (value << (pendingCells * 2)));
+        if (++pendingCells == 4) {
+            buffer.push_back(pending);
+            pending = 0;
+            pendingCells = 0;
+        }
+    }
+    if (buffer.size() >= (1 << 16)) {
+        flushBuffer();
+    }
+}
+
+void CompiledLevelSink::flushBuffer() {
+    // FNV-1a continues across chunks, so the result matches LevelFormat::checksum
+    for (std::uint8_t byte : buffer) {
+        checksum ^= byte;
+        checksum *= 16777619u;
+    }
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void CompiledLevelSink::finish() {
+    if (pendingCells > 0) {
+        buffer.push_back(pending);
+        pending = 0;
+        pendingCells = 0;
+    }
+    flushBuffer();
+
+    LevelFormat::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LevelFormat::MAGIC, sizeof(LevelFormat::MAGIC));
+    header.version = LevelFormat::VERSION;
+    header.headerSize = sizeof(LevelFormat::Header);
+    header.rows = rows;
+    header.cols = cols;
+    header.goalRow = goal.row;
+    header.goalCol = goal.col;
+    header.startRow = start.row;
+    header.startCol = start.col;
+    header.checksum = checksum;
+    header.gridBytes = PackedGrid::bytesFor(rows, cols);
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+        throw GameException("Failed to write compiled level " + path);
+    }
+    LevelValidator().check(Level(temp.getPath()));
+    temp.commit();
+}
+
+// MazeGenerator implementation
+MazeGenerator::MazeGenerator(const MazeSpec& mazeSpec) : spec(mazeSpec) {
+    if (spec.cellRows <= 0 || spec.cellCols <= 0) {
+        throw GameException("Maze must have at least one cell");
+    }
+}
+
+Level MazeGenerator::generate() const {
+    PackedGrid grid;
+    if (spec.algorithm == MazeAlgorithm::ELLER) {
+        grid = PackedGrid(spec.gridRows(), spec.gridCols());
+        GridSink sink(grid);
+        generateEller(sink);
+    } else {
+        grid = generateTiled();
+    }
+
+    std::string name = std::string(mazeAlgorithmName(spec.algorithm)) + "-" +
+                       std::to_string(spec.cellRows) + "x" + std::to_string(spec.cellCols) +
+                       "-" + std::to_string(spec.seed);
+    return Level(std::move(grid), spec.start(), spec.goal(), name);
+}
+
+void MazeGenerator::generate(MazeRowSink& sink) const {
+    if (spec.algorithm == MazeAlgorithm::ELLER) {
+        generateEller(sink);
+        return;
+    }
+
+    PackedGrid grid = generateTiled();
+    std::vector<char> row(static_cast<std::size_t>(grid.getCols()));
+    for (int r = 0; r < grid.getRows(); ++r) {
+        for (int c = 0; c < grid.getCols(); ++c) {
+            row[c] = cellChar(grid.get(r, c));
+        }
+        sink.writeRow(row.data(), grid.getCols());
+    }
+}
+
+PackedGrid MazeGenerator::generateTiled() const {
+    PackedGrid grid(spec.gridRows(), spec.gridCols());
+    const int tileRows = (spec.cellRows + TILE_CELLS - 1) / TILE_CELLS;
+    const int tileCols = (spec.cellCols + TILE_CELLS - 1) / TILE_CELLS;
+
+    // One task per row of tiles. Tile rows write disjoint grid rows separated by a
+    // wall row, so no two tasks ever touch the same packed byte.
+    {
+        WorkStealingPool pool(spec.threads);
+        for (int tr = 0; tr < tileRows; ++tr) {
+            pool.submit([this, &grid, tr, tileCols] {
+                for (int tc = 0; tc < tileCols; ++tc) {
+                    Tile tile;
+                    tile.rowStart = tr * TILE_CELLS;
+                    tile.colStart = tc * TILE_CELLS;
+                    tile.rows = std::min(TILE_CELLS, spec.cellRows - tile.rowStart);
+                    tile.cols = std::min(TILE_CELLS, spec.cellCols - tile.colStart);
+                    tile.flags.assign(static_cast<std::size_t>(tile.rows) * tile.cols, 0);
+
+                    MazeRandom rng(streamSeed(spec.seed, STREAM_TILE,
+                                              static_cast<std::uint64_t>(tr) * tileCols + tc));
+                    if (spec.algorithm == MazeAlgorithm::WILSON) {
+                        carveWilson(tile, rng);
+                    } else {
+                        carveBacktracker(tile, rng);
+                    }
+
+                    for (int r = 0; r < tile.rows; ++r) {
+                        for (int c = 0; c < tile.cols; ++c) {
+                            std::uint8_t flags = tile.flags[static_cast<std::size_t>(r) * tile.cols + c];
+                            int gr = 2 * (tile.rowStart + r) + 1;
+                            int gc = 2 * (tile.colStart + c) + 1;
+                            grid.set(gr, gc, CellType::PATH);
+                            if (flags & OPEN_EAST) grid.set(gr, gc + 1, CellType::PATH);
+                            if (flags & OPEN_SOUTH) grid.set(gr + 1, gc, CellType::PATH);
+                        }
+                    }
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // Join tiles along a random spanning tree of the tile grid: one door per tree edge
+    const int tileCount = tileRows * tileCols;
+    std::vector<bool> joined(static_cast<std::size_t>(tileCount), false);
+    std::vector<int> stack;
+    MazeRandom treeRng(streamSeed(spec.seed, STREAM_TILE_TREE));
+    stack.push_back(0);
+    joined[0] = true;
+
+    while (!stack.empty()) {
+        int tile = stack.back();
+        int tr = tile / tileCols;
+        int tc = tile % tileCols;
+        int options[4];
+        int found = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nr = tr + ROW_STEP[dir];
+            int nc = tc + COL_STEP[dir];
+            if (nr >= 0 && nr < tileRows && nc >= 0 && nc < tileCols && !joined[nr * tileCols + nc]) {
+                options[found++] = dir;
+            }
+        }
+        if (found == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int dir = options[treeRng.below(static_cast<std::uint32_t>(found))];
+        int nr = tr + ROW_STEP[dir];
+        int nc = tc + COL_STEP[dir];
+        int next = nr * tileCols + nc;
+        joined[next] = true;
+        stack.push_back(next);
+
+        // Door on the border shared by the two tiles
+        int low = std::min(tile, next);
+        int high = std::max(tile, next);
+        MazeRandom doorRng(streamSeed(spec.seed, STREAM_TILE_DOOR,
+                                      static_cast<std::uint64_t>(low) * tileCount + high));
+        int lowRow = (low / tileCols) * TILE_CELLS;
+        int lowCol = (low % tileCols) * TILE_CELLS;
+        if (ROW_STEP[dir] != 0) {
+            int span = std::min(TILE_CELLS, spec.cellCols - lowCol);
+            int c = lowCol + static_cast<int>(doorRng.below(static_cast<std::uint32_t>(span)));
+            grid.set(2 * (lowRow + TILE_CELLS), 2 * c + 1, CellType::PATH);
+        } else {
+            int span = std::min(TILE_CELLS, spec.cellRows - lowRow);
+            int r = lowRow + static_cast<int>(doorRng.below(static_cast<std::uint32_t>(span)));
+            grid.set(2 * r + 1, 2 * (lowCol + TILE_CELLS), CellType::PATH);
+        }
+    }
+
+    Position goal = spec.goal();
+    grid.set(goal.row, goal.col, CellType::GOAL);
+    return grid;
+}
+
+void MazeGenerator::generateEller(MazeRowSink& sink) const {
+    const int height = spec.cellRows;
+    const int width = spec.cellCols;
+    const int gridCols = spec.gridCols();
+    const int bandCount = (width + BAND_CELLS - 1) / BAND_CELLS;
+
+    // Sets are circular doubly linked lists over the band's cells (L/R). Sets in a row
+    // never cross, so two neighbours share a set exactly when R[c] == c + 1.
+    struct Band {
+        int firstCell;
+        int width;
+        int doorRow; // Row of the door into the next band
+        std::vector<int> left, right;
+        MazeRandom rng;
+        explicit Band(std::uint64_t seed) : firstCell(0), width(0), doorRow(0), rng(seed) {}
+    };
+
+    std::vector<Band> bands;
+    bands.reserve(static_cast<std::size_t>(bandCount));
+    for (int b = 0; b < bandCount; ++b) {
+        bands.emplace_back(streamSeed(spec.seed, STREAM_BAND, static_cast<std::uint64_t>(b)));
+        Band& band = bands.back();
+        band.firstCell = b * BAND_CELLS;
+        band.width = std::min(BAND_CELLS, width - band.firstCell);
+        band.doorRow = static_cast<int>(MazeRandom(streamSeed(spec.seed, STREAM_BAND_DOOR,
+                                        static_cast<std::uint64_t>(b))).below(static_cast<std::uint32_t>(height)));
+        band.left.resize(static_cast<std::size_t>(band.width));
+        band.right.resize(static_cast<std::size_t>(band.width));
+        for (int c = 0; c < band.width; ++c) {
+            band.left[c] = band.right[c] = c;
+        }
+    }
+
+    std::vector<char> block(static_cast<std::size_t>(2 * BLOCK_ROWS) * gridCols, '|');
+    std::vector<char> border(static_cast<std::size_t>(gridCols), '|');
+    sink.writeRow(border.data(), gridCols);
+
+    WorkStealingPool pool(spec.threads);
+    for (int blockStart = 0; blockStart < height; blockStart += BLOCK_ROWS) {
+        const int blockEnd = std::min(height, blockStart + BLOCK_ROWS);
+
+        for (int b = 0; b < bandCount; ++b) {
+            pool.submit([&, b, blockStart, blockEnd] {
+                Band& band = bands[b];
+                std::vector<int>& L = band.left;
+                std::vector<int>& R = band.right;
+                const bool lastBand = b + 1 == bandCount;
+
+                for (int r = blockStart; r < blockEnd; ++r) {
+                    char* row = &block[static_cast<std::size_t>(2 * (r - blockStart)) * gridCols];
+                    char* south = row + gridCols;
+                    const bool lastRow = r + 1 == height;
+
+                    for (int c = 0; c < band.width; ++c) {
+                        int gc = 2 * (band.firstCell + c) + 1;
+                        row[gc] = '*';
+                        row[gc + 1] = '|';
+                        south[gc] = '|';
+                        south[gc + 1] = '|';
+                    }
+
+                    // Join neighbours in different sets (always on the last row)
+                    for (int c = 0; c + 1 < band.width; ++c) {
+                        if (R[c] != c + 1 && (lastRow || band.rng.coin())) {
+                            R[L[c + 1]] = R[c];
+                            L[R[c]] = L[c + 1];
+                            R[c] = c + 1;
+                            L[c + 1] = c;
+                            row[2 * (band.firstCell + c) + 2] = '*';
+                        }
+                    }
+                    if (!lastBand && r == band.doorRow) {
+                        row[2 * (band.firstCell + band.width)] = '*';
+                    }
+
+                    // Each set keeps at least one passage down; cells left behind start new sets
+                    if (!lastRow) {
+                        for (int c = 0; c < band.width; ++c) {
+                            if (L[c] != c && band.rng.coin()) {
+                                L[R[c]] = L[c];
+                                R[L[c]] = R[c];
+                                L[c] = R[c] = c;
+                            } else {
+                                south[2 * (band.firstCell + c) + 1] = '*';
+                            }
+                        }
+                    }
+                }
+            });
+        }
+        pool.wait();
+
+        for (int r = blockStart; r < blockEnd; ++r) {
+            char* row = &block[static_cast<std::size_t>(2 * (r - blockStart)) * gridCols];
+            row[0] = '|';
+            row[gridCols - 1] = '|';
+            if (r == 0) {
+                row[spec.goal().col] = '$';
+            }
+            sink.writeRow(row, gridCols);
+            sink.writeRow(row + gridCols, gridCols);
+        }
+    }
+}
+
+void writeMaze(const MazeSpec& spec, const std::string& path) {
+    MazeGenerator generator(spec);
+    const bool compiled = endsWith(path, LevelFormat::EXTENSION);
+    if (!compiled && !(spec.start() == Level::defaultStart())) {
+        throw GameException("Text levels start at (" + std::to_string(Level::defaultStart().row) + ", " +
+                            std::to_string(Level::defaultStart().col) + "), so they need at least " +
+                            std::to_string(Level::defaultStart().row / 2 + 1) + " rows; write a " +
+                            LevelFormat::EXTENSION + " file for smaller mazes");
+    }
+    if (compiled && spec.algorithm != MazeAlgorithm::ELLER) {
+        Level level = generator.generate(); // Tiled mazes are already packed
+        LevelValidator().check(level);
+        LevelFormat::write(level, path);
+    } else if (compiled) {
+        CompiledLevelSink sink(path, spec.gridRows(), spec.gridCols(), spec.start(), spec.goal());
+        generator.generate(sink);
+        sink.finish();
+    } else {
+        TextLevelSink sink(path, spec.gridRows(), spec.gridCols());
+        generator.generate(sink);
+        sink.finish();
+    }
+}
+
+} // namespace MulaWee
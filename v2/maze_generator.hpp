@@ -0,0 +1,117 @@
+#pragma once
+
+#include "game_core.hpp"
+#include "temp_file.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+enum class MazeAlgorithm {
+    BACKTRACKER,
+    WILSON,
+    ELLER
+};
+
+const char* mazeAlgorithmName(MazeAlgorithm algorithm);
+bool parseMazeAlgorithm(const std::string& name, MazeAlgorithm& algorithm);
+
+// What to generate. Sizes count maze cells; the level grid is (2 * cells + 1) on each
+// axis with walls between cells. The same seed, size and algorithm always produce the
+// same maze, whatever the thread count.
+struct MazeSpec {
+    int cellRows = 9;
+    int cellCols = 28;
+    std::uint64_t seed = 1;
+    MazeAlgorithm algorithm = MazeAlgorithm::ELLER;
+    unsigned threads = 0; // 0 = every hardware thread
+
+    int gridRows() const { return 2 * cellRows + 1; }
+    int gridCols() const { return 2 * cellCols + 1; }
+
+    // Start matches Level::defaultStart() whenever the maze is tall enough (9 rows), so
+    // text output plays from the same cell as the shipped levels; the goal is top-right.
+    // Text files do not store a start, so shorter mazes can only be written as .mwl.
+    Position start() const;
+    Position goal() const { return Position(1, gridCols() - 2); }
+};
+
+// Receives a maze one grid row at a time, top to bottom, as '|', '*' and '$'
+class MazeRowSink {
+public:
+    virtual ~MazeRowSink() = default;
+    virtual void writeRow(const char* cells, int cols) = 0;
+};
+
+// Text level (.dat) writer
+class TextLevelSink : public MazeRowSink {
+private:
+    std::string path;
+    TempFile temp;
+    std::ofstream file;
+
+public:
+    TextLevelSink(const std::string& levelPath, int rows, int cols);
+    void writeRow(const char* cells, int cols) override;
+    void finish(); // Flush, check it is playable and move into place
+};
+
+// Compiled level (.mwl) writer - packs and checksums rows as they stream past
+class CompiledLevelSink : public MazeRowSink {
+private:
+    std::string path;
+    TempFile temp;
+    std::ofstream file;
+    int rows, cols;
+    Position start, goal;
+    std::uint32_t checksum;
+    std::uint8_t pending;  // Partially filled byte
+    int pendingCells;
+    std::vector<std::uint8_t> buffer;
+
+public:
+    CompiledLevelSink(const std::string& levelPath, int levelRows, int levelCols,
+                      const Position& levelStart, const Position& levelGoal);
+    void writeRow(const char* cells, int cols) override;
+    void finish(); // Write the header, check it is playable and move into place
+
+private:
+    void flushBuffer();
+};
+
+// Seeded maze generator.
+//
+// Backtracker and Wilson split the maze into fixed 64x64-cell tiles, carve each tile
+// as its own perfect maze in parallel, then join the tiles along a seeded spanning tree
+// with one door per tree edge. Eller runs in fixed 1024-cell column bands, each its own
+// Eller's maze, chained by one seeded door per band boundary; rows are produced in
+// blocks, so only a block of rows is ever in memory when streaming to a sink.
+class MazeGenerator {
+private:
+    MazeSpec spec;
+
+public:
+    explicit MazeGenerator(const MazeSpec& mazeSpec);
+
+    // Whole maze in memory
+    Level generate() const;
+
+    // Stream the maze row by row (Eller never holds the whole maze)
+    void generate(MazeRowSink& sink) const;
+
+    static constexpr int TILE_CELLS = 64;
+    static constexpr int BAND_CELLS = 1024;
+    static constexpr int BLOCK_ROWS = 64;
+
+private:
+    PackedGrid generateTiled() const;
+    void generateEller(MazeRowSink& sink) const;
+};
+
+// Write a generated maze to `path` (.mwl -> compiled, anything else -> text). Throws
+// GameException for text mazes under 9 rows and for any level LevelValidator rejects.
+void writeMaze(const MazeSpec& spec, const std::string& path);
+
+} // namespace MulaWee
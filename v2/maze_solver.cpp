@@ -0,0 +1,55 @@
+#include "maze_solver.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace MulaWee {
+
+constexpr int MazeSolver::ROW_STEP[4];
+constexpr int MazeSolver::COL_STEP[4];
+
+const char* solverName(SolverAlgorithm algorithm) {
+    switch (algorithm) {
+        case SolverAlgorithm::BFS: return "bfs";
+        case SolverAlgorithm::BIDIRECTIONAL_BFS: return "bibfs";
+        case SolverAlgorithm::ASTAR: return "astar";
+    }
+    return "unknown";
+}
+
+void MazeSolver::reset(std::size_t cells, int levelCols, const std::string& name) {
+    if (cells >= std::numeric_limits<std::uint32_t>::max()) {
+        throw GameException("Level too large for MazeSolver: " + name);
+    }
+
+    if (stamp.size() < cells) {
+        stamp.resize(cells, 0);
+        via.resize(cells, 0);
+    }
+    cols = levelCols;
+
+    // Two stamps per call (forward/backward); wrap by clearing once every ~2^31 calls
+    if (generation >= std::numeric_limits<std::uint32_t>::max() - 2) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 0;
+    }
+    generation += 2;
+}
+
+void MazeSolver::tracePath(std::uint32_t from, std::uint32_t to, std::vector<Position>& out) const {
+    // Walk the via links back from `to` until `from`, appending in that (reverse) order
+    std::uint32_t cell = to;
+    out.push_back(toPosition(cell));
+    while (cell != from) {
+        int dir = via[cell];
+        cell = cell - static_cast<std::uint32_t>(ROW_STEP[dir] * cols + COL_STEP[dir]);
+        out.push_back(toPosition(cell));
+    }
+}
+
+std::size_t MazeSolver::memoryUsage() const {
+    return stamp.capacity() * sizeof(std::uint32_t) + via.capacity() +
+           (frontier.capacity() + nextFrontier.capacity() + scratch.capacity()) * sizeof(std::uint32_t) +
+           heap.capacity() * sizeof(HeapNode);
+}
+
+} // namespace MulaWee
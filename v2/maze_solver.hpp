@@ -0,0 +1,293 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+enum class SolverAlgorithm {
+    BFS,
+    BIDIRECTIONAL_BFS,
+    ASTAR
+};
+
+const char* solverName(SolverAlgorithm algorithm);
+
+// Result of one search
+struct SolveResult {
+    bool found = false;
+    std::vector<Position> path;  // start..goal inclusive (empty if not found)
+    std::size_t expanded = 0;    // nodes taken off a frontier and expanded
+
+    // Number of moves on the path, or -1
+    int moves() const { return found ? static_cast<int>(path.size()) - 1 : -1; }
+};
+
+// Shortest-path search over a Level's walkable cells (4-connected, unit cost).
+// Per-cell buffers are allocated once for the largest level seen and reused by every
+// call; a generation stamp marks visited cells, so nothing is cleared between calls.
+// The searches are templates over the level type, so on a FixedLevel the bounds and
+// index arithmetic use the compile-time size.
+class MazeSolver {
+private:
+    struct HeapNode {
+        std::uint32_t f;
+        std::uint32_t g;
+        std::uint32_t cell;
+        std::uint8_t via;
+    };
+
+    struct HeapOrder {
+        bool operator()(const HeapNode& a, const HeapNode& b) const {
+            // Min-heap on f; among equal f prefer the deeper node
+            return a.f != b.f ? a.f > b.f : a.g < b.g;
+        }
+    };
+
+    // Row/column step for each Direction (UP, DOWN, LEFT, RIGHT)
+    static constexpr int ROW_STEP[4] = {-1, 1, 0, 0};
+    static constexpr int COL_STEP[4] = {0, 0, -1, 1};
+
+    std::vector<std::uint32_t> stamp;  // == generation (forward) or generation + 1 (backward)
+    std::vector<std::uint8_t> via;     // Direction of the step that reached the cell
+    std::vector<std::uint32_t> frontier;      // BFS queue / forward layer
+    std::vector<std::uint32_t> nextFrontier;  // Backward layer
+    std::vector<std::uint32_t> scratch;       // Layer being built
+    std::vector<HeapNode> heap;
+    std::uint32_t generation;
+    int cols;
+
+public:
+    MazeSolver() : generation(0), cols(0) {}
+
+    // LevelType is Level or a FixedLevel
+    template <typename LevelType>
+    SolveResult solve(SolverAlgorithm algorithm, const LevelType& level) {
+        return solve(algorithm, level, level.getStartPosition(), level.getGoalPosition());
+    }
+
+    template <typename LevelType>
+    SolveResult solve(SolverAlgorithm algorithm, const LevelType& level, const Position& start,
+                      const Position& goal) {
+        switch (algorithm) {
+            case SolverAlgorithm::BFS: return bfs(level, start, goal);
+            case SolverAlgorithm::BIDIRECTIONAL_BFS: return bidirectionalBfs(level, start, goal);
+            case SolverAlgorithm::ASTAR: return aStar(level, start, goal);
+        }
+        return SolveResult();
+    }
+
+    template <typename LevelType>
+    SolveResult bfs(const LevelType& level, const Position& start, const Position& goal);
+    template <typename LevelType>
+    SolveResult bidirectionalBfs(const LevelType& level, const Position& start, const Position& goal);
+    template <typename LevelType>
+    SolveResult aStar(const LevelType& level, const Position& start, const Position& goal);
+
+    // Bytes currently held by the reusable buffers
+    std::size_t memoryUsage() const;
+
+private:
+    template <typename LevelType>
+    bool prepare(const LevelType& level, const Position& start, const Position& goal) {
+        reset(static_cast<std::size_t>(level.getRows()) * level.getCols(), level.getCols(), level.getFilename());
+        return level.canMoveTo(start) && level.canMoveTo(goal);
+    }
+
+    // Size the buffers for `cells` and start a new generation
+    void reset(std::size_t cells, int levelCols, const std::string& name);
+    void tracePath(std::uint32_t from, std::uint32_t to, std::vector<Position>& out) const;
+    Position toPosition(std::uint32_t cell) const {
+        return Position(static_cast<int>(cell / cols), static_cast<int>(cell % cols));
+    }
+};
+
+template <typename LevelType>
+SolveResult MazeSolver::bfs(const LevelType& level, const Position& start, const Position& goal) {
+    SolveResult result;
+    if (!prepare(level, start, goal)) {
+        return result;
+    }
+
+    const int rows = level.getRows();
+    const int width = level.getCols(); // Constants for a FixedLevel
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * width + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * width + goal.col;
+
+    frontier.clear();
+    frontier.push_back(source);
+    stamp[source] = generation;
+
+    for (std::size_t head = 0; head < frontier.size(); ++head) {
+        std::uint32_t cell = frontier[head];
+        ++result.expanded;
+
+        if (cell == target) {
+            tracePath(source, target, result.path);
+            std::reverse(result.path.begin(), result.path.end());
+            result.found = true;
+            return result;
+        }
+
+        int r = static_cast<int>(cell / width);
+        int c = static_cast<int>(cell % width);
+        for (int dir = 0; dir < 4; ++dir) {
+            int nr = r + ROW_STEP[dir];
+            int nc = c + COL_STEP[dir];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= width) {
+                continue;
+            }
+            std::uint32_t next = static_cast<std::uint32_t>(nr) * width + nc;
+            if (stamp[next] == generation || level.cellAt(next) == CellType::WALL) {
+                continue;
+            }
+            stamp[next] = generation;
+            via[next] = static_cast<std::uint8_t>(dir);
+            frontier.push_back(next);
+        }
+    }
+
+    return result;
+}
+
+template <typename LevelType>
+SolveResult MazeSolver::bidirectionalBfs(const LevelType& level, const Position& start, const Position& goal) {
+    SolveResult result;
+    if (!prepare(level, start, goal)) {
+        return result;
+    }
+
+    const int rows = level.getRows();
+    const int width = level.getCols(); // Constants for a FixedLevel
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * width + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * width + goal.col;
+    const std::uint32_t forwardMark = generation;
+    const std::uint32_t backwardMark = generation + 1;
+
+    if (source == target) {
+        result.found = true;
+        result.path.push_back(start);
+        return result;
+    }
+
+    // frontier holds the forward layer, nextFrontier the backward one; each round
+    // expands the smaller layer completely (see the meeting argument below)
+    frontier.assign(1, source);
+    nextFrontier.assign(1, target);
+    stamp[source] = forwardMark;
+    stamp[target] = backwardMark;
+
+    while (!frontier.empty() && !nextFrontier.empty()) {
+        bool forward = frontier.size() <= nextFrontier.size();
+        std::vector<std::uint32_t>& current = forward ? frontier : nextFrontier;
+        const std::uint32_t ownMark = forward ? forwardMark : backwardMark;
+        const std::uint32_t otherMark = forward ? backwardMark : forwardMark;
+
+        scratch.clear();
+        for (std::uint32_t cell : current) {
+            ++result.expanded;
+            int r = static_cast<int>(cell / width);
+            int c = static_cast<int>(cell % width);
+
+            for (int dir = 0; dir < 4; ++dir) {
+                int nr = r + ROW_STEP[dir];
+                int nc = c + COL_STEP[dir];
+                if (nr < 0 || nr >= rows || nc < 0 || nc >= width) {
+                    continue;
+                }
+                std::uint32_t next = static_cast<std::uint32_t>(nr) * width + nc;
+                if (stamp[next] == ownMark || level.cellAt(next) == CellType::WALL) {
+                    continue;
+                }
+
+                if (stamp[next] == otherMark) {
+                    // Layers are expanded whole and meetings are checked from both sides,
+                    // so the first meeting edge found lies on a shortest path.
+                    std::uint32_t forwardCell = forward ? cell : next;
+                    std::uint32_t backwardCell = forward ? next : cell;
+                    tracePath(source, forwardCell, result.path);
+                    std::reverse(result.path.begin(), result.path.end());
+                    tracePath(target, backwardCell, result.path);
+                    result.found = true;
+                    return result;
+                }
+
+                stamp[next] = ownMark;
+                via[next] = static_cast<std::uint8_t>(dir);
+                scratch.push_back(next);
+            }
+        }
+        current.swap(scratch);
+    }
+
+    return result;
+}
+
+template <typename LevelType>
+SolveResult MazeSolver::aStar(const LevelType& level, const Position& start, const Position& goal) {
+    SolveResult result;
+    if (!prepare(level, start, goal)) {
+        return result;
+    }
+
+    const int rows = level.getRows();
+    const int width = level.getCols(); // Constants for a FixedLevel
+    const std::uint32_t source = static_cast<std::uint32_t>(start.row) * width + start.col;
+    const std::uint32_t target = static_cast<std::uint32_t>(goal.row) * width + goal.col;
+    const std::uint32_t closed = generation;
+
+    auto heuristic = [&goal](int r, int c) {
+        return static_cast<std::uint32_t>(std::abs(r - goal.row) + std::abs(c - goal.col));
+    };
+
+    // Manhattan distance is consistent on a unit-cost 4-grid, so a cell's first pop is
+    // optimal: duplicates are allowed in the heap and skipped once closed (no g buffer).
+    heap.clear();
+    heap.push_back(HeapNode{heuristic(start.row, start.col), 0, source, 0});
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), HeapOrder());
+        HeapNode node = heap.back();
+        heap.pop_back();
+
+        if (stamp[node.cell] == closed) {
+            continue;
+        }
+        stamp[node.cell] = closed;
+        via[node.cell] = node.via;
+        ++result.expanded;
+
+        if (node.cell == target) {
+            tracePath(source, target, result.path);
+            std::reverse(result.path.begin(), result.path.end());
+            result.found = true;
+            return result;
+        }
+
+        int r = static_cast<int>(node.cell / width);
+        int c = static_cast<int>(node.cell % width);
+        for (int dir = 0; dir < 4; ++dir) {
+            int nr = r + ROW_STEP[dir];
+            int nc = c + COL_STEP[dir];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= width) {
+                continue;
+            }
+            std::uint32_t next = static_cast<std::uint32_t>(nr) * width + nc;
+            if (stamp[next] == closed || level.cellAt(next) == CellType::WALL) {
+                continue;
+            }
+            std::uint32_t g = node.g + 1;
+            heap.push_back(HeapNode{g + heuristic(nr, nc), g, next, static_cast<std::uint8_t>(dir)});
+            std::push_heap(heap.begin(), heap.end(), HeapOrder());
+        }
+    }
+
+    return result;
+}
+
+} // namespace MulaWee
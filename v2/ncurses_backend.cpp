@@ -0,0 +1,110 @@
+#include "ncurses_backend.hpp"
+
+namespace MulaWee {
+
+// NCursesWrapper class implementation
+NCursesWrapper::NCursesWrapper() : initialized(false) {
+    initscr();
+    keypad(stdscr, TRUE);
+    noecho();
+    cbreak();
+    nodelay(stdscr, FALSE); // Wait for input
+    initialized = true;
+    initializeColors();
+}
+
+NCursesWrapper::~NCursesWrapper() {
+    cleanup();
+}
+
+void NCursesWrapper::initializeColors() {
+    if (has_colors()) {
+        start_color();
+        init_pair(static_cast<int>(ColorPair::RED), COLOR_RED, COLOR_BLACK);
+        init_pair(static_cast<int>(ColorPair::GREEN), COLOR_GREEN, COLOR_BLACK);
+        init_pair(static_cast<int>(ColorPair::BLUE), COLOR_BLUE, COLOR_BLACK);
+        init_pair(static_cast<int>(ColorPair::YELLOW), COLOR_YELLOW, COLOR_BLACK);
+        init_pair(static_cast<int>(ColorPair::GOAL), COLOR_BLACK, COLOR_YELLOW);
+        init_pair(static_cast<int>(ColorPair::DEFAULT), COLOR_WHITE, COLOR_BLACK);
+    }
+}
+
+void NCursesWrapper::cleanup() {
+    if (initialized) {
+        endwin();
+        initialized = false;
+    }
+}
+
+// NCursesRenderer class implementation
+void NCursesRenderer::clear() {
+    ::clear();
+    cursesCalls += 1;
+}
+
+void NCursesRenderer::drawChar(int row, int col, ColorPair color, char ch) {
+    attrset(COLOR_PAIR(static_cast<int>(color)));
+    mvaddch(row, col, static_cast<unsigned char>(ch));
+    cursesCalls += 2;
+}
+
+void NCursesRenderer::drawText(int row, int col, ColorPair color, const std::string& text) {
+    attrset(COLOR_PAIR(static_cast<int>(color)));
+    mvaddstr(row, col, text.c_str());
+    cursesCalls += 2;
+}
+
+void NCursesRenderer::drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) {
+    // Attributes travel inside each chtype, so one call covers every color run
+    line.resize(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        line[i] = static_cast<unsigned char>(glyphs[i].ch) | COLOR_PAIR(static_cast<int>(glyphs[i].color));
+    }
+    mvaddchnstr(row, col, line.data(), count);
+    cursesCalls += 1;
+}
+
+void NCursesRenderer::beep() {
+    ::beep();
+    cursesCalls += 1;
+}
+
+void NCursesRenderer::refresh() {
+    ::refresh();
+    cursesCalls += 1;
+}
+
+bool NCursesRenderer::getScreenSize(int& rows, int& cols) const {
+    getmaxyx(stdscr, rows, cols);
+    return true;
+}
+
+void NCursesRenderer::shutdown() {
+    ncursesWrapper.cleanup();
+}
+
+// NCursesInput class implementation
+int NCursesInput::getKey() {
+    int ch = getch();
+    if (ch == KEY_RESIZE) {
+        return RESIZE;
+    }
+    return ch == ERR ? END_OF_INPUT : ch;
+}
+
+int NCursesInput::pollKey() {
+    nodelay(stdscr, TRUE);
+    int ch = getKey();
+    nodelay(stdscr, FALSE);
+    return ch == END_OF_INPUT ? NO_KEY : ch;
+}
+
+std::string NCursesInput::getLine(int maxLength) {
+    std::vector<char> buffer(static_cast<std::size_t>(maxLength) + 1, '\0');
+    echo();
+    getnstr(buffer.data(), maxLength);
+    noecho();
+    return std::string(buffer.data());
+}
+
+} // namespace MulaWee
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "renderer.hpp"
+#include <ncurses.h>
+#include <vector>
+
+namespace MulaWee {
+
+// RAII wrapper for ncurses - ensures proper cleanup
+class NCursesWrapper {
+private:
+    bool initialized;
+
+public:
+    NCursesWrapper();
+    ~NCursesWrapper();
+
+    // Delete copy constructor and assignment operator
+    NCursesWrapper(const NCursesWrapper&) = delete;
+    NCursesWrapper& operator=(const NCursesWrapper&) = delete;
+
+    void initializeColors();
+    void cleanup();
+};
+
+// Renderer backed by the ncurses standard screen
+class NCursesRenderer : public Renderer {
+private:
+    NCursesWrapper ncursesWrapper;
+    std::vector<chtype> line; // Reused drawGlyphs buffer
+    std::size_t cursesCalls;
+
+public:
+    NCursesRenderer() : cursesCalls(0) {}
+
+    void clear() override;
+    void drawChar(int row, int col, ColorPair color, char ch) override;
+    void drawText(int row, int col, ColorPair color, const std::string& text) override;
+    void drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) override;
+    void beep() override;
+    void refresh() override;
+    void shutdown() override;
+    bool getScreenSize(int& rows, int& cols) const override;
+
+    // ncurses calls made so far (for render benchmarks)
+    std::size_t getCursesCalls() const { return cursesCalls; }
+};
+
+// Blocking keyboard input through ncurses (create after the renderer)
+class NCursesInput : public InputSource {
+public:
+    int getKey() override;
+    int pollKey() override;
+    std::string getLine(int maxLength) override;
+};
+
+} // namespace MulaWee
@@ -1,245 +1,74 @@
 #include "optimized_game.hpp"
-#include <iostream>
+#include "embedded_levels.hpp"
+#include "level_pack.hpp"
 #include <algorithm>
-#include <sstream>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace MulaWee {
 
-// Level class implementation
-Level::Level(const std::string& levelFile) : rows(0), cols(0), filename(levelFile) {
-    loadFromFile();
-}
-
-void Level::loadFromFile() {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw FileException(filename);
-    }
-
-    file >> rows >> cols;
-    if (rows <= 0 || cols <= 0 || rows > 100 || cols > 100) {
-        throw GameException("Invalid level dimensions in " + filename);
-    }
-
-    grid.resize(rows, std::vector<CellType>(cols));
-
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            char ch;
-            file >> ch;
-
-            switch (ch) {
-                case '|':
-                case '%':
-                    grid[r][c] = CellType::WALL;
-                    break;
-                case '*':
-                    grid[r][c] = CellType::PATH;
-                    break;
-                case '$':
-                    grid[r][c] = CellType::GOAL;
-                    goalPosition = Position(r, c);
-                    break;
-                default:
-                    grid[r][c] = CellType::WALL; // Default to wall for unknown characters
-                    break;
-            }
-        }
-    }
-}
+namespace {
 
-CellType Level::getCellType(const Position& pos) const {
-    if (!isValidPosition(pos)) {
-        return CellType::WALL;
-    }
-    return grid[pos.row][pos.col];
+bool isDirectory(const std::string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
 }
 
-bool Level::isValidPosition(const Position& pos) const {
-    return pos.row >= 0 && pos.row < rows && pos.col >= 0 && pos.col < cols;
+std::string directoryOf(const std::string& path) {
+    std::size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
 }
 
-bool Level::canMoveTo(const Position& pos) const {
-    if (!isValidPosition(pos)) {
-        return false;
+// `path` as given if it is usable from the working directory, else the same relative
+// path from the binary's directory, else "". A file is usable if its directory exists.
+std::string locate(const std::string& path, bool directory) {
+    auto usable = [directory](const std::string& candidate) {
+        return isDirectory(directory ? candidate : directoryOf(candidate));
+    };
+    if (path.empty() || path[0] == '/' || usable(path)) {
+        return path;
     }
-    return grid[pos.row][pos.col] != CellType::WALL;
-}
-
-void Level::render(int startRow, int startCol) const {
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            ::move(r + startRow, c + startCol);
 
-            CellType cellType = grid[r][c];
-            char ch = cellTypeToChar(cellType);
-
-            switch (cellType) {
-                case CellType::PATH:
-                    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-                    printw(" ");
-                    break;
-                case CellType::GOAL:
-                    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GOAL)));
-                    printw("$");
-                    break;
-                case CellType::WALL:
-                default:
-                    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-                    printw("%c", ch);
-                    break;
-            }
-        }
-    }
-}
-
-char Level::cellTypeToChar(CellType type) const {
-    switch (type) {
-        case CellType::WALL: return '|';
-        case CellType::PATH: return ' ';
-        case CellType::GOAL: return '$';
-        default: return '|';
+    char binary[PATH_MAX];
+    ssize_t length = ::readlink("/proc/self/exe", binary, sizeof(binary) - 1);
+    if (length <= 0) {
+        return "";
     }
+    std::string candidate = directoryOf(std::string(binary, static_cast<std::size_t>(length))) + "/" + path;
+    return usable(candidate) ? candidate : "";
 }
 
-// Player class implementation
-bool Player::move(Direction dir, const Level& level) {
-    Position newPos = position + getDirectionOffset(dir);
+} // namespace
 
-    // Convert screen coordinates to grid coordinates (subtract rendering offset)
-    Position gridPos(newPos.row - 3, newPos.col - 3);
-
-    if (level.canMoveTo(gridPos)) {
-        lastPosition = position;
-        position = newPos;
-        ++moveCount;
-        return true;
-    }
-
-    // Invalid move - play beep sound
-    beep();
-    return false;
-}
-
-void Player::reset(const Position& startPos) {
-    position = startPos;
-    lastPosition = startPos;
-    moveCount = 0;
-}
-
-void Player::render() {
-    ::move(position.row, position.col);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("*");
-}
-
-void Player::clearLastPosition() {
-    ::move(lastPosition.row, lastPosition.col);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-    printw(" ");
-}
-
-Position Player::getDirectionOffset(Direction dir) const {
-    switch (dir) {
-        case Direction::UP:    return Position(-1, 0);
-        case Direction::DOWN:  return Position(1, 0);
-        case Direction::LEFT:  return Position(0, -1);
-        case Direction::RIGHT: return Position(0, 1);
-        default: return Position(0, 0);
-    }
-}
-
-// ScoreManager class implementation
-ScoreManager::ScoreManager(const std::string& scoreFile)
-    : highScoreFile(scoreFile), currentScore(0), highScore(0) {
-    loadHighScore();
-}
-
-void ScoreManager::addLevelScore(int level, int moves) {
-    int levelScore = calculateLevelScore(level, moves);
-    currentScore += levelScore;
-}
-
-void ScoreManager::loadHighScore() {
-    std::ifstream file(highScoreFile);
-    if (file.is_open()) {
-        file >> highScorePlayerName >> highScore;
-    } else {
-        // Set default values if file doesn't exist
-        highScorePlayerName = "Default";
-        highScore = 0;
-    }
-}
-
-void ScoreManager::saveHighScore() {
-    std::ofstream file(highScoreFile);
-    if (file.is_open()) {
-        file << currentPlayerName << " " << currentScore;
-    }
-}
-
-int ScoreManager::calculateLevelScore(int level, int moves) const {
-    // Original scoring algorithm from the game
-    int baseScore;
-    switch (level) {
-        case 1: baseScore = 154; break;
-        case 2: baseScore = 253; break;
-        case 3: baseScore = 212; break;
-        default: baseScore = 100; break;
-    }
-
-    // Score decreases with more moves, but never goes below 0
-    int score = ((baseScore + std::max(0, baseScore - moves)) * baseScore) / 100;
-    return std::max(0, score);
-}
-
-// NCursesWrapper class implementation
-NCursesWrapper::NCursesWrapper() : initialized(false) {
-    initscr();
-    keypad(stdscr, TRUE);
-    noecho();
-    cbreak();
-    nodelay(stdscr, FALSE); // Wait for input
-    initialized = true;
-    initializeColors();
-}
-
-NCursesWrapper::~NCursesWrapper() {
-    cleanup();
-}
-
-void NCursesWrapper::initializeColors() {
-    if (has_colors()) {
-        start_color();
-        init_pair(static_cast<int>(ColorPair::RED), COLOR_RED, COLOR_BLACK);
-        init_pair(static_cast<int>(ColorPair::GREEN), COLOR_GREEN, COLOR_BLACK);
-        init_pair(static_cast<int>(ColorPair::BLUE), COLOR_BLUE, COLOR_BLACK);
-        init_pair(static_cast<int>(ColorPair::YELLOW), COLOR_YELLOW, COLOR_BLACK);
-        init_pair(static_cast<int>(ColorPair::GOAL), COLOR_BLACK, COLOR_YELLOW);
-        init_pair(static_cast<int>(ColorPair::DEFAULT), COLOR_WHITE, COLOR_BLACK);
+// Game class implementation
+Game::Game(std::unique_ptr<Renderer> gameRenderer, std::unique_ptr<InputSource> gameInput,
+           GameOptions gameOptions)
+    : renderer(std::move(gameRenderer)), input(std::move(gameInput)),
+      options(std::move(gameOptions)) {
+    // Started from another directory, ../data is found beside the binary or not at all
+    if (!options.embeddedLevels && options.levelPack.empty()) {
+        options.dataDir = locate(options.dataDir, true);
     }
+    options.runLogFile = locate(options.runLogFile, false);
 }
 
-void NCursesWrapper::cleanup() {
-    if (initialized) {
-        endwin();
-        initialized = false;
+Game::~Game() {
+    if (compaction.joinable()) {
+        compaction.join();
     }
 }
 
-// Game class implementation
-Game::Game() : currentState(GameState::MENU), currentLevel(0) {
-    ncursesWrapper = std::make_unique<NCursesWrapper>();
-    scoreManager = std::make_unique<ScoreManager>();
-    player = std::make_unique<Player>();
-}
-
 void Game::run() {
     try {
         initializeGame();
 
-        while (currentState != GameState::QUIT) {
-            switch (currentState) {
+        while (session->getState() != GameState::QUIT) {
+            switch (session->getState()) {
                 case GameState::MENU:
                     handleMenuState();
                     break;
@@ -258,140 +87,297 @@ void Game::run() {
             }
         }
     } catch (const GameException& e) {
-        ncursesWrapper->cleanup();
+        renderer->shutdown();
         std::cerr << e.what() << std::endl;
     } catch (const std::exception& e) {
-        ncursesWrapper->cleanup();
+        renderer->shutdown();
         std::cerr << "Unexpected error: " << e.what() << std::endl;
     }
+
+    if (compaction.joinable()) {
+        compaction.join();
+    }
+    if (!compactionError.empty()) {
+        std::cerr << compactionError << std::endl;
+    }
+
+    try {
+        if (replay && !replay->isEmpty()) {
+            saveReplay(); // Quit part way through a run
+        }
+        if (latency) {
+            latency->writeReport(options.latencyFile);
+        }
+    } catch (const GameException& e) {
+        std::cerr << e.what() << std::endl;
+    }
 }
 
 void Game::initializeGame() {
-    loadLevels();
-    currentState = GameState::MENU;
+    session = std::make_unique<GameSession>(openLevels(), options.runLogFile);
+    if (!options.latencyFile.empty()) {
+        latency = std::make_unique<LatencyRecorder>();
+        session->setLatencyRecorder(latency.get());
+    }
+    if (!options.replayDir.empty()) {
+        replay = std::make_unique<Replay>();
+    }
+    session->setState(GameState::MENU);
+    startCompaction();
 }
 
-void Game::loadLevels() {
-    levels.clear();
-    levels.reserve(MAX_LEVELS);
+void Game::startCompaction() {
+    struct stat info;
+    if (options.runLogFile.empty() || ::stat(options.runLogFile.c_str(), &info) != 0 ||
+        static_cast<std::uint64_t>(info.st_size) < COMPACT_LOG_BYTES) {
+        return;
+    }
 
-    for (int i = 1; i <= MAX_LEVELS; ++i) {
-        std::string filename = "../data/level" + std::to_string(i) + ".dat";
-        levels.push_back(std::make_unique<Level>(filename));
+    // Runs finished meanwhile are appended as usual and carried over by the compaction
+    std::string path = options.runLogFile;
+    compaction = std::thread([this, path] {
+        try {
+            RunLog::compact(path, COMPACT_KEEP_PER_PLAYER);
+        } catch (const std::exception& e) { // bad_alloc too: an escape would terminate the game
+            compactionError = e.what();
+        }
+    });
+}
+
+std::shared_ptr<LevelSource> Game::openLevels() const {
+    if (options.embeddedLevels) {
+        return EmbeddedLevels::open();
+    }
+    if (!options.levelPack.empty()) {
+        return std::make_shared<LevelPack>(options.levelPack); // Any level is one index lookup away
+    }
+
+    // Levels are loaded as they are reached, so startup only reads the first one
+    std::vector<std::string> paths;
+    if (!options.dataDir.empty()) {
+        paths = LevelCache::discover(options.dataDir);
+    }
+    if (paths.empty()) {
+        return EmbeddedLevels::open(); // No level files reachable; play the built-in ones
     }
+    return std::make_shared<LevelCache>(std::move(paths), options.levelCacheBytes);
 }
 
 void Game::handleMenuState() {
     showWelcomeScreen();
 
     // Get player name
-    echo();
-    char nameBuffer[11];
-    ::move(20, 60);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("Enter your name: ");
-    getnstr(nameBuffer, 10);
-    noecho();
-
-    scoreManager->setPlayerName(std::string(nameBuffer));
-    scoreManager->resetScore();
-    currentLevel = 0;
-    currentState = GameState::PLAYING;
-    startLevel(currentLevel);
+    renderer->drawText(20, 60, ColorPair::YELLOW, "Enter your name: ");
+    renderer->refresh();
+    std::string name = input->getLine(10);
+    renderer->invalidate(); // The name was echoed straight to the terminal
+
+    session->begin(name);
+    if (replay) {
+        replay->begin(name, session->getLevelCount());
+    }
 }
 
 void Game::handlePlayingState() {
+    if (replay) {
+        replay->startLevel(session->getLevel().getChecksum());
+    }
+    // One BFS from the goal per level, on its own thread so a large level's first frame
+    // doesn't wait for it; every hint after that is a lookup. A build still running from
+    // the last level is waited for here.
+    hints.reset();
+    std::shared_ptr<const Level> level = session->shareLevel();
+    hintBuild = std::async(std::launch::async, [level] { return std::make_unique<DistanceField>(*level); });
+
     // Render the game once when entering this state
     renderGame();
 
     // Main game loop - keep getting input until quit or level complete
-    int ch;
-    while (currentState == GameState::PLAYING) {
-        ch = getch();
+    while (session->getState() == GameState::PLAYING) {
+        int ch = input->getKey();
+        std::uint64_t keyTime = latency ? latencyNow() : 0;
 
-        if (ch == 'q' || ch == 'Q') {
-            currentState = GameState::QUIT;
+        if (ch == 'q' || ch == 'Q' || ch == InputSource::END_OF_INPUT) {
+            session->setState(GameState::QUIT);
             return;
         }
+        if (ch == InputSource::RESIZE) {
+            renderer->invalidate();
+            renderGame();
+            continue;
+        }
 
-        handlePlayerInput(ch);
-        checkGoalReached();
+        KeyBatch batch;
+        batch.start = session->getPlayer().getPosition();
+        batch.keyTime = keyTime;
+        applyKey(ch, batch);
+
+        // Typeahead: apply every key that is already waiting (held or pasted keys)
+        // in order, stopping at the goal, then draw the result once
+        while (options.coalesceInput && session->getState() == GameState::PLAYING) {
+            std::uint64_t pollStart = latency ? latencyNow() : 0;
+            int next = input->pollKey();
+            if (latency) {
+                latency->record(LatencyStage::INPUT, pollStart, latencyNow());
+            }
+            if (next == InputSource::NO_KEY) {
+                break;
+            }
+            if (next == 'q' || next == 'Q' || next == InputSource::END_OF_INPUT) {
+                session->setState(GameState::QUIT);
+                return;
+            }
+            if (next == InputSource::RESIZE) {
+                batch.resized = true;
+                continue;
+            }
+            applyKey(next, batch);
+        }
+
+        if (batch.resized) {
+            renderer->invalidate();
+            renderGame();
+        } else {
+            renderBatch(batch);
+        }
+        if (latency) {
+            latency->record(LatencyStage::TOTAL, batch.keyTime, latencyNow());
+        }
+        inputStats.keys += batch.keys;
+        ++inputStats.refreshes;
     }
 }
 
 void Game::handleLevelCompleteState() {
     showLevelCompleteScreen();
 
-    // Add score for completed level
-    scoreManager->addLevelScore(currentLevel + 1, player->getMoveCount());
-
-    if (currentLevel + 1 >= MAX_LEVELS) {
-        currentState = GameState::WINNER;
-    } else {
-        nextLevel();
-        currentState = GameState::PLAYING;
-    }
+    // Add score for completed level and advance (or finish the run)
+    session->completeLevel();
 }
 
 void Game::handleWinnerState() {
-    showWinnerScreen();
-
-    // Save high score if it's a new record
-    if (scoreManager->isNewHighScore()) {
-        scoreManager->saveHighScore();
+    // Append the run to the run log first, so the tables include it
+    bool newHighScore = session->getScoreManager().isNewHighScore();
+    session->finishRun();
+    if (replay) {
+        saveReplay();
     }
 
+    showWinnerScreen(newHighScore);
+
     if (askContinue()) {
-        currentState = GameState::MENU;
+        session->setState(GameState::MENU);
     } else {
-        currentState = GameState::QUIT;
+        session->setState(GameState::QUIT);
     }
 }
 
-void Game::handlePlayerInput(int ch) {
+void Game::applyKey(int ch, KeyBatch& batch) {
     Direction dir;
+    ++batch.keys;
+    batch.lastKey = ch;
+    batch.hint = ch == 'h' || ch == 'H';
+    batch.lastKeyValid = batch.hint || keyToDirection(ch, dir);
+    if (batch.hint) {
+        return; // Changes nothing, so replays leave it out
+    }
 
-    try {
-        dir = charToDirection(ch);
-    } catch (const GameException&) {
-        // Invalid key pressed
-        beep();
-        ::move(levels[currentLevel]->getRows() + 6, 3);
-        attrset(COLOR_PAIR(static_cast<int>(ColorPair::RED)));
-        printw("'%c' is Invalid Key.... (code: %d)", ch, ch);
-        refresh();
+    if (!batch.lastKeyValid) {
+        batch.blocked = true; // Invalid keys beep too
+        if (replay) {
+            replay->addInvalidKey(ch);
+        }
         return;
     }
+    if (replay) {
+        replay->addMove(dir);
+    }
 
-    // Show that we received valid input
-    ::move(levels[currentLevel]->getRows() + 6, 3);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-    printw("Key pressed: %c                    ", ch);
+    if (session->move(dir) != MoveResult::BLOCKED) {
+        batch.moved = true;
+    } else {
+        batch.blocked = true;
+    }
+}
 
-    // Try to move player
-    if (player->move(dir, *levels[currentLevel])) {
-        // Movement successful - clear old position and render at new position
-        player->clearLastPosition();
-        player->render();
+void Game::renderBatch(const KeyBatch& batch) {
+    std::uint64_t renderStart = latency ? latencyNow() : 0;
+    int messageRow = BOARD_ROW + camera.getRows() + 3;
+    if (batch.hint) {
+        renderHint(messageRow);
+    } else if (batch.lastKeyValid) {
+        // Show that we received valid input
+        renderer->print(messageRow, 3, ColorPair::GREEN,
+                        "Key pressed: %c                                   ", batch.lastKey);
+    } else {
+        renderer->print(messageRow, 3, ColorPair::RED,
+                        "'%c' is Invalid Key.... (code: %d)                ", batch.lastKey, batch.lastKey);
+    }
+
+    if (batch.moved) {
+        // Scroll if the player neared the edge, otherwise just clear the position the
+        // batch started from and render at the new one
+        const Position& pos = session->getPlayer().getPosition();
+        if (camera.follow(pos)) {
+            renderBoard();
+        } else if (!(pos == batch.start)) {
+            renderer->drawChar(BOARD_ROW + batch.start.row - camera.getTop(),
+                               BOARD_COL + batch.start.col - camera.getLeft(), ColorPair::GREEN, ' ');
+        }
 
         // Update the UI to show new move count
         renderUI();
-        refresh(); // Update the screen immediately
-    } else {
-        // Movement failed - re-render player at current position
-        player->render();
-        refresh();
+    }
+    renderPlayer();
+
+    if (batch.blocked) {
+        renderer->beep();
+    }
+
+    std::uint64_t refreshStart = latency ? latencyNow() : 0;
+    renderer->refresh(); // One screen update per batch
+    if (latency) {
+        latency->record(LatencyStage::RENDER, renderStart, refreshStart);
+        latency->record(LatencyStage::REFRESH, refreshStart, latencyNow());
     }
 }
 
-Direction Game::charToDirection(int ch) const {
-    switch (ch) {
-        case 'w': case 'W': return Direction::UP;
-        case 's': case 'S': return Direction::DOWN;
-        case 'a': case 'A': return Direction::LEFT;
-        case 'd': case 'D': return Direction::RIGHT;
-        default:
-            throw GameException("Invalid direction key");
+// The hint is for where the batch left the player
+void Game::renderHint(int row) {
+    static const char* const MOVES[] = {"W (up)", "S (down)", "A (left)", "D (right)"};
+    if (!hints && hintBuild.valid()) {
+        if (hintBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            renderer->print(row, 3, ColorPair::YELLOW, "%-50s", "Hint: not ready yet, press H again");
+            return;
+        }
+        try {
+            hints = hintBuild.get();
+        } catch (const std::exception&) { // Too many cells, or no memory for the field
+        }
+    }
+    if (!hints) {
+        renderer->print(row, 3, ColorPair::RED, "%-50s", "Hint: not available on this level");
+        return;
+    }
+
+    const Position& pos = session->getPlayer().getPosition();
+    std::uint64_t hintStart = latency ? latencyNow() : 0;
+    Direction dir;
+    bool found = hints->bestMove(pos, dir);
+    if (latency) {
+        latency->record(LatencyStage::HINT, hintStart, latencyNow());
+    }
+
+    // Padded to cover the longest message shown on this row
+    if (found) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "Hint: %s, %u moves to the goal", MOVES[static_cast<int>(dir)],
+                      hints->distance(pos));
+        renderer->print(row, 3, ColorPair::YELLOW, "%-50s", text);
+    } else if (hints->isRepairing()) {
+        renderer->print(row, 3, ColorPair::YELLOW, "%-50s", "Hint: walls moved, press H again");
+    } else {
+        renderer->print(row, 3, ColorPair::RED, "%-50s", "Hint: no way to the goal from here");
     }
 }
 
@@ -399,245 +385,255 @@ void Game::renderGame() {
     clearScreen();
 
     // Render header
-    ::move(1, 30);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::RED)));
-    printw("MULA WEE (Optimized Version 2.0)");
-
-    ::move(2, 3);
-    printw("Level: %d", currentLevel + 1);
+    renderer->drawText(1, 30, ColorPair::RED, "MULA WEE (Optimized Version 2.0)");
+    renderer->print(2, 3, ColorPair::RED, "Level: %d", session->getCurrentLevel() + 1);
 
-    // Render level
-    levels[currentLevel]->render();
+    // Render the visible part of the level
+    setupCamera();
+    renderBoard();
 
     // Render player
-    player->render();
+    renderPlayer();
 
     // Render UI
     renderUI();
 
-    refresh();
+    renderer->refresh();
 }
 
-void Game::renderUI() {
-    int uiRow = levels[currentLevel]->getRows() + 4;
+void Game::setupCamera() {
+    const Level& level = session->getLevel();
+    int viewRows = level.getRows();
+    int viewCols = level.getCols();
 
-    ::move(uiRow, 3);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::BLUE)));
-    printw("Position: (%d, %d)",
-           player->getPosition().row - 3,
-           player->getPosition().col - 3);
+    int screenRows, screenCols;
+    if (renderer->getScreenSize(screenRows, screenCols)) {
+        viewRows = std::min(viewRows, screenRows - BOARD_ROW - UI_ROWS);
+        viewCols = std::min(viewCols, screenCols - BOARD_COL - 1);
+    }
+    camera.reset(level.getRows(), level.getCols(), viewRows, viewCols);
+    camera.follow(session->getPlayer().getPosition());
+}
 
-    ::move(uiRow + 1, 3);
-    printw("Moves: %d", player->getMoveCount());
+void Game::renderBoard() {
+    // Only the window is copied out, so the cost follows the terminal, not the level
+    renderer->drawLevelWindow(session->getLevel(), BOARD_ROW, BOARD_COL, camera.getTop(),
+                              camera.getLeft(), camera.getRows(), camera.getCols());
+}
 
-    ::move(uiRow + 2, 3);
-    printw("Score: %d", scoreManager->getCurrentScore());
+void Game::renderPlayer() {
+    const Position& pos = session->getPlayer().getPosition();
+    renderer->drawChar(BOARD_ROW + pos.row - camera.getTop(), BOARD_COL + pos.col - camera.getLeft(),
+                       ColorPair::YELLOW, '*');
+}
 
-    ::move(uiRow + 3, 3);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("Controls: WASD to move, Q to quit");
+void Game::renderUI() {
+    int uiRow = BOARD_ROW + camera.getRows() + 1;
+    const Player& player = session->getPlayer();
+
+    renderer->print(uiRow, 3, ColorPair::BLUE, "Position: (%d, %d)",
+                    player.getPosition().row, player.getPosition().col);
+    renderer->print(uiRow + 1, 3, ColorPair::BLUE, "Moves: %d", player.getMoveCount());
+    renderer->print(uiRow + 2, 3, ColorPair::BLUE, "Score: %d",
+                    session->getScoreManager().getCurrentScore());
+    renderer->drawText(uiRow + 3, 3, ColorPair::YELLOW, "Controls: WASD to move, H for a hint, Q to quit");
 }
 
 void Game::renderHelp() {
-    int helpRow = levels[currentLevel]->getRows() + 8;
-
-    ::move(helpRow, 10);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("ATTENTION! Navigate to the yellow box ($) to win!");
+    int helpRow = BOARD_ROW + camera.getRows() + 5;
 
-    ::move(helpRow + 1, 10);
-    printw("Use WASD keys to move. Avoid walls (|, %%).");
+    renderer->drawText(helpRow, 10, ColorPair::YELLOW,
+                       "ATTENTION! Navigate to the yellow box ($) to win!");
+    renderer->drawText(helpRow + 1, 10, ColorPair::YELLOW,
+                       "Use WASD keys to move. Avoid walls (|, %).");
 }
 
 void Game::showWelcomeScreen() {
     clearScreen();
+    const ScoreManager& scores = session->getScoreManager();
 
     // Draw border
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::RED)));
     for (int i = 2; i < 72; i++) {
-        mvprintw(2, i, "*");
-        mvprintw(22, i, "*");
+        renderer->drawChar(2, i, ColorPair::RED, '*');
+        renderer->drawChar(22, i, ColorPair::RED, '*');
     }
     for (int i = 2; i < 23; i++) {
-        mvprintw(i, 2, "*");
-        mvprintw(i, 72, "*");
+        renderer->drawChar(i, 2, ColorPair::RED, '*');
+        renderer->drawChar(i, 72, ColorPair::RED, '*');
     }
 
     // Game title
-    ::move(6, 30);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("MULA WEE");
-
-    ::move(7, 25);
-    printw("Optimized Version 2.0");
+    renderer->drawText(6, 30, ColorPair::YELLOW, "MULA WEE");
+    renderer->drawText(7, 25, ColorPair::YELLOW, "Optimized Version 2.0");
 
     // Instructions
-    ::move(10, 8);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-    printw("Navigate through the maze to reach the goal ($)");
-
-    ::move(12, 8);
-    printw("Controls:");
-    ::move(13, 12);
-    printw("W - Move Up");
-    ::move(14, 12);
-    printw("A - Move Left");
-    ::move(15, 12);
-    printw("S - Move Down");
-    ::move(16, 12);
-    printw("D - Move Right");
-    ::move(17, 12);
-    printw("Q - Quit Game");
+    renderer->drawText(10, 8, ColorPair::GREEN, "Navigate through the maze to reach the goal ($)");
+    renderer->drawText(12, 8, ColorPair::GREEN, "Controls:");
+    renderer->drawText(13, 12, ColorPair::GREEN, "W - Move Up");
+    renderer->drawText(14, 12, ColorPair::GREEN, "A - Move Left");
+    renderer->drawText(15, 12, ColorPair::GREEN, "S - Move Down");
+    renderer->drawText(16, 12, ColorPair::GREEN, "D - Move Right");
+    renderer->drawText(17, 12, ColorPair::GREEN, "H - Hint");
+    renderer->drawText(18, 12, ColorPair::GREEN, "Q - Quit Game");
 
     // High score
-    ::move(19, 8);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::BLUE)));
-    printw("High Score: %s - %d",
-           scoreManager->getHighScorePlayerName().c_str(),
-           scoreManager->getHighScore());
+    renderer->print(19, 8, ColorPair::BLUE, "High Score: %s - %d",
+                    scores.getHighScorePlayerName().c_str(), scores.getHighScore());
+
+    refreshLeaderboard();
+    renderLeaderboard(12, 42);
 
-    refresh();
+    renderer->refresh();
 }
 
-void Game::showWinnerScreen() {
+void Game::showWinnerScreen(bool newHighScore) {
     clearScreen();
+    const ScoreManager& scores = session->getScoreManager();
 
     // Draw decorative border
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::RED)));
     for (int i = 2; i < 71; i++) {
         for (int j = 2; j < 21; j++) {
             if ((i > 4 && i < 71) && (j == 2 || j == 20)) {
-                mvprintw(j, i, "*");
+                renderer->drawChar(j, i, ColorPair::RED, '*');
             } else if ((i == 2 || i == 70) && (j < 19 && j > 3)) {
-                mvprintw(j, i, "*");
+                renderer->drawChar(j, i, ColorPair::RED, '*');
             }
         }
     }
 
     // Winner message
-    ::move(5, 32);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("---MULA WEE---");
-
-    ::move(7, 20);
-    printw("YOU ARE THE WINNER!");
+    renderer->drawText(5, 32, ColorPair::YELLOW, "---MULA WEE---");
+    renderer->drawText(7, 20, ColorPair::YELLOW, "YOU ARE THE WINNER!");
 
     // Score display
-    ::move(10, 20);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-    if (scoreManager->isNewHighScore()) {
-        printw("NEW HIGH SCORE!");
-        ::move(11, 20);
-        printw("%s: %d",
-               scoreManager->getCurrentPlayerName().c_str(),
-               scoreManager->getCurrentScore());
+    if (newHighScore) {
+        renderer->drawText(10, 20, ColorPair::GREEN, "NEW HIGH SCORE!");
+        renderer->print(11, 20, ColorPair::GREEN, "%s: %d",
+                        scores.getCurrentPlayerName().c_str(), scores.getCurrentScore());
     } else {
-        printw("Your Score: %d", scoreManager->getCurrentScore());
-        ::move(11, 20);
-        printw("High Score: %s - %d",
-               scoreManager->getHighScorePlayerName().c_str(),
-               scoreManager->getHighScore());
+        renderer->print(10, 20, ColorPair::GREEN, "Your Score: %d", scores.getCurrentScore());
+        renderer->print(11, 20, ColorPair::GREEN, "High Score: %s - %d",
+                        scores.getHighScorePlayerName().c_str(), scores.getHighScore());
     }
 
-    // Credits
-    ::move(16, 10);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::BLUE)));
-    printw("Original by: Nipuna Perera (2004)");
-    ::move(17, 10);
-    printw("Optimized Version: 2024");
-
-    ::move(19, 20);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("Press any key to continue...");
-
-    refresh();
-    getch();
-}
-
-void Game::showLevelCompleteScreen() {
-    clearScreen();
-
-    ::move(8, 25);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::GREEN)));
-    printw("Level %d Complete!", currentLevel + 1);
-
-    ::move(10, 25);
-    printw("Moves: %d", player->getMoveCount());
-
-    ::move(11, 25);
-    printw("Level Score: %d",
-           scoreManager->calculateLevelScore(currentLevel + 1, player->getMoveCount()));
-
-    ::move(12, 25);
-    printw("Total Score: %d", scoreManager->getCurrentScore());
-
-    if (currentLevel + 1 < MAX_LEVELS) {
-        ::move(15, 25);
-        attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-        printw("Preparing Level %d...", currentLevel + 2);
-    } else {
-        ::move(15, 25);
-        attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-        printw("All levels complete! Calculating final score...");
+    // Where this player stands among every run in the log
+    refreshLeaderboard();
+    LeaderboardEntry best;
+    if (leaderboard && leaderboard->playerBest(scores.getCurrentPlayerName(), best)) {
+        renderer->print(13, 20, ColorPair::GREEN, "Your Best: %d", best.score);
+        renderer->print(14, 20, ColorPair::GREEN, "Rank %zu of %zu",
+                        leaderboard->playerRank(scores.getCurrentPlayerName()), leaderboard->getRunCount());
     }
+    renderLeaderboard(12, 44);
 
-    ::move(20, 25);
-    printw("Press any key to continue...");
-
-    refresh();
-    getch();
-}
-
-void Game::startLevel(int level) {
-    if (level < 0 || level >= MAX_LEVELS) {
-        throw GameException("Invalid level number");
-    }
+    // Credits
+    renderer->drawText(16, 10, ColorPair::BLUE, "Original by: Nipuna Perera (2004)");
+    renderer->drawText(17, 10, ColorPair::BLUE, "Optimized Version: 2024");
 
-    currentLevel = level;
+    renderer->drawText(19, 20, ColorPair::YELLOW, "Press any key to continue...");
 
-    // Reset player position for the new level
-    Position startPos(20, 4); // Default starting position
-    player->reset(startPos);
+    renderer->refresh();
+    waitForKeyPress();
 }
 
-void Game::checkGoalReached() {
-    Position playerPos = player->getPosition();
-    Position adjustedPos(playerPos.row - 3, playerPos.col - 3); // Adjust for rendering offset
+void Game::renderLeaderboard(int row, int col) {
+    if (!leaderboard) {
+        return;
+    }
 
-    // Check if player is on a goal cell (same logic as original game)
-    CellType cellType = levels[currentLevel]->getCellType(adjustedPos);
-    if (cellType == CellType::GOAL) {
-        currentState = GameState::LEVEL_COMPLETE;
+    std::vector<LeaderboardEntry> top = leaderboard->topRuns(LEADERBOARD_LINES);
+    if (top.empty()) {
+        return;
+    }
+    renderer->drawText(row, col, ColorPair::BLUE, "TOP SCORES");
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        renderer->print(row + 1 + static_cast<int>(i), col, ColorPair::BLUE, "%zu. %-12.12s %5d", i + 1,
+                        top[i].playerName.c_str(), top[i].score);
     }
 }
 
-void Game::nextLevel() {
-    if (currentLevel + 1 < MAX_LEVELS) {
-        startLevel(currentLevel + 1);
+void Game::showLevelCompleteScreen() {
+    clearScreen();
+    const ScoreManager& scores = session->getScoreManager();
+    int level = session->getCurrentLevel() + 1;
+    int moves = session->getPlayer().getMoveCount();
+
+    renderer->print(8, 25, ColorPair::GREEN, "Level %d Complete!", level);
+    renderer->print(10, 25, ColorPair::GREEN, "Moves: %d", moves);
+    renderer->print(11, 25, ColorPair::GREEN, "Level Score: %d",
+                    scores.calculateLevelScore(level, moves));
+    renderer->print(12, 25, ColorPair::GREEN, "Total Score: %d", scores.getCurrentScore());
+
+    if (!session->isLastLevel()) {
+        renderer->print(15, 25, ColorPair::YELLOW, "Preparing Level %d...", level + 1);
+    } else {
+        renderer->drawText(15, 25, ColorPair::YELLOW,
+                           "All levels complete! Calculating final score...");
     }
+
+    renderer->drawText(20, 25, ColorPair::YELLOW, "Press any key to continue...");
+
+    renderer->refresh();
+    waitForKeyPress();
 }
 
 bool Game::askContinue() {
     clearScreen();
 
-    ::move(10, 30);
-    attrset(COLOR_PAIR(static_cast<int>(ColorPair::YELLOW)));
-    printw("Play again? (y/n): ");
+    renderer->drawText(10, 30, ColorPair::YELLOW, "Play again? (y/n): ");
+    renderer->refresh();
 
-    char ch;
+    int ch;
     do {
-        ch = getch();
+        ch = input->getKey();
+        if (ch == InputSource::END_OF_INPUT) {
+            return false;
+        }
     } while (ch != 'y' && ch != 'Y' && ch != 'n' && ch != 'N');
 
     return (ch == 'y' || ch == 'Y');
 }
 
+void Game::saveReplay() {
+    // <dir>/<name>-<unix ms>-<pid>.mwr, with the name reduced to file-safe characters; the
+    // pid keeps games sharing the directory from replacing each other's replays
+    std::string name = replay->getPlayerName().empty() ? "player" : replay->getPlayerName();
+    for (char& ch : name) {
+        if (!std::isalnum(static_cast<unsigned char>(ch))) {
+            ch = '_';
+        }
+    }
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+    replay->setScore(session->getScoreManager().getCurrentScore());
+    replay->save(options.replayDir + "/" + name + "-" + std::to_string(millis) + "-" +
+                 std::to_string(::getpid()) + ReplayFormat::EXTENSION);
+    *replay = Replay();
+}
+
+void Game::refreshLeaderboard() {
+    if (options.runLogFile.empty()) {
+        return;
+    }
+    try {
+        if (leaderboard) {
+            leaderboard->refresh();
+        } else {
+            leaderboard = std::make_unique<Leaderboard>(options.runLogFile);
+        }
+    } catch (const GameException&) {
+        // The tables are extras; an index we cannot write just hides them until the next screen
+        leaderboard.reset();
+    }
+}
+
 void Game::clearScreen() {
-    clear();
+    renderer->clear();
 }
 
 void Game::waitForKeyPress() {
-    getch();
+    input->waitForKeyPress();
 }
 
 } // namespace MulaWee
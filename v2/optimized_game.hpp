@@ -1,233 +1,132 @@
 #pragma once
 
-#include <ncurses.h>
-#include <vector>
-#include <string>
+#include "camera.hpp"
+#include "distance_field.hpp"
+#include "game_core.hpp"
+#include "latency.hpp"
+#include "leaderboard.hpp"
+#include "level_cache.hpp"
+#include "renderer.hpp"
+#include "replay.hpp"
+#include <future>
 #include <memory>
-#include <fstream>
-#include <stdexcept>
+#include <string>
+#include <thread>
 
 namespace MulaWee {
 
-// Modern enums for better type safety
-enum class CellType : char {
-    WALL = 0,
-    PATH = 1,
-    GOAL = 2
-};
-
-enum class GameState {
-    MENU,
-    PLAYING,
-    LEVEL_COMPLETE,
-    GAME_OVER,
-    WINNER,
-    QUIT
-};
-
-enum class Direction {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-};
-
-// Color pairs for ncurses
-enum class ColorPair : int {
-    RED = 1,
-    GREEN = 2,
-    BLUE = 3,
-    YELLOW = 4,
-    GOAL = 5,
-    DEFAULT = 6
+// Where the game finds its data. Relative paths missing from the working directory
+// are looked up beside the binary; with no level files at all the game plays the
+// levels built into it.
+struct GameOptions {
+    std::string dataDir = "../data";
+    std::string runLogFile = "../data/runs.mwlog"; // Every finished run is appended here
+    bool coalesceInput = true; // Apply every key already waiting before redrawing
+    std::string latencyFile;   // Per-stage latency percentiles written here on exit (empty = off)
+    std::string replayDir;     // Each run is saved here as a compact replay (empty = off)
+    std::size_t levelCacheBytes = LevelCache::DEFAULT_BUDGET; // Levels kept loaded
+    std::string levelPack;     // Play the levels in this pack instead of dataDir (empty = off)
+    bool embeddedLevels = false; // Play the built-in levels and read no level files
 };
 
-// Position structure for better coordinate handling
-struct Position {
-    int row, col;
+// Keys handled and screen refreshes while playing
+struct InputStats {
+    std::size_t keys = 0;
+    std::size_t refreshes = 0;
 
-    Position(int r = 0, int c = 0) : row(r), col(c) {}
-
-    Position operator+(const Position& other) const {
-        return Position(row + other.row, col + other.col);
-    }
-
-    bool operator==(const Position& other) const {
-        return row == other.row && col == other.col;
+    double keysPerRefresh() const {
+        return refreshes ? static_cast<double>(keys) / refreshes : 0.0;
     }
 };
 
-// Exception classes for better error handling
-class GameException : public std::runtime_error {
-public:
-    explicit GameException(const std::string& message)
-        : std::runtime_error("Game Error: " + message) {}
-};
-
-class FileException : public GameException {
-public:
-    explicit FileException(const std::string& filename)
-        : GameException("Failed to open file: " + filename) {}
-};
-
-// Level class - encapsulates level data and operations
-class Level {
-private:
-    std::vector<std::vector<CellType>> grid;
-    int rows, cols;
-    Position goalPosition;
-    std::string filename;
-
-public:
-    explicit Level(const std::string& levelFile);
-
-    // Getters
-    int getRows() const { return rows; }
-    int getCols() const { return cols; }
-    const Position& getGoalPosition() const { return goalPosition; }
-    CellType getCellType(const Position& pos) const;
-
-    // Validation
-    bool isValidPosition(const Position& pos) const;
-    bool canMoveTo(const Position& pos) const;
-
-    // Rendering
-    void render(int startRow = 3, int startCol = 3) const;
-
-private:
-    void loadFromFile();
-    char cellTypeToChar(CellType type) const;
-};
-
-// Player class - encapsulates player state and movement
-class Player {
-private:
-    Position position;
-    Position lastPosition;
-    int moveCount;
-
-public:
-    Player(const Position& startPos = Position(20, 4))
-        : position(startPos), lastPosition(startPos), moveCount(0) {}
-
-    // Movement
-    bool move(Direction dir, const Level& level);
-    void setPosition(const Position& pos) { position = pos; }
-
-    // Getters
-    const Position& getPosition() const { return position; }
-    const Position& getLastPosition() const { return lastPosition; }
-    int getMoveCount() const { return moveCount; }
-
-    // Reset for new level
-    void reset(const Position& startPos);
-
-    // Rendering
-    void render();
-    void clearLastPosition();
-
-private:
-    Position getDirectionOffset(Direction dir) const;
-};
-
-// Score management class
-class ScoreManager {
-private:
-    std::string highScoreFile;
-    std::string currentPlayerName;
-    int currentScore;
-    std::string highScorePlayerName;
-    int highScore;
-
-public:
-    explicit ScoreManager(const std::string& scoreFile = "../data/score.dat");
-
-    // Score operations
-    void addLevelScore(int level, int moves);
-    void setPlayerName(const std::string& name) { currentPlayerName = name; }
-
-    // High score management
-    void loadHighScore();
-    void saveHighScore();
-    bool isNewHighScore() const { return currentScore > highScore; }
-
-    // Getters
-    int getCurrentScore() const { return currentScore; }
-    int getHighScore() const { return highScore; }
-    const std::string& getCurrentPlayerName() const { return currentPlayerName; }
-    const std::string& getHighScorePlayerName() const { return highScorePlayerName; }
-
-    // Reset
-    void resetScore() { currentScore = 0; }
-
-    // Public method for calculating level scores
-    int calculateLevelScore(int level, int moves) const;
-
-private:
-};
-
-// RAII wrapper for ncurses - ensures proper cleanup
-class NCursesWrapper {
-private:
-    bool initialized;
-
-public:
-    NCursesWrapper();
-    ~NCursesWrapper();
-
-    // Delete copy constructor and assignment operator
-    NCursesWrapper(const NCursesWrapper&) = delete;
-    NCursesWrapper& operator=(const NCursesWrapper&) = delete;
-
-    void initializeColors();
-    void cleanup();
-};
-
-// Main game class - orchestrates all game components
+// Main game class - drives a GameSession through a renderer and an input source
 class Game {
 private:
-    std::unique_ptr<NCursesWrapper> ncursesWrapper;
-    std::unique_ptr<ScoreManager> scoreManager;
-    std::unique_ptr<Player> player;
-    std::vector<std::unique_ptr<Level>> levels;
-
-    GameState currentState;
-    int currentLevel;
-    static constexpr int MAX_LEVELS = 3;
+    std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<InputSource> input;
+    std::unique_ptr<GameSession> session;
+    GameOptions options;
+    Camera camera; // Visible part of the current level
+    std::unique_ptr<DistanceField> hints;     // Distances to the current level's goal, for the hint key
+    std::future<std::unique_ptr<DistanceField>> hintBuild; // Becomes `hints` once the background BFS is done
+    InputStats inputStats;
+    std::unique_ptr<LatencyRecorder> latency; // Only when options.latencyFile is set
+    std::unique_ptr<Replay> replay;           // Only when options.replayDir is set
+    std::unique_ptr<Leaderboard> leaderboard; // Opened with the first screen that shows it
+    std::thread compaction;                   // Rewrites an oversized run log during play
+    std::string compactionError;
+
+    // What one batch of keys changed; drawn once after the batch
+    struct KeyBatch {
+        Position start;       // Player position before the batch
+        int lastKey = 0;
+        bool lastKeyValid = true;
+        bool moved = false;
+        bool blocked = false; // Beep once, however many moves hit a wall
+        bool resized = false;
+        bool hint = false;    // The batch ended with the hint key
+        std::size_t keys = 0;
+        std::uint64_t keyTime = 0; // When the first key arrived (latency reporting only)
+    };
+
+    // Screen offset of the level's top-left cell
+    static constexpr int BOARD_ROW = 3;
+    static constexpr int BOARD_COL = 3;
+
+    // Screen rows under the board used by the HUD and messages
+    static constexpr int UI_ROWS = 5;
+
+    // Lines in the leaderboard tables
+    static constexpr std::size_t LEADERBOARD_LINES = 5;
+
+    // Run logs past this size are compacted in the background at startup
+    static constexpr std::uint64_t COMPACT_LOG_BYTES = 1 << 20;
+    static constexpr std::size_t COMPACT_KEEP_PER_PLAYER = 10;
 
 public:
-    Game();
-    ~Game() = default;
+    Game(std::unique_ptr<Renderer> gameRenderer, std::unique_ptr<InputSource> gameInput,
+         GameOptions gameOptions = GameOptions());
+    ~Game();
 
     // Main game loop
     void run();
 
+    // Session state (valid after run() has loaded the levels)
+    const GameSession* getSession() const { return session.get(); }
+
+    const InputStats& getInputStats() const { return inputStats; }
+
 private:
     // Game state management
     void initializeGame();
-    void loadLevels();
+    void startCompaction();
+    std::shared_ptr<LevelSource> openLevels() const;
     void handleMenuState();
     void handlePlayingState();
     void handleLevelCompleteState();
     void handleWinnerState();
 
     // Input handling
-    void handlePlayerInput(int ch);
-    Direction charToDirection(int ch) const;
+    void applyKey(int ch, KeyBatch& batch);
+    void renderBatch(const KeyBatch& batch);
+    void renderHint(int row);
 
     // UI rendering
     void renderGame();
+    void setupCamera();
+    void renderBoard();
+    void renderPlayer();
     void renderUI();
     void renderHelp();
     void showWelcomeScreen();
-    void showWinnerScreen();
+    void showWinnerScreen(bool newHighScore);
+    void renderLeaderboard(int row, int col);
     void showLevelCompleteScreen();
 
     // Game logic
-    void startLevel(int level);
-    void checkGoalReached();
-    void nextLevel();
     bool askContinue();
+    void saveReplay();
+    void refreshLeaderboard();
 
     // Utility
     void clearScreen();
@@ -0,0 +1,193 @@
+#include "level_pack.hpp"
+#include "level_validator.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/stat.h>
+
+// Level pack tool - builds, lists, extracts and benchmarks .mwpk packs
+//
+//   mulavee_pack build [--store] -o PACK LEVEL...
+//   mulavee_pack list PACK
+//   mulavee_pack extract PACK [--level N] [-o DIR]
+//   mulavee_pack bench PACK [--count N]
+//   mulavee_pack validate PACK [--scalar]
+//
+// build packs text or compiled levels in the order given; --store skips compression.
+// extract writes each level as a compiled level (DIR/NAME.mwl, default DIR ".").
+// bench opens the pack and loads N levels at random, timing both, and the same loads
+// again with validation (what the game pays).
+// validate checks every level with LevelValidator (--scalar: without AVX2) and times it.
+
+namespace {
+
+using namespace MulaWee;
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " build [--store] -o PACK LEVEL... | list PACK"
+              << " | extract PACK [--level N] [-o DIR] | bench PACK [--count N] | validate PACK [--scalar]"
+              << std::endl;
+}
+
+double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int buildPack(const std::vector<std::string>& inputs, const std::string& output, bool compress) {
+    auto start = std::chrono::steady_clock::now();
+    LevelPack::build(inputs, output, compress);
+    double took = microsecondsSince(start);
+
+    LevelPack pack(output);
+    std::uint64_t gridBytes = 0, storedBytes = 0;
+    for (std::size_t i = 0; i < pack.size(); ++i) {
+        const LevelPackFormat::IndexEntry& entry = pack.getEntry(i);
+        gridBytes += PackedGrid::bytesFor(entry.rows, entry.cols);
+        storedBytes += entry.storedBytes;
+    }
+    struct stat info;
+    std::uint64_t fileSize = ::stat(output.c_str(), &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+    std::cerr << output << ": " << pack.size() << " levels, grids " << gridBytes << " -> " << storedBytes
+              << " bytes, " << fileSize << " bytes in all, built in " << std::fixed << std::setprecision(1)
+              << took / 1000 << " ms" << std::endl;
+    return 0;
+}
+
+int listPack(const std::string& path) {
+    LevelPack pack(path);
+    for (std::size_t i = 0; i < pack.size(); ++i) {
+        const LevelPackFormat::IndexEntry& entry = pack.getEntry(i);
+        std::cout << std::setw(5) << i + 1 << "  " << std::left << std::setw(16) << pack.getName(i) << std::right
+                  << entry.rows << "x" << entry.cols << " start (" << entry.startRow << ", " << entry.startCol
+                  << ") goal (" << entry.goalRow << ", " << entry.goalCol << ") checksum " << std::hex
+                  << entry.checksum << std::dec << ", " << entry.storedBytes << " bytes "
+                  << (entry.compression == LevelPackFormat::OPEN_CELLS ? "open cells" : "stored") << std::endl;
+    }
+    return 0;
+}
+
+int extractPack(const std::string& path, int level, const std::string& directory) {
+    LevelPack pack(path);
+    std::size_t first = level > 0 ? static_cast<std::size_t>(level - 1) : 0;
+    std::size_t last = level > 0 ? first + 1 : pack.size();
+    for (std::size_t i = first; i < last; ++i) {
+        std::string output = directory + "/" + pack.getName(i) + LevelFormat::EXTENSION;
+        LevelFormat::write(*pack.load(i), output);
+        std::cout << output << std::endl;
+    }
+    return 0;
+}
+
+int benchPack(const std::string& path, long long count) {
+    auto start = std::chrono::steady_clock::now();
+    LevelPack pack(path);
+    double opened = microsecondsSince(start);
+    if (pack.size() == 0) {
+        std::cerr << path << " has no levels" << std::endl;
+        return 1;
+    }
+
+    // The same random levels loaded as stored, then through get() with validation
+    std::mt19937_64 random(42);
+    std::uint64_t cells = 0;
+    start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < count; ++i) {
+        std::shared_ptr<const Level> level = pack.load(random() % pack.size());
+        cells += static_cast<std::uint64_t>(level->getRows()) * level->getCols();
+    }
+    double took = microsecondsSince(start);
+    random.seed(42);
+    start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < count; ++i) {
+        pack.get(random() % pack.size());
+    }
+    double validated = microsecondsSince(start);
+    std::cerr << pack.size() << " levels opened in " << std::fixed << std::setprecision(1) << opened
+              << " us; " << count << " random loads (" << cells << " cells) at " << std::setprecision(2)
+              << took / static_cast<double>(count) << " us each, "
+              << validated / static_cast<double>(count) << " us validated" << std::endl;
+    return 0;
+}
+
+int validatePack(const std::string& path, bool allowAvx2) {
+    LevelPack pack(path);
+    LevelValidator validator(allowAvx2);
+    std::size_t unplayable = 0, warned = 0, groupUpdates = 0;
+    double took = 0;
+    for (std::size_t i = 0; i < pack.size(); ++i) {
+        std::shared_ptr<const Level> level = pack.load(i);
+        auto start = std::chrono::steady_clock::now();
+        LevelReport report = validator.validate(*level);
+        took += microsecondsSince(start);
+        groupUpdates += report.groupUpdates;
+
+        std::vector<std::string> problems = report.problems();
+        unplayable += report.isPlayable() ? 0 : 1;
+        warned += report.isPlayable() && !problems.empty() ? 1 : 0;
+        for (const std::string& problem : problems) {
+            std::cout << pack.getName(i) << ": " << problem << std::endl;
+        }
+    }
+    std::cerr << pack.size() << " levels validated in " << std::fixed << std::setprecision(1) << took / 1000
+              << " ms (" << std::setprecision(2) << took / static_cast<double>(std::max<std::size_t>(pack.size(), 1))
+              << " us each, " << groupUpdates << " group updates, " << (validator.usesAvx2() ? "avx2" : "scalar")
+              << "); " << unplayable << " unplayable, " << warned << " with warnings" << std::endl;
+    return unplayable == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string command;
+    std::string output;
+    std::vector<std::string> inputs;
+    bool compress = true;
+    bool allowAvx2 = true;
+    int level = 0;
+    long long count = 10000;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--store") == 0) {
+            compress = false;
+        } else if (std::strcmp(argv[i], "--scalar") == 0) {
+            allowAvx2 = false;
+        } else if (std::strcmp(argv[i], "--level") == 0 && hasValue) {
+            level = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--count") == 0 && hasValue) {
+            count = std::max(1LL, std::atoll(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            command.clear();
+            break;
+        } else if (command.empty()) {
+            command = argv[i];
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    try {
+        if (command == "build" && !output.empty() && !inputs.empty()) {
+            return buildPack(inputs, output, compress);
+        } else if (command == "list" && inputs.size() == 1) {
+            return listPack(inputs[0]);
+        } else if (command == "extract" && inputs.size() == 1) {
+            return extractPack(inputs[0], level, output.empty() ? "." : output);
+        } else if (command == "bench" && inputs.size() == 1) {
+            return benchPack(inputs[0], count);
+        } else if (command == "validate" && inputs.size() == 1) {
+            return validatePack(inputs[0], allowAvx2);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    printUsage(argv[0]);
+    return 2;
+}
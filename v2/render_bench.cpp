@@ -0,0 +1,136 @@
+#include "ncurses_backend.hpp"
+#include "level_format.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// Render benchmark - ncurses calls and time for one full level redraw
+//
+//   mulavee_render_bench [--data DIR] [--repeat N] [LEVEL...] > /dev/null
+//
+// Draws into the real ncurses screen (stdout, so redirect it) three ways:
+//   printw/cell   move + attrset + printw per cell, as the original level() does
+//   drawChar/cell attrset + mvaddch per cell, the previous Renderer::drawLevel
+//   drawLevel     visible rows translated from the packed grid, one mvaddchnstr per row
+// "draw" times the calls alone; "+refresh" adds a forced full repaint.
+
+namespace {
+
+using namespace MulaWee;
+
+struct Measurement {
+    double calls;
+    double drawUs;
+    double refreshUs;
+};
+
+template <typename Draw>
+Measurement measure(NCursesRenderer& renderer, int repeat, Draw draw, int callsPerDraw) {
+    Measurement m{0, 0, 0};
+    std::size_t before = renderer.getCursesCalls();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        draw();
+    }
+    std::chrono::duration<double, std::micro> drawn = std::chrono::steady_clock::now() - start;
+    std::size_t counted = renderer.getCursesCalls() - before;
+    m.calls = callsPerDraw >= 0 ? callsPerDraw : static_cast<double>(counted) / repeat;
+    m.drawUs = drawn.count() / repeat;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        clearok(stdscr, TRUE);
+        draw();
+        ::refresh();
+    }
+    std::chrono::duration<double, std::micro> refreshed = std::chrono::steady_clock::now() - start;
+    m.refreshUs = refreshed.count() / repeat;
+    return m;
+}
+
+void printwLevel(const Level& level) {
+    for (int r = 0; r < level.getRows(); ++r) {
+        for (int c = 0; c < level.getCols(); ++c) {
+            CellGlyph glyph = cellGlyph(level.getCellType(Position(r, c)));
+            ::move(r + 3, c + 3);
+            attrset(COLOR_PAIR(static_cast<int>(glyph.color)));
+            printw("%c", glyph.ch);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    int repeat = 200;
+    std::vector<std::string> levelFiles;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] != '-') {
+            levelFiles.push_back(argv[i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--data DIR] [--repeat N] [LEVEL...] > /dev/null"
+                      << std::endl;
+            return 2;
+        }
+    }
+
+    std::ostringstream report;
+    try {
+        if (levelFiles.empty()) {
+            for (int i = 1; i <= 3; ++i) {
+                std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+                std::string compiled = LevelFormat::compiledPathFor(path);
+                levelFiles.push_back(LevelFormat::isCompiled(compiled) ? compiled : path);
+            }
+        }
+
+        NCursesRenderer renderer;
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-24s %-14s %10s %12s %12s\n",
+                      "level", "method", "calls", "draw us", "+refresh us");
+        report << line;
+
+        for (const std::string& file : levelFiles) {
+            Level level(file);
+            int cells = level.getRows() * level.getCols();
+            const struct {
+                const char* name;
+                Measurement result;
+            } rows[] = {
+                {"printw/cell", measure(renderer, repeat, [&] { printwLevel(level); }, 3 * cells)},
+                {"drawChar/cell", measure(renderer, repeat, [&] {
+                     for (int r = 0; r < level.getRows(); ++r) {
+                         for (int c = 0; c < level.getCols(); ++c) {
+                             CellGlyph glyph = cellGlyph(level.getCellType(Position(r, c)));
+                             renderer.drawChar(r + 3, c + 3, glyph.color, glyph.ch);
+                         }
+                     }
+                 }, -1)},
+                {"drawLevel", measure(renderer, repeat, [&] { renderer.drawLevel(level, 3, 3); }, -1)},
+            };
+            for (const auto& row : rows) {
+                std::snprintf(line, sizeof(line), "%-24s %-14s %10.0f %12.1f %12.1f\n",
+                              level.getFilename().substr(level.getFilename().rfind('/') + 1).c_str(),
+                              row.name, row.result.calls, row.result.drawUs, row.result.refreshUs);
+                report << line;
+            }
+        }
+        renderer.shutdown();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cerr << report.str();
+    return 0;
+}
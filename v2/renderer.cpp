@@ -0,0 +1,219 @@
+#include "renderer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace MulaWee {
+
+CellGlyph cellGlyph(CellType type) {
+    switch (type) {
+        case CellType::PATH: return CellGlyph{' ', ColorPair::GREEN};
+        case CellType::GOAL: return CellGlyph{'$', ColorPair::GOAL};
+        case CellType::WALL:
+        default:             return CellGlyph{'|', ColorPair::GREEN};
+    }
+}
+
+namespace {
+
+// The four glyphs of every packed grid byte, lowest cell first
+struct ByteGlyphs {
+    CellGlyph cell[4];
+    CellGlyph byte[256][4];
+
+    ByteGlyphs()
+        : cell{cellGlyph(CellType::WALL), cellGlyph(CellType::PATH), cellGlyph(CellType::GOAL),
+               cellGlyph(CellType::WALL)} {
+        for (int b = 0; b < 256; ++b) {
+            for (int k = 0; k < 4; ++k) {
+                byte[b][k] = cell[(b >> (2 * k)) & 3];
+            }
+        }
+    }
+};
+
+const ByteGlyphs GLYPHS;
+
+} // namespace
+
+// Renderer implementation
+void Renderer::drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) {
+    int start = 0;
+    for (int i = 1; i <= count; ++i) {
+        if (i == count || glyphs[i].color != glyphs[start].color) {
+            std::string text(static_cast<std::size_t>(i - start), ' ');
+            for (int j = start; j < i; ++j) {
+                text[j - start] = glyphs[j].ch;
+            }
+            drawText(row, col + start, glyphs[start].color, text);
+            start = i;
+        }
+    }
+}
+
+// Only the visible cells are turned into glyphs, one row at a time from the packed
+// grid, so a redraw costs the window's size and never the level's
+void Renderer::drawLevelWindow(const Level& level, int screenRow, int screenCol,
+                               int top, int left, int rows, int cols) {
+    if (cols <= 0) {
+        return;
+    }
+    const PackedGrid& grid = level.getGrid();
+    windowRow.resize(static_cast<std::size_t>(cols));
+    CellGlyph* out = windowRow.data();
+    for (int r = 0; r < rows; ++r) {
+        std::size_t index = static_cast<std::size_t>(top + r) * level.getCols() + left;
+        int c = 0;
+        for (; c < cols && (index & 3) != 0; ++c, ++index) {
+            out[c] = GLYPHS.cell[static_cast<int>(grid.at(index))];
+        }
+        for (; c + 4 <= cols; c += 4, index += 4) { // Four cells per packed byte
+            std::memcpy(out + c, GLYPHS.byte[grid.data()[index >> 2]], sizeof(GLYPHS.byte[0]));
+        }
+        for (; c < cols; ++c, ++index) {
+            out[c] = GLYPHS.cell[static_cast<int>(grid.at(index))];
+        }
+        drawGlyphs(screenRow + r, screenCol, out, cols);
+    }
+}
+
+void Renderer::print(int row, int col, ColorPair color, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    drawText(row, col, color, buffer);
+}
+
+// DiffRenderer implementation
+DiffRenderer::DiffRenderer(std::unique_ptr<Renderer> targetRenderer)
+    : target(std::move(targetRenderer)), repaintAll(false), cellsSent(0), runsSent(0) {}
+
+void DiffRenderer::clear() {
+    for (std::size_t r = 0; r < back.size(); ++r) {
+        std::fill(back[r].begin(), back[r].end(), blank());
+        dirtyRows[r] = true;
+    }
+}
+
+CellGlyph* DiffRenderer::cellAt(int row, int col) {
+    if (row < 0 || col < 0) {
+        return nullptr;
+    }
+    if (static_cast<std::size_t>(row) >= back.size()) {
+        back.resize(static_cast<std::size_t>(row) + 1);
+        dirtyRows.resize(back.size(), false);
+    }
+    std::vector<CellGlyph>& line = back[row];
+    if (static_cast<std::size_t>(col) >= line.size()) {
+        line.resize(static_cast<std::size_t>(col) + 1, blank());
+    }
+    dirtyRows[row] = true;
+    return &line[col];
+}
+
+void DiffRenderer::drawChar(int row, int col, ColorPair color, char ch) {
+    if (CellGlyph* cell = cellAt(row, col)) {
+        *cell = CellGlyph{ch, color};
+    }
+}
+
+// Cells left of column 0 are dropped, as drawChar drops them one at a time
+void DiffRenderer::drawText(int row, int col, ColorPair color, const std::string& text) {
+    const int skip = col < 0 ? -col : 0;
+    const int count = static_cast<int>(text.size());
+    if (skip >= count || !cellAt(row, col + count - 1)) {
+        return;
+    }
+    CellGlyph* cells = &back[row][col + skip];
+    for (int i = skip; i < count; ++i) {
+        cells[i - skip] = CellGlyph{text[i], color};
+    }
+}
+
+void DiffRenderer::drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) {
+    const int skip = col < 0 ? -col : 0;
+    if (skip >= count || !cellAt(row, col + count - 1)) {
+        return;
+    }
+    std::copy(glyphs + skip, glyphs + count, &back[row][col + skip]);
+}
+
+void DiffRenderer::diffRow(int row) {
+    const std::vector<CellGlyph>& next = back[row];
+    if (static_cast<std::size_t>(row) >= front.size()) {
+        front.resize(static_cast<std::size_t>(row) + 1);
+    }
+    std::vector<CellGlyph>& prev = front[row];
+    prev.resize(next.size(), blank()); // Back rows never shrink
+
+    // Forward each span of changed cells in one call
+    std::size_t c = 0;
+    while (c < next.size()) {
+        if (next[c] == prev[c]) {
+            ++c;
+            continue;
+        }
+        std::size_t start = c;
+        while (c < next.size() && next[c] != prev[c]) {
+            prev[c] = next[c];
+            ++c;
+        }
+        target->drawGlyphs(row, static_cast<int>(start), &next[start], static_cast<int>(c - start));
+        cellsSent += c - start;
+        ++runsSent;
+    }
+}
+
+void DiffRenderer::refresh() {
+    if (repaintAll) {
+        target->clear();
+        front.clear();
+        repaintAll = false;
+    }
+    for (std::size_t r = 0; r < back.size(); ++r) {
+        if (dirtyRows[r]) {
+            diffRow(static_cast<int>(r));
+            dirtyRows[r] = false;
+        }
+    }
+    target->refresh();
+}
+
+void DiffRenderer::repaint(Renderer& other) const {
+    for (std::size_t r = 0; r < front.size(); ++r) {
+        const std::vector<CellGlyph>& line = front[r];
+        std::size_t c = 0;
+        while (c < line.size()) {
+            if (line[c] == blank()) {
+                ++c;
+                continue;
+            }
+            std::size_t start = c;
+            while (c < line.size() && line[c] != blank()) {
+                ++c;
+            }
+            other.drawGlyphs(static_cast<int>(r), static_cast<int>(start), &line[start], static_cast<int>(c - start));
+        }
+    }
+}
+
+void DiffRenderer::invalidate() {
+    repaintAll = true;
+    std::fill(dirtyRows.begin(), dirtyRows.end(), true);
+}
+
+// ScriptedInput implementation
+int ScriptedInput::getKey() {
+    if (next >= keys.size()) {
+        return END_OF_INPUT;
+    }
+    return static_cast<unsigned char>(keys[next++]);
+}
+
+std::string ScriptedInput::getLine(int maxLength) {
+    return playerName.substr(0, static_cast<std::size_t>(maxLength));
+}
+
+} // namespace MulaWee
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// Color pairs for ncurses (one byte, so a CellGlyph is two)
+enum class ColorPair : std::uint8_t {
+    RED = 1,
+    GREEN = 2,
+    BLUE = 3,
+    YELLOW = 4,
+    GOAL = 5,
+    DEFAULT = 6
+};
+
+// How a level cell is drawn: character plus color pair
+struct CellGlyph {
+    char ch;
+    ColorPair color;
+
+    bool operator==(const CellGlyph& other) const { return ch == other.ch && color == other.color; }
+    bool operator!=(const CellGlyph& other) const { return !(*this == other); }
+};
+
+CellGlyph cellGlyph(CellType type);
+
+// Output surface the game draws on. Coordinates are screen rows/columns.
+class Renderer {
+public:
+    virtual ~Renderer() = default;
+
+    virtual void clear() = 0;
+    virtual void drawChar(int row, int col, ColorPair color, char ch) = 0;
+    virtual void drawText(int row, int col, ColorPair color, const std::string& text) = 0;
+    virtual void beep() = 0;
+    virtual void refresh() = 0;
+
+    // Draw `count` glyphs left to right. The default splits them into same-color
+    // runs for drawText; backends with a bulk call override it.
+    virtual void drawGlyphs(int row, int col, const CellGlyph* glyphs, int count);
+
+    // Draw the level cells [top, top + rows) x [left, left + cols) with their top-left
+    // corner at (screenRow, screenCol): one drawGlyphs call per visible row, translated
+    // from the packed grid as it is drawn
+    virtual void drawLevelWindow(const Level& level, int screenRow, int screenCol,
+                                 int top, int left, int rows, int cols);
+
+    // Draw every cell of a level with its top-left corner at (startRow, startCol)
+    void drawLevel(const Level& level, int startRow, int startCol) {
+        drawLevelWindow(level, startRow, startCol, 0, 0, level.getRows(), level.getCols());
+    }
+
+    // Visible screen size; false when the surface has no fixed size
+    virtual bool getScreenSize(int&, int&) const { return false; }
+
+    // Restore the terminal (if any) so errors can be printed
+    virtual void shutdown() {}
+
+    // The screen changed behind the renderer's back (e.g. echoed input); the next
+    // refresh must repaint everything
+    virtual void invalidate() {}
+
+    // printf-style convenience over drawText
+    void print(int row, int col, ColorPair color, const char* format, ...)
+        __attribute__((format(printf, 5, 6)));
+
+private:
+    std::vector<CellGlyph> windowRow; // One visible level row, reused by drawLevelWindow
+};
+
+// Renderer decorator that keeps the last frame sent to the target as a cell/color
+// buffer. Drawing only touches the new frame; refresh() diffs it against the old one
+// and forwards just the changed spans through drawGlyphs. clear() is a buffer reset,
+// so a full redraw of an unchanged screen costs nothing on the wire.
+class DiffRenderer : public Renderer {
+private:
+    std::unique_ptr<Renderer> target;
+    std::vector<std::vector<CellGlyph>> front; // What the target shows
+    std::vector<std::vector<CellGlyph>> back;  // Frame being drawn
+    std::vector<bool> dirtyRows;               // Rows of back written since the last refresh
+    bool repaintAll;
+
+    std::size_t cellsSent;
+    std::size_t runsSent;
+
+public:
+    explicit DiffRenderer(std::unique_ptr<Renderer> targetRenderer);
+
+    void clear() override;
+    void drawChar(int row, int col, ColorPair color, char ch) override;
+    void drawText(int row, int col, ColorPair color, const std::string& text) override;
+    void drawGlyphs(int row, int col, const CellGlyph* glyphs, int count) override;
+    void beep() override { target->beep(); }
+    void refresh() override;
+    void shutdown() override { target->shutdown(); }
+    void invalidate() override;
+    bool getScreenSize(int& rows, int& cols) const override { return target->getScreenSize(rows, cols); }
+
+    // Draw what the target shows (as of the last refresh) onto another renderer, for
+    // a second screen that starts from blank; blank cells are skipped
+    void repaint(Renderer& other) const;
+
+    // Totals forwarded to the target since construction
+    std::size_t getCellsSent() const { return cellsSent; }
+    std::size_t getRunsSent() const { return runsSent; }
+
+private:
+    static CellGlyph blank() { return CellGlyph{' ', ColorPair::DEFAULT}; }
+    CellGlyph* cellAt(int row, int col);
+    void diffRow(int row);
+};
+
+// Source of key presses
+class InputSource {
+public:
+    // Returned by getKey when no more input will ever arrive (ncurses ERR is also -1)
+    static constexpr int END_OF_INPUT = -1;
+
+    // Returned by getKey after the terminal changed size
+    static constexpr int RESIZE = -2;
+
+    // Returned by pollKey when no key is waiting
+    static constexpr int NO_KEY = -3;
+
+    virtual ~InputSource() = default;
+
+    virtual int getKey() = 0;
+
+    // A key that is already waiting, or NO_KEY; never blocks
+    virtual int pollKey() { return NO_KEY; }
+
+    // Read a line of at most maxLength characters at the current cursor
+    virtual std::string getLine(int maxLength) = 0;
+
+    // "Press any key to continue" screens
+    virtual void waitForKeyPress() { getKey(); }
+};
+
+// Renderer that draws nothing - for tests, bots and batch jobs
+class NullRenderer : public Renderer {
+public:
+    void clear() override {}
+    void drawChar(int, int, ColorPair, char) override {}
+    void drawText(int, int, ColorPair, const std::string&) override {}
+    void drawGlyphs(int, int, const CellGlyph*, int) override {}
+    void drawLevelWindow(const Level&, int, int, int, int, int, int) override {}
+    void beep() override {}
+    void refresh() override {}
+};
+
+// Input that replays a fixed key sequence, then reports END_OF_INPUT.
+// Continue prompts do not consume keys, so the script is just the moves. The whole
+// remaining script counts as typed ahead, like a pasted move string.
+class ScriptedInput : public InputSource {
+private:
+    std::string keys;
+    std::string playerName;
+    std::size_t next;
+
+public:
+    explicit ScriptedInput(std::string keySequence, std::string name = "Player")
+        : keys(std::move(keySequence)), playerName(std::move(name)), next(0) {}
+
+    int getKey() override;
+    int pollKey() override { return next < keys.size() ? getKey() : NO_KEY; }
+    std::string getLine(int maxLength) override;
+    void waitForKeyPress() override {}
+
+    std::size_t getKeysConsumed() const { return next; }
+};
+
+} // namespace MulaWee
@@ -0,0 +1,252 @@
+#include "replay.hpp"
+#include "temp_file.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace MulaWee {
+
+namespace {
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Bounds-checked reader over a serialized replay
+class ReplayReader {
+private:
+    const std::uint8_t* data;
+    std::size_t size;
+    std::size_t offset;
+
+public:
+    ReplayReader(const std::uint8_t* bytes, std::size_t length) : data(bytes), size(length), offset(0) {}
+
+    const std::uint8_t* take(std::size_t count) {
+        if (count > size - offset) {
+            throw GameException("Truncated replay");
+        }
+        const std::uint8_t* at = data + offset;
+        offset += count;
+        return at;
+    }
+
+    std::uint8_t byte() { return *take(1); }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw GameException("Corrupt replay varint");
+    }
+
+    bool atEnd() const { return offset == size; }
+};
+
+} // namespace
+
+// Replay class implementation
+void Replay::begin(const std::string& name, int gameLevelCount) {
+    playerName = name.substr(0, 255);
+    levelCount = gameLevelCount;
+    score = 0;
+    levels.clear();
+}
+
+void Replay::startLevel(std::uint32_t checksum) {
+    levels.emplace_back();
+    levels.back().checksum = checksum;
+}
+
+void Replay::addMove(Direction dir) {
+    if (levels.empty()) {
+        return;
+    }
+    ReplayLevel& level = levels.back();
+    std::uint32_t index = level.moveCount++;
+    if ((index & 3) == 0) {
+        level.moves.push_back(0);
+    }
+    level.moves.back() = static_cast<std::uint8_t>(level.moves.back() |
+                                                   (static_cast<int>(dir) << ((index & 3) << 1)));
+}
+
+void Replay::addInvalidKey(int key) {
+    if (levels.empty()) {
+        return;
+    }
+    ReplayLevel& level = levels.back();
+    level.invalidKeys.push_back(InvalidKey{level.moveCount, key});
+}
+
+std::vector<std::uint8_t> Replay::serialize() const {
+    std::vector<std::uint8_t> out(ReplayFormat::MAGIC, ReplayFormat::MAGIC + sizeof(ReplayFormat::MAGIC));
+    out.push_back(ReplayFormat::VERSION);
+    out.push_back(static_cast<std::uint8_t>(playerName.size()));
+    out.insert(out.end(), playerName.begin(), playerName.end());
+    putVarint(out, static_cast<std::uint32_t>(levelCount));
+    putVarint(out, static_cast<std::uint32_t>(score));
+    putVarint(out, levels.size());
+
+    for (const ReplayLevel& level : levels) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<std::uint8_t>(level.checksum >> (8 * i)));
+        }
+        putVarint(out, level.moveCount);
+        putVarint(out, level.invalidKeys.size());
+        std::uint32_t previous = 0;
+        for (const InvalidKey& invalid : level.invalidKeys) {
+            putVarint(out, invalid.moveIndex - previous);
+            putVarint(out, static_cast<std::uint32_t>(invalid.key));
+            previous = invalid.moveIndex;
+        }
+        out.insert(out.end(), level.moves.begin(), level.moves.end());
+    }
+    return out;
+}
+
+Replay Replay::parse(const std::uint8_t* data, std::size_t size) {
+    ReplayReader reader(data, size);
+    if (std::memcmp(reader.take(sizeof(ReplayFormat::MAGIC)), ReplayFormat::MAGIC,
+                    sizeof(ReplayFormat::MAGIC)) != 0) {
+        throw GameException("Not a replay (bad magic)");
+    }
+    if (reader.byte() != ReplayFormat::VERSION) {
+        throw GameException("Unsupported replay version");
+    }
+
+    Replay replay;
+    std::size_t nameLength = reader.byte();
+    const std::uint8_t* name = reader.take(nameLength);
+    replay.playerName.assign(reinterpret_cast<const char*>(name), nameLength);
+    replay.levelCount = static_cast<int>(reader.varint());
+    replay.score = static_cast<int>(reader.varint());
+
+    std::uint64_t played = reader.varint();
+    if (played > size) {
+        throw GameException("Corrupt replay level count");
+    }
+    replay.levels.resize(static_cast<std::size_t>(played));
+    for (ReplayLevel& level : replay.levels) {
+        const std::uint8_t* checksum = reader.take(4);
+        level.checksum = static_cast<std::uint32_t>(checksum[0]) | static_cast<std::uint32_t>(checksum[1]) << 8 |
+                         static_cast<std::uint32_t>(checksum[2]) << 16 |
+                         static_cast<std::uint32_t>(checksum[3]) << 24;
+        level.moveCount = static_cast<std::uint32_t>(reader.varint());
+        std::uint64_t invalidCount = reader.varint();
+        if (invalidCount > size) {
+            throw GameException("Corrupt replay invalid-key count");
+        }
+        level.invalidKeys.resize(static_cast<std::size_t>(invalidCount));
+        std::uint32_t previous = 0;
+        for (InvalidKey& invalid : level.invalidKeys) {
+            invalid.moveIndex = previous + static_cast<std::uint32_t>(reader.varint());
+            invalid.key = static_cast<int>(reader.varint());
+            previous = invalid.moveIndex;
+        }
+        std::size_t packed = (static_cast<std::size_t>(level.moveCount) + 3) / 4;
+        const std::uint8_t* moves = reader.take(packed);
+        level.moves.assign(moves, moves + packed);
+    }
+
+    if (!reader.atEnd()) {
+        throw GameException("Trailing bytes after replay");
+    }
+    return replay;
+}
+
+void Replay::save(const std::string& path) const {
+    std::vector<std::uint8_t> bytes = serialize();
+    TempFile temp(path); // Games sharing a replay directory never share a temporary file
+    {
+        std::ofstream file(temp.getPath(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw FileException(temp.getPath());
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file.flush()) {
+            throw GameException("Failed to write replay " + temp.getPath());
+        }
+    }
+    temp.commit();
+}
+
+Replay Replay::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw FileException(path);
+    }
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return parse(bytes.data(), bytes.size());
+}
+
+// Replayer class implementation
+Replayer::Replayer(const std::vector<std::shared_ptr<const Level>>& levels) {
+    for (const auto& level : levels) {
+        library.emplace(level->getChecksum(), level);
+    }
+}
+
+ReplayResult Replayer::run(const Replay& replay) const {
+    ReplayResult result;
+
+    std::vector<std::shared_ptr<const Level>> played;
+    played.reserve(replay.getLevels().size());
+    for (const ReplayLevel& record : replay.getLevels()) {
+        auto found = library.find(record.checksum);
+        if (found == library.end()) {
+            char message[64];
+            std::snprintf(message, sizeof(message), "Unknown level checksum %08x", record.checksum);
+            result.error = message;
+            return result;
+        }
+        played.push_back(found->second);
+    }
+    if (played.empty()) {
+        result.valid = true;
+        return result;
+    }
+
+    GameSession session(played, ""); // Never touches a high score file
+    session.begin(replay.getPlayerName());
+
+    for (const ReplayLevel& record : replay.getLevels()) {
+        for (std::uint32_t i = 0; i < record.moveCount; ++i) {
+            if (session.getState() != GameState::PLAYING) {
+                result.error = "Moves recorded after the goal";
+                return result;
+            }
+            session.move(record.getMove(i));
+        }
+        result.moveCounts.push_back(session.getPlayer().getMoveCount());
+        result.invalidKeys += static_cast<int>(record.invalidKeys.size());
+
+        if (session.getState() != GameState::LEVEL_COMPLETE) {
+            break; // The run ended on this level
+        }
+        ++result.levelsCompleted;
+        session.completeLevel();
+    }
+
+    if (result.moveCounts.size() != replay.getLevels().size()) {
+        result.error = "Levels recorded after the run ended";
+        return result;
+    }
+
+    result.finished = result.levelsCompleted == replay.getLevelCount();
+    result.score = session.getScoreManager().getCurrentScore();
+    result.valid = true;
+    return result;
+}
+
+} // namespace MulaWee
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "game_core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MulaWee {
+
+// Compact replay format (.mwr)
+//
+//   "MWRP", version byte, player name (length byte + bytes), then varints for the
+//   number of levels in the game and the claimed final score, then per level played:
+//   level checksum (4 bytes), direction count, invalid-key count, invalid keys as
+//   (gap since the previous one in directions, key) varint pairs, and the directions
+//   packed 2 bits each (Direction order, 4 per byte).
+//
+// A 154-move level costs about 45 bytes, so millions of runs fit in memory.
+namespace ReplayFormat {
+
+constexpr char MAGIC[4] = {'M', 'W', 'R', 'P'};
+constexpr std::uint8_t VERSION = 1;
+constexpr const char* EXTENSION = ".mwr";
+
+} // namespace ReplayFormat
+
+// A key that did not map to a direction, and how many directions preceded it
+struct InvalidKey {
+    std::uint32_t moveIndex;
+    int key;
+};
+
+// Everything typed while one level was on screen
+struct ReplayLevel {
+    std::uint32_t checksum = 0;  // Level::getChecksum of the level played
+    std::uint32_t moveCount = 0; // Directions entered, blocked ones included
+    std::vector<std::uint8_t> moves;
+    std::vector<InvalidKey> invalidKeys;
+
+    Direction getMove(std::uint32_t index) const {
+        return static_cast<Direction>((moves[index >> 2] >> ((index & 3) << 1)) & 3);
+    }
+};
+
+// One run, recorded as it is played
+class Replay {
+private:
+    std::string playerName;
+    int levelCount;
+    int score;
+    std::vector<ReplayLevel> levels;
+
+public:
+    Replay() : levelCount(0), score(0) {}
+
+    // Recording
+    void begin(const std::string& name, int gameLevelCount);
+    void startLevel(std::uint32_t checksum);
+    void addMove(Direction dir);
+    void addInvalidKey(int key);
+    void setScore(int finalScore) { score = finalScore; }
+
+    // Getters
+    const std::string& getPlayerName() const { return playerName; }
+    int getLevelCount() const { return levelCount; }
+    int getScore() const { return score; }
+    const std::vector<ReplayLevel>& getLevels() const { return levels; }
+    bool isEmpty() const { return levels.empty(); }
+
+    // Binary form
+    std::vector<std::uint8_t> serialize() const;
+    static Replay parse(const std::uint8_t* data, std::size_t size);
+
+    // Files are written through a temporary file and rename
+    void save(const std::string& path) const;
+    static Replay load(const std::string& path);
+};
+
+// What replaying a run through GameSession produced
+struct ReplayResult {
+    bool valid = false;          // Every level was found and no move followed a goal
+    std::string error;
+    int levelsCompleted = 0;
+    bool finished = false;       // Completed every level of the game
+    std::vector<int> moveCounts; // Player::getMoveCount per level played
+    int invalidKeys = 0;
+    int score = 0;               // ScoreManager::getCurrentScore at the end
+
+    bool matchesClaim(const Replay& replay) const { return valid && score == replay.getScore(); }
+};
+
+// Replays runs at full speed against a set of levels found by checksum
+class Replayer {
+private:
+    std::unordered_map<std::uint32_t, std::shared_ptr<const Level>> library;
+
+public:
+    explicit Replayer(const std::vector<std::shared_ptr<const Level>>& levels);
+
+    ReplayResult run(const Replay& replay) const;
+};
+
+} // namespace MulaWee
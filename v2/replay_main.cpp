@@ -0,0 +1,122 @@
+#include "replay.hpp"
+#include "level_format.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// Replay checker - re-runs recorded games through GameSession and compares totals
+//
+//   mulavee_replay [--data DIR] [--level FILE]... [--bench N] REPLAY.mwr...
+//
+// Levels are matched by checksum against DIR/level1..3 plus any --level files. Prints
+// one line per replay and exits with 1 if any replay is invalid or its score differs
+// from the one it recorded. --bench replays the whole set N times and reports the rate.
+
+namespace {
+
+using namespace MulaWee;
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--data DIR] [--level FILE]... [--bench N] REPLAY.mwr..."
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    std::vector<std::string> levelFiles;
+    std::vector<std::string> replayFiles;
+    int benchRounds = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--level") == 0 && hasValue) {
+            levelFiles.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bench") == 0 && hasValue) {
+            benchRounds = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            replayFiles.push_back(argv[i]);
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (replayFiles.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try {
+        for (int i = 1; i <= 3; ++i) {
+            std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+            std::string compiled = LevelFormat::compiledPathFor(path);
+            levelFiles.push_back(LevelFormat::isCompiled(compiled) ? compiled : path);
+        }
+        std::vector<std::shared_ptr<const Level>> levels;
+        for (const std::string& file : levelFiles) {
+            levels.push_back(std::make_shared<const Level>(file));
+        }
+        Replayer replayer(levels);
+
+        bool allGood = true;
+        std::vector<Replay> replays;
+        std::vector<std::string> loaded;
+        for (const std::string& file : replayFiles) {
+            try {
+                replays.push_back(Replay::load(file));
+                loaded.push_back(file);
+            } catch (const GameException& e) {
+                std::cout << file << ": UNREADABLE (" << e.what() << ")" << std::endl;
+                allGood = false;
+            }
+        }
+
+        for (std::size_t i = 0; i < replays.size(); ++i) {
+            const Replay& replay = replays[i];
+            ReplayResult result = replayer.run(replay);
+            std::cout << loaded[i] << ": " << replay.getPlayerName();
+            if (!result.valid) {
+                std::cout << " INVALID (" << result.error << ")" << std::endl;
+                allGood = false;
+                continue;
+            }
+
+            std::cout << " levels " << result.levelsCompleted << "/" << replay.getLevelCount() << " moves";
+            for (int moves : result.moveCounts) {
+                std::cout << ' ' << moves;
+            }
+            std::cout << " invalid-keys " << result.invalidKeys << " score " << result.score;
+            if (result.matchesClaim(replay)) {
+                std::cout << " OK" << std::endl;
+            } else {
+                std::cout << " MISMATCH (recorded " << replay.getScore() << ")" << std::endl;
+                allGood = false;
+            }
+        }
+
+        if (benchRounds > 0) {
+            long long checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int round = 0; round < benchRounds; ++round) {
+                for (const Replay& replay : replays) {
+                    checksum += replayer.run(replay).score;
+                }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double count = static_cast<double>(benchRounds) * replays.size();
+            std::cerr << static_cast<long long>(count) << " replays in " << std::fixed << std::setprecision(3)
+                      << elapsed.count() << " s (" << std::setprecision(0) << count / elapsed.count()
+                      << " replays/s, score sum " << checksum << ")" << std::endl;
+        }
+
+        return allGood ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
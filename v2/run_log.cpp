@@ -0,0 +1,493 @@
+#include "run_log.hpp"
+#include "level_format.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MulaWee {
+
+namespace {
+
+void putU16(std::vector<std::uint8_t>& out, std::uint16_t value) {
+    out.push_back(static_cast<std::uint8_t>(value));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+void putU32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void putU64(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+std::uint64_t getU64(const std::uint8_t* in) {
+    return static_cast<std::uint64_t>(getU32(in)) | static_cast<std::uint64_t>(getU32(in + 4)) << 32;
+}
+
+GameException systemError(const std::string& what) {
+    return GameException(what + ": " + std::strerror(errno));
+}
+
+// flock held for the lifetime of the object
+class FileLock {
+private:
+    int fd;
+
+public:
+    FileLock(int lockFd, int operation) : fd(lockFd) {
+        while (::flock(fd, operation) != 0) {
+            if (errno != EINTR) {
+                throw systemError("flock");
+            }
+        }
+    }
+    ~FileLock() { ::flock(fd, LOCK_UN); }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+};
+
+// Closes a descriptor on scope exit
+class FileDescriptor {
+private:
+    int fd;
+
+public:
+    explicit FileDescriptor(int openFd) : fd(openFd) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const { return fd; }
+};
+
+std::uint64_t fileSize(int fd) {
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw systemError("fstat");
+    }
+    return static_cast<std::uint64_t>(info.st_size);
+}
+
+bool writeAll(int fd, const std::uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t wrote = ::write(fd, data, size);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += wrote;
+        size -= static_cast<std::size_t>(wrote);
+    }
+    return true;
+}
+
+std::vector<std::uint8_t> readRange(int fd, std::uint64_t offset, std::uint64_t end) {
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(end - offset));
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t got = ::pread(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            throw systemError("Reading run log");
+        }
+        done += static_cast<std::size_t>(got);
+    }
+    return bytes;
+}
+
+void syncDirectoryOf(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void encodeHeader(std::vector<std::uint8_t>& out) {
+    out.insert(out.end(), RunLogFormat::MAGIC, RunLogFormat::MAGIC + 4);
+    out.push_back(RunLogFormat::VERSION);
+    out.resize(out.size() + 3, 0);
+}
+
+bool validHeader(const std::uint8_t* data, std::size_t size) {
+    return size >= RunLogFormat::HEADER_BYTES && std::memcmp(data, RunLogFormat::MAGIC, 4) == 0 &&
+           data[4] == RunLogFormat::VERSION;
+}
+
+void encodeRecord(std::vector<std::uint8_t>& out, const RunRecord& record) {
+    std::size_t start = out.size();
+    out.resize(start + RunLogFormat::RECORD_HEADER_BYTES);
+
+    std::size_t nameLength = std::min<std::size_t>(record.playerName.size(), 255);
+    std::size_t levelCount = std::min<std::size_t>(record.levels.size(), 0xffff);
+    putU64(out, record.timestamp);
+    putU32(out, static_cast<std::uint32_t>(record.total));
+    putU16(out, static_cast<std::uint16_t>(levelCount));
+    out.push_back(static_cast<std::uint8_t>(nameLength));
+    out.insert(out.end(), record.playerName.begin(), record.playerName.begin() + nameLength);
+    for (std::size_t i = 0; i < levelCount; ++i) {
+        putU32(out, static_cast<std::uint32_t>(record.levels[i].moves));
+        putU32(out, static_cast<std::uint32_t>(record.levels[i].score));
+    }
+
+    std::size_t payloadSize = out.size() - start - RunLogFormat::RECORD_HEADER_BYTES;
+    std::uint32_t checksum = LevelFormat::checksum(out.data() + start + RunLogFormat::RECORD_HEADER_BYTES,
+                                                   payloadSize);
+    std::uint8_t* header = out.data() + start;
+    for (int i = 0; i < 4; ++i) {
+        header[i] = static_cast<std::uint8_t>(payloadSize >> (8 * i));
+        header[4 + i] = static_cast<std::uint8_t>(checksum >> (8 * i));
+    }
+}
+
+bool decodeRecord(const std::uint8_t* payload, std::size_t size, RunRecord& record) {
+    const std::size_t fixed = 8 + 4 + 2 + 1;
+    if (size < fixed) {
+        return false;
+    }
+    std::size_t levelCount = payload[12] | static_cast<std::size_t>(payload[13]) << 8;
+    std::size_t nameLength = payload[14];
+    if (size != fixed + nameLength + levelCount * 8) {
+        return false;
+    }
+
+    record.timestamp = getU64(payload);
+    record.total = static_cast<int>(getU32(payload + 8));
+    record.playerName.assign(reinterpret_cast<const char*>(payload + fixed), nameLength);
+    record.levels.resize(levelCount);
+    const std::uint8_t* level = payload + fixed + nameLength;
+    for (RunLevelResult& result : record.levels) {
+        result.moves = static_cast<int>(getU32(level));
+        result.score = static_cast<int>(getU32(level + 4));
+        level += 8;
+    }
+    return true;
+}
+
+// Walk intact records from `offset`, calling visit(record, recordOffset, recordBytes);
+// returns the offset just past the last intact record
+template <typename Visit>
+std::size_t scanRecords(const std::uint8_t* data, std::size_t size, std::size_t offset, Visit visit) {
+    RunRecord record;
+    while (size - offset >= RunLogFormat::RECORD_HEADER_BYTES) {
+        std::uint32_t length = getU32(data + offset);
+        std::size_t available = size - offset - RunLogFormat::RECORD_HEADER_BYTES;
+        if (length > RunLogFormat::MAX_PAYLOAD_BYTES || length > available) {
+            break;
+        }
+        const std::uint8_t* payload = data + offset + RunLogFormat::RECORD_HEADER_BYTES;
+        if (LevelFormat::checksum(payload, length) != getU32(data + offset + 4) ||
+            !decodeRecord(payload, length, record)) {
+            break;
+        }
+        std::size_t recordBytes = RunLogFormat::RECORD_HEADER_BYTES + length;
+        visit(record, offset, recordBytes);
+        offset += recordBytes;
+    }
+    return offset;
+}
+
+} // namespace
+
+// RunLog class implementation
+RunLog::RunLog(const std::string& logPath, const Visitor& visit, bool sync)
+    : path(logPath), fd(-1), syncWrites(sync), recoveredBytes(0) {
+    openLog();
+    try {
+        recover(visit);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+RunLog::~RunLog() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void RunLog::openLog() {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw FileException(path);
+    }
+
+    FileLock lock(fd, LOCK_EX);
+    if (fileSize(fd) == 0) {
+        std::vector<std::uint8_t> header;
+        encodeHeader(header);
+        if (!writeAll(fd, header.data(), header.size()) || ::fdatasync(fd) != 0) {
+            throw systemError("Cannot create " + path);
+        }
+        syncDirectoryOf(path);
+    }
+}
+
+void RunLog::recover(const Visitor& visit) {
+    FileLock lock(fd, LOCK_EX);
+    MappedFile file(path); // The file fd has open: replacing it needs this lock
+    std::uint64_t size = file.size();
+    if (!validHeader(file.data(), file.size())) {
+        throw GameException("Not a run log: " + path);
+    }
+
+    std::size_t end = scanRecords(file.data(), file.size(), RunLogFormat::HEADER_BYTES,
+                                  [&](const RunRecord& record, std::size_t, std::size_t) {
+                                      if (visit) {
+                                          visit(record);
+                                      }
+                                  });
+    if (end < size) {
+        // Torn tail from a crash mid-append
+        if (::ftruncate(fd, static_cast<off_t>(end)) != 0 || ::fdatasync(fd) != 0) {
+            throw systemError("Cannot recover " + path);
+        }
+        recoveredBytes = size - end;
+    }
+}
+
+bool RunLog::isCurrent() const {
+    struct stat onDisk, open;
+    return ::stat(path.c_str(), &onDisk) == 0 && ::fstat(fd, &open) == 0 &&
+           onDisk.st_dev == open.st_dev && onDisk.st_ino == open.st_ino;
+}
+
+void RunLog::append(const RunRecord& record) {
+    std::lock_guard<std::mutex> guard(appendMutex);
+    buffer.clear();
+    encodeRecord(buffer, record);
+    writeLocked(buffer.data(), buffer.size());
+}
+
+void RunLog::append(const std::vector<RunRecord>& records) {
+    if (records.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(appendMutex);
+    buffer.clear();
+    for (const RunRecord& record : records) {
+        encodeRecord(buffer, record);
+    }
+    writeLocked(buffer.data(), buffer.size());
+}
+
+void RunLog::writeLocked(const std::uint8_t* data, std::size_t size) {
+    while (true) {
+        {
+            FileLock lock(fd, LOCK_EX);
+            if (isCurrent()) {
+                std::uint64_t end = fileSize(fd);
+                if (!writeAll(fd, data, size) || (syncWrites && ::fdatasync(fd) != 0)) {
+                    GameException error = systemError("Cannot append to " + path);
+                    // Leave no partial record for the next append to land behind
+                    int ignored = ::ftruncate(fd, static_cast<off_t>(end));
+                    (void)ignored;
+                    throw error;
+                }
+                return;
+            }
+        }
+        // Compacted (or removed) since we opened it
+        ::close(fd);
+        fd = -1;
+        openLog();
+    }
+}
+
+std::uint64_t RunLog::forEach(const std::string& logPath, const Visitor& visit) {
+    return forEachFrom(logPath, RunLogFormat::HEADER_BYTES,
+                       [&](const RunRecord& record, std::uint64_t) { visit(record); });
+}
+
+std::uint64_t RunLog::forEachFrom(const std::string& logPath, std::uint64_t from,
+                                  const PositionedVisitor& visit) {
+    struct stat info;
+    if (::stat(logPath.c_str(), &info) != 0 || info.st_size == 0) {
+        return 0;
+    }
+    MappedFile file(logPath);
+    if (!validHeader(file.data(), file.size())) {
+        throw GameException("Not a run log: " + logPath);
+    }
+    if (from > file.size()) {
+        return from;
+    }
+    return scanRecords(file.data(), file.size(),
+                       static_cast<std::size_t>(std::max<std::uint64_t>(from, RunLogFormat::HEADER_BYTES)),
+                       [&](const RunRecord& record, std::size_t offset, std::size_t) { visit(record, offset); });
+}
+
+bool RunLog::readAt(const std::uint8_t* log, std::size_t size, std::uint64_t offset, RunRecord& record) {
+    if (offset < RunLogFormat::HEADER_BYTES || offset > size ||
+        size - offset < RunLogFormat::RECORD_HEADER_BYTES) {
+        return false;
+    }
+    std::uint32_t length = getU32(log + offset);
+    if (length > size - offset - RunLogFormat::RECORD_HEADER_BYTES) {
+        return false;
+    }
+    const std::uint8_t* payload = log + offset + RunLogFormat::RECORD_HEADER_BYTES;
+    return LevelFormat::checksum(payload, length) == getU32(log + offset + 4) &&
+           decodeRecord(payload, length, record);
+}
+
+CompactionResult RunLog::compact(const std::string& logPath, std::size_t keepPerPlayer) {
+    CompactionResult result;
+
+    // One compaction of a log at a time: a second one (the game's startup compaction
+    // and mulavee_runlog, say) waits here and then compacts the already compacted log
+    const std::string lockPath = logPath + ".compact";
+    FileDescriptor compactLock(::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (compactLock.get() < 0) {
+        throw systemError("Cannot open " + lockPath);
+    }
+    FileLock compacting(compactLock.get(), LOCK_EX);
+
+    FileDescriptor source(::open(logPath.c_str(), O_RDONLY | O_CLOEXEC));
+    if (source.get() < 0) {
+        throw FileException(logPath);
+    }
+
+    // Everything below the size seen under the lock is complete and never changes;
+    // appends only add past it
+    std::uint64_t snapshotSize;
+    {
+        FileLock lock(source.get(), LOCK_SH);
+        snapshotSize = fileSize(source.get());
+    }
+    std::vector<std::uint8_t> snapshot = readRange(source.get(), 0, snapshotSize);
+    if (!validHeader(snapshot.data(), snapshot.size())) {
+        throw GameException("Not a run log: " + logPath);
+    }
+
+    struct Entry {
+        std::size_t offset;
+        std::size_t bytes;
+        int total;
+        std::vector<int> levelScores;
+    };
+    std::vector<Entry> entries;
+    std::map<std::string, std::vector<std::size_t>> byPlayer;
+    scanRecords(snapshot.data(), snapshot.size(), RunLogFormat::HEADER_BYTES,
+                [&](const RunRecord& record, std::size_t offset, std::size_t bytes) {
+                    Entry entry{offset, bytes, record.total, {}};
+                    for (const RunLevelResult& level : record.levels) {
+                        entry.levelScores.push_back(level.score);
+                    }
+                    byPlayer[record.playerName].push_back(entries.size());
+                    entries.push_back(std::move(entry));
+                });
+
+    // A run survives if it is among its player's best by total or on any level
+    std::vector<bool> keep(entries.size(), false);
+    for (auto& player : byPlayer) {
+        std::vector<std::size_t>& runs = player.second;
+        std::size_t levelCount = 0;
+        for (std::size_t index : runs) {
+            levelCount = std::max(levelCount, entries[index].levelScores.size());
+        }
+        for (std::size_t level = 0; level <= levelCount; ++level) {
+            auto score = [&](std::size_t index) {
+                const Entry& entry = entries[index];
+                if (level == levelCount) {
+                    return entry.total;
+                }
+                return level < entry.levelScores.size() ? entry.levelScores[level] : -1;
+            };
+            std::stable_sort(runs.begin(), runs.end(),
+                             [&](std::size_t a, std::size_t b) { return score(a) > score(b); });
+            for (std::size_t i = 0; i < runs.size() && i < keepPerPlayer; ++i) {
+                if (score(runs[i]) >= 0) {
+                    keep[runs[i]] = true;
+                }
+            }
+        }
+    }
+
+    std::vector<std::uint8_t> compacted;
+    encodeHeader(compacted);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (keep[i]) {
+            compacted.insert(compacted.end(), snapshot.begin() + entries[i].offset,
+                             snapshot.begin() + entries[i].offset + entries[i].bytes);
+            ++result.recordsAfter;
+        }
+    }
+    result.recordsBefore = entries.size();
+
+    // A name of its own beside the log, so the rename stays on one filesystem
+    std::string tempPath = logPath + ".XXXXXX";
+    FileDescriptor temp(::mkstemp(&tempPath[0]));
+    if (temp.get() < 0) {
+        throw systemError("Cannot create a temporary file for " + logPath);
+    }
+    if (::fchmod(temp.get(), 0644) != 0 || !writeAll(temp.get(), compacted.data(), compacted.size())) {
+        ::unlink(tempPath.c_str());
+        throw systemError("Cannot write " + tempPath);
+    }
+
+    // Appenders wait only for the runs added since the snapshot to be copied over
+    FileLock lock(source.get(), LOCK_EX);
+    struct stat onDisk, open;
+    if (::stat(logPath.c_str(), &onDisk) != 0 || ::fstat(source.get(), &open) != 0 ||
+        onDisk.st_ino != open.st_ino || onDisk.st_dev != open.st_dev) {
+        ::unlink(tempPath.c_str());
+        throw GameException("Run log was replaced while compacting: " + logPath);
+    }
+    std::uint64_t finalSize = fileSize(source.get());
+    std::vector<std::uint8_t> tail = readRange(source.get(), snapshotSize, finalSize);
+    std::vector<std::uint8_t> carried;
+    scanRecords(tail.data(), tail.size(), 0, [&](const RunRecord&, std::size_t offset, std::size_t bytes) {
+        carried.insert(carried.end(), tail.begin() + offset, tail.begin() + offset + bytes);
+        ++result.recordsBefore;
+        ++result.recordsAfter;
+    });
+
+    if (!writeAll(temp.get(), carried.data(), carried.size()) || ::fdatasync(temp.get()) != 0 ||
+        std::rename(tempPath.c_str(), logPath.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        throw systemError("Cannot replace " + logPath);
+    }
+    syncDirectoryOf(logPath);
+
+    result.bytesBefore = finalSize;
+    result.bytesAfter = compacted.size() + carried.size();
+    return result;
+}
+
+std::string legacyScorePathFor(const std::string& runLogPath) {
+    std::size_t slash = runLogPath.rfind('/');
+    return (slash == std::string::npos ? std::string() : runLogPath.substr(0, slash + 1)) + "score.dat";
+}
+
+} // namespace MulaWee
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MulaWee {
+
+// Append-only run log (.mwlog)
+//
+//   header:  magic "MWRL", version byte, 3 reserved bytes
+//   record:  payload length (4), FNV-1a of the payload (4), payload
+//   payload: unix time in ms (8), total score (4), level count (2), name length (1),
+//            name bytes, then moves (4) and score (4) for each level
+//
+// Integers are little-endian. Every record is one write() followed by fdatasync, so a
+// crash can only leave a partial record at the end; opening the log cuts it off.
+namespace RunLogFormat {
+
+constexpr char MAGIC[4] = {'M', 'W', 'R', 'L'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HEADER_BYTES = 8;
+constexpr std::size_t RECORD_HEADER_BYTES = 8;
+constexpr std::uint32_t MAX_PAYLOAD_BYTES = 1u << 20;
+constexpr const char* EXTENSION = ".mwlog";
+
+} // namespace RunLogFormat
+
+struct RunLevelResult {
+    int moves = 0;
+    int score = 0;
+};
+
+// One finished run
+struct RunRecord {
+    std::string playerName;
+    std::uint64_t timestamp = 0; // Unix time in milliseconds (0 = imported, time unknown)
+    int total = 0;
+    std::vector<RunLevelResult> levels;
+};
+
+// What compaction kept
+struct CompactionResult {
+    std::size_t recordsBefore = 0;
+    std::size_t recordsAfter = 0;
+    std::uint64_t bytesBefore = 0;
+    std::uint64_t bytesAfter = 0;
+};
+
+// Writer side of a run log. Appends take an exclusive flock on the log for the one
+// write, so several processes (the game, mulavee_verifyd) can share a log; if a
+// compaction has replaced the file in the meantime the writer reopens it first.
+class RunLog {
+private:
+    std::string path;
+    int fd;
+    bool syncWrites;
+    std::uint64_t recoveredBytes; // Torn tail cut off when the log was opened
+    std::mutex appendMutex;
+    std::vector<std::uint8_t> buffer;
+
+public:
+    using Visitor = std::function<void(const RunRecord&)>;
+    using PositionedVisitor = std::function<void(const RunRecord&, std::uint64_t offset)>;
+
+    // Creates the log if it does not exist and cuts off a torn tail if it does (from
+    // the first short or corrupt record on). `visit`, if set, sees every intact record
+    // of that same pass, so a reader needs no second scan.
+    explicit RunLog(const std::string& logPath, const Visitor& visit = nullptr, bool sync = true);
+    ~RunLog();
+
+    RunLog(const RunLog&) = delete;
+    RunLog& operator=(const RunLog&) = delete;
+
+    // O(1): one locked write and one fdatasync however long the log is. A batch goes
+    // out in a single write.
+    void append(const RunRecord& record);
+    void append(const std::vector<RunRecord>& records);
+
+    const std::string& getPath() const { return path; }
+    std::uint64_t getRecoveredBytes() const { return recoveredBytes; }
+
+    // Call `visit` for every intact record in log order. Returns the number of bytes
+    // that hold intact records (header included); reading stops at the first record
+    // that is short or fails its checksum. A missing log has no records.
+    static std::uint64_t forEach(const std::string& logPath, const Visitor& visit);
+
+    // Same from the record boundary `from` on, with each record's offset in the log
+    static std::uint64_t forEachFrom(const std::string& logPath, std::uint64_t from,
+                                     const PositionedVisitor& visit);
+
+    // Decode the record at `offset` of a log held in memory; false if it is not intact
+    static bool readAt(const std::uint8_t* log, std::size_t size, std::uint64_t offset, RunRecord& record);
+
+    // Rewrite the log keeping, for every player, the `keepPerPlayer` best runs by total
+    // and the `keepPerPlayer` best on each level, in their original order. The new log
+    // is written to a temporary file and renamed over the old one; runs appended while
+    // it was being written are carried over, so appends never wait for the rewrite.
+    // Compactions of the same log take turns on an exclusive flock of `logPath`.compact.
+    static CompactionResult compact(const std::string& logPath, std::size_t keepPerPlayer);
+
+private:
+    void openLog();
+    void recover(const Visitor& visit);
+    bool isCurrent() const;
+    void writeLocked(const std::uint8_t* data, std::size_t size);
+};
+
+// The one-line "name score" file a run log replaces ("data/runs.mwlog" -> "data/score.dat")
+std::string legacyScorePathFor(const std::string& runLogPath);
+
+} // namespace MulaWee
@@ -0,0 +1,190 @@
+#include "run_log.hpp"
+#include "game_core.hpp"
+#include "leaderboard.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sys/stat.h>
+
+// Run log tool - lists, compacts and benchmarks the append-only run log
+//
+//   mulavee_runlog [--log FILE] list
+//   mulavee_runlog [--log FILE] compact [--keep N]
+//   mulavee_runlog [--log FILE] bench N [--no-sync]
+//   mulavee_runlog [--log FILE] top [--level N] [--count K]
+//   mulavee_runlog [--log FILE] player NAME
+//
+// compact keeps each player's N best runs by total and on every level (default 10).
+// top and player bring the leaderboard index up to date first and report how long
+// that and the query took.
+// bench appends N synthetic runs and times the first and second half separately, so
+// a slowdown as the log grows would show.
+
+namespace {
+
+using namespace MulaWee;
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--log FILE] list | compact [--keep N] | bench N [--no-sync]"
+              << " | top [--level N] [--count K] | player NAME" << std::endl;
+}
+
+double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Open (and refresh) the index, reporting what that cost
+std::unique_ptr<Leaderboard> openLeaderboard(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<Leaderboard> board(new Leaderboard(path));
+    double took = microsecondsSince(start);
+    std::cerr << board->getRunCount() << " runs indexed; "
+              << (board->wasRebuilt() ? "rebuilt" : "added " + std::to_string(board->getLastIndexed()))
+              << " in " << std::fixed << std::setprecision(1) << took / 1000 << " ms" << std::endl;
+    return board;
+}
+
+int showTop(const std::string& path, int level, std::size_t count) {
+    std::unique_ptr<Leaderboard> board = openLeaderboard(path);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<LeaderboardEntry> top = level > 0 ? board->topLevel(level, count) : board->topRuns(count);
+    double took = microsecondsSince(start);
+
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        std::cout << std::setw(4) << i + 1 << ". " << std::left << std::setw(16) << top[i].playerName
+                  << std::right << std::setw(6) << top[i].score << std::endl;
+    }
+    std::cerr << "top " << count << (level > 0 ? " on level " + std::to_string(level) : std::string())
+              << " in " << std::setprecision(1) << took << " us" << std::endl;
+    return 0;
+}
+
+int showPlayer(const std::string& path, const std::string& name) {
+    std::unique_ptr<Leaderboard> board = openLeaderboard(path);
+    auto start = std::chrono::steady_clock::now();
+    LeaderboardEntry best;
+    bool found = board->playerBest(name, best);
+    std::size_t rank = board->playerRank(name);
+    double took = microsecondsSince(start);
+
+    if (!found) {
+        std::cerr << name << " has no runs" << std::endl;
+        return 1;
+    }
+    std::cout << best.playerName << ": best " << best.score << ", rank " << rank << " of "
+              << board->getRunCount() << std::endl;
+    std::cerr << "best and rank in " << std::fixed << std::setprecision(1) << took << " us" << std::endl;
+    return 0;
+}
+
+int listRuns(const std::string& path) {
+    std::size_t count = 0;
+    std::uint64_t intact = RunLog::forEach(path, [&](const RunRecord& record) {
+        std::time_t seconds = static_cast<std::time_t>(record.timestamp / 1000);
+        char when[32] = "imported";
+        if (record.timestamp != 0) {
+            std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+        }
+        std::cout << when << "  " << std::left << std::setw(16) << record.playerName << std::right
+                  << std::setw(6) << record.total;
+        for (const RunLevelResult& level : record.levels) {
+            std::cout << "  " << level.moves << "/" << level.score;
+        }
+        std::cout << std::endl;
+        ++count;
+    });
+
+    struct stat info;
+    std::uint64_t size = ::stat(path.c_str(), &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+    std::cerr << count << " runs, " << intact << " of " << size << " bytes intact" << std::endl;
+    return intact == size ? 0 : 1;
+}
+
+int benchAppends(const std::string& path, long long count, bool sync) {
+    RunLog log(path, nullptr, sync);
+    RunRecord record;
+    record.levels = {{154, 237}, {274, 640}, {205, 449}};
+
+    double halves[2] = {0, 0};
+    for (int half = 0; half < 2; ++half) {
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < count / 2; ++i) {
+            record.playerName = "bench" + std::to_string(i % 1000);
+            record.timestamp = static_cast<std::uint64_t>(i);
+            record.total = static_cast<int>(i % 1400);
+            log.append(record);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        halves[half] = elapsed.count();
+    }
+
+    double each = static_cast<double>(count / 2);
+    std::cerr << count / 2 * 2 << " appends (" << (sync ? "fdatasync each" : "no sync") << "): first half "
+              << std::fixed << std::setprecision(2) << halves[0] / each * 1e6 << " us/append, second half "
+              << halves[1] / each * 1e6 << " us/append" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path = "../data/runs.mwlog";
+    std::string command;
+    long long benchCount = 0;
+    std::size_t keep = 10;
+    std::size_t topCount = 10;
+    int level = 0;
+    std::string playerName;
+    bool sync = true;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--log") == 0 && hasValue) {
+            path = argv[++i];
+        } else if (std::strcmp(argv[i], "--keep") == 0 && hasValue) {
+            keep = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--count") == 0 && hasValue) {
+            topCount = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--level") == 0 && hasValue) {
+            level = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-sync") == 0) {
+            sync = false;
+        } else if (command.empty() && argv[i][0] != '-') {
+            command = argv[i];
+            if (command == "bench" && hasValue) {
+                benchCount = std::atoll(argv[++i]);
+            } else if (command == "player" && hasValue) {
+                playerName = argv[++i];
+            }
+        } else {
+            command.clear();
+            break;
+        }
+    }
+
+    try {
+        if (command == "list") {
+            return listRuns(path);
+        } else if (command == "compact") {
+            CompactionResult result = RunLog::compact(path, keep);
+            std::cerr << path << ": " << result.recordsBefore << " -> " << result.recordsAfter << " runs, "
+                      << result.bytesBefore << " -> " << result.bytesAfter << " bytes" << std::endl;
+            return 0;
+        } else if (command == "bench" && benchCount > 0) {
+            return benchAppends(path, benchCount, sync);
+        } else if (command == "top") {
+            return showTop(path, level, topCount);
+        } else if (command == "player" && !playerName.empty()) {
+            return showPlayer(path, playerName);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    printUsage(argv[0]);
+    return 2;
+}
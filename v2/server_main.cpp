@@ -0,0 +1,113 @@
+#include "game_server.hpp"
+#include "level_format.hpp"
+#include "level_validator.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/resource.h>
+
+// Multi-session game server - every TCP connection plays its own game
+//
+//   mulavee_server [--host ADDR] [--port N] [--spectate-port N] [--threads N]
+//                  [--max-sessions N] [--data DIR] [--runs FILE]
+//
+// Play with `telnet 127.0.0.1 7777`; watch a game with `telnet 127.0.0.1 7778` and its
+// number (shown top right on the player's screen), or --spectate-port 0 to turn it off. Levels are DIR/level1..3, loaded once and shared
+// by every session. With --runs, finished runs are appended to that run log.
+// SIGINT or SIGTERM stops the server and prints its counters.
+
+namespace {
+
+using namespace MulaWee;
+
+GameServer* activeServer = nullptr;
+
+void handleStopSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--host ADDR] [--port N] [--spectate-port N] [--threads N]"
+              << " [--max-sessions N] [--data DIR] [--runs FILE]" << std::endl;
+}
+
+// Each session holds a socket; allow as many as the hard limit does
+void raiseDescriptorLimit() {
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    GameServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+            options.host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            options.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spectate-port") == 0 && hasValue) {
+            options.spectatePort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--max-sessions") == 0 && hasValue) {
+            options.maxSessions = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--runs") == 0 && hasValue) {
+            options.runLogFile = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        std::vector<std::shared_ptr<const Level>> levels;
+        for (int i = 1; i <= 3; ++i) {
+            std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+            std::string compiled = LevelFormat::compiledPathFor(path);
+            levels.push_back(std::make_shared<const Level>(LevelFormat::isCompiled(compiled) ? compiled : path));
+            LevelValidator().check(*levels.back()); // Never serve an unplayable level
+        }
+
+        raiseDescriptorLimit();
+        GameServer server(levels, options);
+        activeServer = &server;
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = handleStopSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        std::cerr << "Serving games on " << options.host << ":" << options.port << " (" << options.threads
+                  << (options.threads == 1 ? " loop)" : " loops)") << std::endl;
+        server.run();
+        activeServer = nullptr;
+
+        const GameServerStats& stats = server.getStats();
+        std::cerr << stats.sessions << " sessions (" << stats.refused << " refused, peak " << stats.peakSessions
+                  << "), " << stats.keys << " keys, " << stats.frames << " frames, " << stats.bytesSent
+                  << " bytes sent, " << stats.runs << " runs finished, " << stats.pauses << " pauses"
+                  << std::endl;
+        if (stats.runsNotLogged > 0) {
+            std::cerr << stats.runsNotLogged << " finished runs could not be written to the run log" << std::endl;
+        }
+        std::cerr << stats.spectators << " spectators, " << stats.framesShared << " frames shared, "
+                  << stats.framesSkipped << " skipped, " << stats.keyframes << " keyframes" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
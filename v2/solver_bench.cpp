@@ -0,0 +1,397 @@
+#include "corridor_graph.hpp"
+#include "distance_field.hpp"
+#include "fixed_level.hpp"
+#include "hierarchical_solver.hpp"
+#include "maze_solver.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// Solver benchmark - BFS vs bidirectional BFS vs A* on the shipped levels and on
+// generated mazes, then A* over the level's CorridorGraph. The shipped levels run
+// twice, as a Level and as a FixedLevel of their size (from the generated
+// embedded_level_sizes.inc), and random moves are timed the same two ways. Generated mazes also run through a HierarchicalSolver: build,
+// route queries from random cells, and a rebuild after an edit. Last comes the hint's
+// DistanceField: lookups from random cells, then a walk along the hints while walls
+// near the player open and close.
+//
+//   mulavee_solver_bench [--data DIR] [--size N] [--mazes K] [--loops PERCENT] [--cluster N]
+
+namespace {
+
+using MulaWee::CorridorGraph;
+using MulaWee::DistanceField;
+using MulaWee::HierarchicalSolver;
+using MulaWee::Level;
+using MulaWee::MazeSolver;
+using MulaWee::PackedGrid;
+using MulaWee::Position;
+using MulaWee::SolverAlgorithm;
+using MulaWee::withFixedLevel;
+
+const SolverAlgorithm ALGORITHMS[] = {
+    SolverAlgorithm::BFS, SolverAlgorithm::BIDIRECTIONAL_BFS, SolverAlgorithm::ASTAR
+};
+
+struct XorShift {
+    std::uint64_t state;
+    explicit XorShift(std::uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+    std::uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// Perfect maze by iterative backtracking on an N x N grid (N odd), with a share of the
+// remaining inner walls knocked out so there are loops for A* to exploit
+Level generateMaze(int size, std::uint64_t seed, int loopPercent) {
+    PackedGrid grid(size, size);
+    XorShift rng(seed);
+    const int cellRows = size / 2;
+    const int cellCols = size / 2;
+
+    std::vector<std::uint32_t> stack;
+    std::vector<bool> seen(static_cast<std::size_t>(cellRows) * cellCols, false);
+    stack.push_back(0);
+    seen[0] = true;
+    grid.set(1, 1, MulaWee::CellType::PATH);
+
+    const int dr[4] = {-1, 1, 0, 0};
+    const int dc[4] = {0, 0, -1, 1};
+    while (!stack.empty()) {
+        std::uint32_t cell = stack.back();
+        int r = static_cast<int>(cell / cellCols);
+        int c = static_cast<int>(cell % cellCols);
+
+        int options[4];
+        int count = 0;
+        for (int d = 0; d < 4; ++d) {
+            int nr = r + dr[d];
+            int nc = c + dc[d];
+            if (nr >= 0 && nr < cellRows && nc >= 0 && nc < cellCols &&
+                !seen[static_cast<std::size_t>(nr) * cellCols + nc]) {
+                options[count++] = d;
+            }
+        }
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int d = options[rng.next() % count];
+        int nr = r + dr[d];
+        int nc = c + dc[d];
+        seen[static_cast<std::size_t>(nr) * cellCols + nc] = true;
+        grid.set(2 * r + 1 + dr[d], 2 * c + 1 + dc[d], MulaWee::CellType::PATH);
+        grid.set(2 * nr + 1, 2 * nc + 1, MulaWee::CellType::PATH);
+        stack.push_back(static_cast<std::uint32_t>(nr) * cellCols + nc);
+    }
+
+    for (int r = 1; r < size - 1; ++r) {
+        for (int c = 1 + (r % 2); c < size - 1; c += 2) {
+            if (grid.get(r, c) == MulaWee::CellType::WALL &&
+                static_cast<int>(rng.next() % 100) < loopPercent) {
+                grid.set(r, c, MulaWee::CellType::PATH);
+            }
+        }
+    }
+
+    Position goal(1, size - 2);
+    grid.set(goal.row, goal.col, MulaWee::CellType::GOAL);
+    return Level(std::move(grid), Position(size - 2, 1), goal,
+                 "generated-" + std::to_string(size) + "-" + std::to_string(seed));
+}
+
+void printRow(const std::string& name, const char* solver, const MulaWee::SolveResult& result, double us,
+              int expectedMoves) {
+    std::cout << std::left << std::setw(28) << name << std::setw(7) << solver
+              << std::right << std::setw(10) << result.moves()
+              << std::setw(12) << result.expanded
+              << std::setw(14) << std::fixed << std::setprecision(1) << us
+              << (result.moves() == expectedMoves ? "" : "  MISMATCH") << std::endl;
+}
+
+// Returns the moves found, for the graph run to compare against
+template <typename LevelType>
+int benchmark(MazeSolver& solver, const LevelType& level, int repetitions, const char* variant = "") {
+    int expectedMoves = -2;
+    for (SolverAlgorithm algorithm : ALGORITHMS) {
+        MulaWee::SolveResult result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            result = solver.solve(algorithm, level);
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (expectedMoves == -2) {
+            expectedMoves = result.moves();
+        }
+        printRow(level.getFilename() + variant, MulaWee::solverName(algorithm), result,
+                 elapsed.count() / repetitions, expectedMoves);
+    }
+    return expectedMoves;
+}
+
+// A* over the contracted graph, plus what building it cost
+void benchmarkGraph(const Level& level, int repetitions, int expectedMoves) {
+    auto start = std::chrono::steady_clock::now();
+    CorridorGraph graph(level);
+    std::chrono::duration<double, std::milli> built = std::chrono::steady_clock::now() - start;
+
+    MulaWee::SolveResult result;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i) {
+        result = graph.solve(level);
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    printRow(level.getFilename(), "graph", result, elapsed.count() / repetitions, expectedMoves);
+    std::cout << "  " << graph.getNodeCount() << " nodes, " << graph.getEdgeCount() / 2 << " corridors, built in "
+              << std::setprecision(1) << built.count() << " ms, " << std::setprecision(2)
+              << static_cast<double>(graph.memoryUsage()) / (1024 * 1024) << " MiB" << std::endl;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// HPA*: the start-to-goal row, then queries from random open cells to the goal,
+// then a block of walls knocked out in the middle and the affected clusters rebuilt
+void benchmarkHierarchical(const Level& level, int clusterSize, int expectedMoves) {
+    auto start = std::chrono::steady_clock::now();
+    HierarchicalSolver solver(level, clusterSize);
+    double built = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    MulaWee::SolveResult result = solver.solve(level);
+    printRow(level.getFilename(), "hpa", result, millisecondsSince(start) * 1000, result.moves());
+    std::cout << "  " << solver.getClusterCount() << " clusters of " << clusterSize << "x" << clusterSize << ", "
+              << solver.getNodeCount() << " nodes, " << solver.getEdgeCount() << " edges, built in "
+              << std::setprecision(1) << built << " ms, " << std::setprecision(2)
+              << static_cast<double>(solver.memoryUsage()) / (1024 * 1024) << " MiB; route "
+              << result.moves() - expectedMoves << " moves over the shortest" << std::endl;
+
+    XorShift rng(11);
+    const int queries = 20;
+    double total = 0, slowest = 0;
+    for (int i = 0; i < queries; ++i) {
+        Position from;
+        do {
+            from = Position(static_cast<int>(rng.next() % level.getRows()), static_cast<int>(rng.next() % level.getCols()));
+        } while (!level.canMoveTo(from));
+        start = std::chrono::steady_clock::now();
+        solver.solve(level, from, level.getGoalPosition());
+        double took = millisecondsSince(start);
+        total += took;
+        slowest = std::max(slowest, took);
+    }
+    std::cout << "  " << queries << " routes from random cells: " << std::setprecision(2) << total / queries
+              << " ms mean, " << slowest << " ms max" << std::endl;
+
+    PackedGrid grid = level.getGrid();
+    const Position first(level.getRows() / 2 - 4, level.getCols() / 2 - 4);
+    const Position last(first.row + 8, first.col + 8);
+    for (int r = first.row; r <= last.row; ++r) {
+        for (int c = first.col; c <= last.col; ++c) {
+            grid.set(r, c, MulaWee::CellType::PATH);
+        }
+    }
+    Level edited(std::move(grid), level.getStartPosition(), level.getGoalPosition(), level.getFilename());
+    start = std::chrono::steady_clock::now();
+    std::size_t rebuilt = solver.update(edited, first, last);
+    double updated = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    HierarchicalSolver fresh(edited, clusterSize);
+    double rebuiltAll = millisecondsSince(start);
+    bool same = solver.solve(edited).moves() == fresh.solve(edited).moves();
+    std::cout << "  9x9 edit: " << rebuilt << " clusters rebuilt in " << std::setprecision(2) << updated
+              << " ms (full rebuild " << std::setprecision(1) << rebuiltAll << " ms)"
+              << (same ? "" : "  MISMATCH") << std::endl;
+}
+
+// DistanceField: build, hint lookups from random cells, then a walk that follows the
+// hints while a wall near the player opens or closes every few moves, timing each hint
+void benchmarkHints(const Level& level, int expectedMoves) {
+    auto start = std::chrono::steady_clock::now();
+    DistanceField field(level);
+    double built = millisecondsSince(start);
+    const bool same = static_cast<int>(field.distance(level.getStartPosition())) == expectedMoves;
+    std::cout << "  hint field built in " << std::setprecision(1) << built << " ms, " << std::setprecision(2)
+              << static_cast<double>(field.memoryUsage()) / (1024 * 1024) << " MiB" << (same ? "" : "  MISMATCH")
+              << std::endl;
+
+    XorShift rng(13);
+    std::vector<Position> cells;
+    while (cells.size() < 4096) {
+        Position pos(static_cast<int>(rng.next() % level.getRows()), static_cast<int>(rng.next() % level.getCols()));
+        if (level.canMoveTo(pos)) {
+            cells.push_back(pos);
+        }
+    }
+    const int lookups = 2000000;
+    std::uint32_t sink = 0;
+    MulaWee::Direction dir = MulaWee::Direction::UP;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        sink += field.bestMove(cells[i & 4095], dir) ? static_cast<std::uint32_t>(dir) : 0;
+    }
+    double lookup = millisecondsSince(start) * 1e6 / lookups;
+    volatile std::uint32_t keep = sink;
+    (void)keep;
+
+    // Walls change within a few cells of the player; a closed cell that leaves no route
+    // is opened again straight away
+    PackedGrid grid = level.getGrid();
+    Position player = level.getStartPosition();
+    const int window = 8;
+    const int dr[4] = {-1, 1, 0, 0};
+    const int dc[4] = {0, 0, -1, 1};
+    std::size_t edits = 0, hints = 0, unfinished = 0;
+    double total = 0, slowest = 0;
+    for (int step = 0; step < 20000 && !(player == level.getGoalPosition()); ++step) {
+        Position changed = player;
+        if (step % 10 == 0) {
+            Position pos(player.row + static_cast<int>(rng.next() % (2 * window + 1)) - window,
+                         player.col + static_cast<int>(rng.next() % (2 * window + 1)) - window);
+            if (pos.row > 0 && pos.row < level.getRows() - 1 && pos.col > 0 && pos.col < level.getCols() - 1 &&
+                !(pos == player) && !(pos == level.getGoalPosition())) {
+                const bool wall = !field.isWall(pos);
+                field.setWall(pos, wall, player);
+                grid.set(pos.row, pos.col, wall ? MulaWee::CellType::WALL : MulaWee::CellType::PATH);
+                changed = pos;
+                ++edits;
+            }
+        }
+        start = std::chrono::steady_clock::now();
+        bool found = field.bestMove(player, dir);
+        double took = millisecondsSince(start);
+        ++hints;
+        total += took;
+        slowest = std::max(slowest, took);
+        if (field.isRepairing()) {
+            ++unfinished; // The next hint carries on from here
+            continue;
+        }
+        if (!found) {
+            field.setWall(changed, false, player);
+            grid.set(changed.row, changed.col, MulaWee::CellType::PATH);
+            continue;
+        }
+        player = Position(player.row + dr[static_cast<int>(dir)], player.col + dc[static_cast<int>(dir)]);
+    }
+
+    Level edited(std::move(grid), player, level.getGoalPosition(), level.getFilename());
+    start = std::chrono::steady_clock::now();
+    DistanceField fresh(edited);
+    double refilled = millisecondsSince(start);
+    bool agrees = field.distance(player) == fresh.distance(player) &&
+                  field.distance(level.getStartPosition()) == fresh.distance(level.getStartPosition());
+    std::cout << "  hint lookup " << std::setprecision(1) << lookup << " ns; walk of " << hints << " hints with "
+              << edits << " wall changes: " << std::setprecision(3) << total * 1000 / hints << " us mean, "
+              << slowest * 1000 << " us max, " << unfinished << " out of budget, " << field.getRepairedCells()
+              << " cells repaired (full refill "
+              << std::setprecision(1) << refilled << " ms)" << (agrees ? "" : "  MISMATCH") << std::endl;
+}
+
+// Nanoseconds per Player::move, over the same random directions for either variant
+template <typename LevelType>
+double timeMoves(const LevelType& level, long long moves) {
+    MulaWee::Player player(level.getStartPosition());
+    XorShift rng(7);
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < moves; ++i) {
+        player.move(static_cast<MulaWee::Direction>(rng.next() & 3), level);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    volatile int sink = player.getMoveCount();
+    (void)sink;
+    return elapsed.count() / static_cast<double>(moves);
+}
+
+// Generated from ../data/levelN.dat by the Makefile: EmbeddedLevelSizes, the
+// FixedLevel sizes the fixed rows can use
+#include "embedded_level_sizes.inc"
+
+void reportNoFixedSize(const Level& level) {
+    std::cout << level.getFilename() << ": no FixedLevel<" << level.getRows() << ", " << level.getCols()
+              << ">, not among the embedded level sizes" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    int size = 4095;
+    int mazes = 2;
+    int loopPercent = 5;
+    int clusterSize = HierarchicalSolver::DEFAULT_CLUSTER_SIZE;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            size = std::atoi(argv[++i]) | 1;
+        } else if (std::strcmp(argv[i], "--mazes") == 0 && hasValue) {
+            mazes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--loops") == 0 && hasValue) {
+            loopPercent = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cluster") == 0 && hasValue) {
+            clusterSize = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--data DIR] [--size N] [--mazes K] [--loops PERCENT] [--cluster N]" << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        MazeSolver solver;
+        std::cout << std::left << std::setw(28) << "level" << std::setw(7) << "solver"
+                  << std::right << std::setw(10) << "moves" << std::setw(12) << "expanded"
+                  << std::setw(14) << "us/solve" << std::endl;
+
+        std::vector<Level> shipped;
+        for (int i = 1; i <= 3; ++i) {
+            shipped.emplace_back(dataDir + "/level" + std::to_string(i) + ".dat");
+            int moves = benchmark(solver, shipped.back(), 2000);
+            if (!withFixedLevel(shipped.back(), [&solver](const auto& fixed) { benchmark(solver, fixed, 2000, " (fixed)"); },
+                                EmbeddedLevelSizes())) {
+                reportNoFixedSize(shipped.back());
+            }
+            benchmarkGraph(shipped.back(), 2000, moves);
+        }
+
+        for (int i = 0; i < mazes; ++i) {
+            Level level = generateMaze(size, 1000 + i, loopPercent);
+            int moves = benchmark(solver, level, 3);
+            benchmarkGraph(level, 3, moves);
+            benchmarkHierarchical(level, clusterSize, moves);
+            benchmarkHints(level, moves);
+        }
+
+        const long long moves = 20000000;
+        for (const Level& level : shipped) {
+            double dynamic = timeMoves(level, moves);
+            double fixed = 0;
+            if (!withFixedLevel(level, [&fixed](const auto& fixedLevel) { fixed = timeMoves(fixedLevel, moves); },
+                                EmbeddedLevelSizes())) {
+                reportNoFixedSize(level);
+                continue;
+            }
+            std::cout << level.getFilename() << ": Player::move " << std::setprecision(2) << dynamic
+                      << " ns on Level, " << fixed << " ns on FixedLevel" << std::endl;
+        }
+
+        std::cout << "solver buffers: " << solver.memoryUsage() / (1024 * 1024) << " MiB" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
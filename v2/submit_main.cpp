@@ -0,0 +1,144 @@
+#include "verify_server.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// Score submission client for mulavee_verifyd
+//
+//   mulavee_submit [--socket PATH] [--bench N] [--connections C] REPLAY.mwr...
+//
+// Submits each replay and prints the daemon's verdict; exits with 1 unless every one
+// is accepted. --bench pipelines the whole set N times over each of C connections
+// (one sending and one receiving thread per connection) and reports the rate.
+
+namespace {
+
+using namespace MulaWee;
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--socket PATH] [--bench N] [--connections C] REPLAY.mwr..."
+              << std::endl;
+}
+
+struct BenchTally {
+    std::size_t responses = 0;
+    std::size_t accepted = 0;
+    std::string error;
+};
+
+void benchConnection(const std::string& socketPath, const std::vector<std::vector<std::uint8_t>>& requests,
+                     int rounds, BenchTally& tally) {
+    try {
+        VerifyClient client(socketPath);
+        std::size_t expected = requests.size() * static_cast<std::size_t>(rounds);
+        std::thread sender([&] {
+            try {
+                for (int round = 0; round < rounds; ++round) {
+                    for (const std::vector<std::uint8_t>& request : requests) {
+                        client.send(request);
+                    }
+                }
+            } catch (const std::exception&) {
+                // The receiving side reports the closed connection
+            }
+        });
+        try {
+            for (; tally.responses < expected; ++tally.responses) {
+                if (client.receive().status == VerifyStatus::ACCEPTED) {
+                    ++tally.accepted;
+                }
+            }
+        } catch (const std::exception& e) {
+            tally.error = e.what();
+        }
+        sender.join();
+    } catch (const std::exception& e) {
+        tally.error = e.what();
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string socketPath = VerifyProtocol::DEFAULT_SOCKET;
+    std::vector<std::string> replayFiles;
+    int benchRounds = 0;
+    int connectionCount = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--socket") == 0 && hasValue) {
+            socketPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--bench") == 0 && hasValue) {
+            benchRounds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--connections") == 0 && hasValue) {
+            connectionCount = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] != '-') {
+            replayFiles.push_back(argv[i]);
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (replayFiles.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try {
+        bool allAccepted = true;
+        std::vector<std::vector<std::uint8_t>> requests;
+        VerifyClient client(socketPath);
+        for (const std::string& file : replayFiles) {
+            try {
+                Replay replay = Replay::load(file);
+                requests.push_back(replay.serialize());
+                client.send(requests.back());
+            } catch (const GameException& e) {
+                std::cout << file << ": UNREADABLE (" << e.what() << ")" << std::endl;
+                allAccepted = false;
+                continue;
+            }
+            VerifyResponse response = client.receive();
+            std::cout << file << ": " << verifyStatusName(response.status) << " score " << response.score
+                      << " levels " << response.levelsCompleted << std::endl;
+            allAccepted = allAccepted && response.status == VerifyStatus::ACCEPTED;
+        }
+
+        if (benchRounds > 0 && !requests.empty()) {
+            std::vector<BenchTally> tallies(connectionCount);
+            std::vector<std::thread> connections;
+            auto start = std::chrono::steady_clock::now();
+            for (BenchTally& tally : tallies) {
+                connections.emplace_back(benchConnection, std::cref(socketPath), std::cref(requests),
+                                         benchRounds, std::ref(tally));
+            }
+            for (std::thread& connection : connections) {
+                connection.join();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            BenchTally total;
+            for (const BenchTally& tally : tallies) {
+                total.responses += tally.responses;
+                total.accepted += tally.accepted;
+                if (!tally.error.empty()) {
+                    std::cerr << "Connection failed: " << tally.error << std::endl;
+                    allAccepted = false;
+                }
+            }
+            std::cerr << total.responses << " submissions over " << connectionCount << " connections in "
+                      << std::fixed << std::setprecision(3) << elapsed.count() << " s ("
+                      << std::setprecision(0) << total.responses / elapsed.count() << " submissions/s, "
+                      << total.accepted << " accepted)" << std::endl;
+        }
+
+        return allAccepted ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
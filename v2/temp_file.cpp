@@ -0,0 +1,40 @@
+#include "temp_file.hpp"
+#include "game_core.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MulaWee {
+
+// TempFile class implementation
+TempFile::TempFile(const std::string& path) : target(path), tempPath(path + ".XXXXXX"), fd(-1) {
+    fd = ::mkstemp(&tempPath[0]);
+    if (fd < 0) {
+        throw FileException(tempPath);
+    }
+    if (::fchmod(fd, 0644) != 0) { // mkstemp makes it 0600
+        ::close(fd);
+        ::unlink(tempPath.c_str());
+        throw FileException(tempPath);
+    }
+}
+
+TempFile::~TempFile() {
+    if (fd >= 0) {
+        ::close(fd);
+        ::unlink(tempPath.c_str());
+    }
+}
+
+void TempFile::commit() {
+    bool synced = ::fdatasync(fd) == 0;
+    synced = ::close(fd) == 0 && synced;
+    fd = -1;
+    if (!synced || std::rename(tempPath.c_str(), target.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        throw GameException("Failed to replace " + target);
+    }
+}
+
+} // namespace MulaWee
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+namespace MulaWee {
+
+// A file written under a name of its own beside `path` (mkstemp) and renamed over it
+// once complete. Readers never see half a file, concurrent writers never share a
+// temporary file, and the data is on disk (fdatasync) before the rename. Unless
+// commit() succeeds, the temporary file is removed when the object goes away.
+class TempFile {
+private:
+    std::string target;
+    std::string tempPath;
+    int fd; // Kept open for the sync in commit(); -1 once committed
+
+public:
+    // Throws FileException if the temporary file cannot be created
+    explicit TempFile(const std::string& path);
+    ~TempFile();
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    // Where to write the contents. Any stream may open it; close or flush it before commit().
+    const std::string& getPath() const { return tempPath; }
+
+    // Sync the contents and rename them over the target; throws GameException
+    void commit();
+};
+
+} // namespace MulaWee
@@ -0,0 +1,199 @@
+#include "agents.hpp"
+#include "corridor_graph.hpp"
+#include "level_format.hpp"
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Bot tournament - every agent plays every level on all cores
+//
+//   mulavee_tournament [--data DIR] [--agents a,b,...] [--threads N] [--max-moves N]
+//                      [--seed S] [--out FILE] [LEVEL...]
+//
+// Levels default to DIR/level1..3 (compiled form preferred). Level N in the list is
+// scored as level N by ScoreManager::calculateLevelScore. Writes one CSV row per
+// agent x level pair, with the level's par (shortest route, from its CorridorGraph),
+// then a ranking to stderr.
+
+namespace {
+
+using namespace MulaWee;
+
+struct MatchResult {
+    bool solved = false;
+    int moves = 0;      // Successful moves (Player::getMoveCount)
+    long long steps = 0; // Directions the agent asked for
+    int score = 0;
+    double wallMs = 0.0;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+MatchResult playMatch(const std::string& agentName, const std::shared_ptr<const Level>& level,
+                      int levelNumber, std::uint64_t seed, long long maxMoves) {
+    auto start = std::chrono::steady_clock::now();
+    MatchResult result;
+
+    std::unique_ptr<Agent> agent = createAgent(agentName, seed);
+    GameSession session({level}, "");
+    session.begin(agentName);
+    agent->reset(*level, session.getPlayer().getPosition());
+
+    while (session.getState() == GameState::PLAYING && result.steps < maxMoves) {
+        session.move(agent->nextMove(*level, session.getPlayer().getPosition()));
+        ++result.steps;
+    }
+
+    result.moves = session.getPlayer().getMoveCount();
+    result.solved = session.getState() == GameState::LEVEL_COMPLETE;
+    if (result.solved) {
+        result.score = session.getScoreManager().calculateLevelScore(levelNumber, result.moves);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    result.wallMs = elapsed.count();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    std::vector<std::string> agents = agentNames();
+    std::vector<std::string> levelFiles;
+    unsigned threads = 0;
+    long long maxMoves = 10000000;
+    std::uint64_t seed = 1;
+    std::string outFile;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--agents") == 0 && hasValue) {
+            agents = splitList(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--max-moves") == 0 && hasValue) {
+            maxMoves = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            outFile = argv[++i];
+        } else if (argv[i][0] != '-') {
+            levelFiles.push_back(argv[i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--data DIR] [--agents a,b,...] [--threads N]"
+                      << " [--max-moves N] [--seed S] [--out FILE] [LEVEL...]" << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        if (levelFiles.empty()) {
+            for (int i = 1; i <= 3; ++i) {
+                std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+                std::string compiled = LevelFormat::compiledPathFor(path);
+                levelFiles.push_back(LevelFormat::isCompiled(compiled) ? compiled : path);
+            }
+        }
+        for (const std::string& agent : agents) {
+            createAgent(agent, seed); // Reject unknown names before starting
+        }
+
+        std::vector<std::shared_ptr<const Level>> levels;
+        std::vector<int> par;
+        for (const std::string& file : levelFiles) {
+            levels.push_back(std::make_shared<const Level>(file));
+            par.push_back(CorridorGraph(*levels.back()).distance(*levels.back()));
+        }
+
+        // One slot per pair; each task writes only its own slot
+        std::vector<MatchResult> results(agents.size() * levels.size());
+        auto start = std::chrono::steady_clock::now();
+        std::size_t steals = 0;
+        unsigned threadCount = 0;
+        {
+            WorkStealingPool pool(threads);
+            threadCount = pool.getThreadCount();
+            for (std::size_t a = 0; a < agents.size(); ++a) {
+                for (std::size_t l = 0; l < levels.size(); ++l) {
+                    pool.submit([&, a, l] {
+                        results[a * levels.size() + l] = playMatch(
+                            agents[a], levels[l], static_cast<int>(l) + 1, seed + l, maxMoves);
+                    });
+                }
+            }
+            pool.wait();
+            steals = pool.getStealCount();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::ofstream file;
+        if (!outFile.empty()) {
+            file.open(outFile);
+            if (!file.is_open()) {
+                throw FileException(outFile);
+            }
+        }
+        std::ostream& out = outFile.empty() ? std::cout : file;
+
+        out << "agent,level,par,solved,moves,steps,score,wall_ms\n";
+        struct Standing {
+            std::string agent;
+            int solved = 0;
+            long long score = 0;
+            long long moves = 0;
+        };
+        std::vector<Standing> standings(agents.size());
+        for (std::size_t a = 0; a < agents.size(); ++a) {
+            standings[a].agent = agents[a];
+            for (std::size_t l = 0; l < levels.size(); ++l) {
+                const MatchResult& r = results[a * levels.size() + l];
+                out << agents[a] << ',' << levels[l]->getFilename() << ',' << par[l] << ',' << (r.solved ? 1 : 0)
+                    << ',' << r.moves << ',' << r.steps << ',' << r.score << ','
+                    << std::fixed << std::setprecision(3) << r.wallMs << '\n';
+                standings[a].solved += r.solved ? 1 : 0;
+                standings[a].score += r.score;
+                standings[a].moves += r.moves;
+            }
+        }
+
+        // Rank by total score, then by fewer moves (the score floors out on long runs)
+        std::sort(standings.begin(), standings.end(), [](const Standing& x, const Standing& y) {
+            if (x.score != y.score) return x.score > y.score;
+            if (x.moves != y.moves) return x.moves < y.moves;
+            return x.agent < y.agent;
+        });
+
+        std::cerr << results.size() << " matches on " << threadCount << " threads in "
+                  << std::fixed << std::setprecision(3) << elapsed.count() << " s ("
+                  << steals << " steals)\n";
+        for (std::size_t i = 0; i < standings.size(); ++i) {
+            std::cerr << i + 1 << ". " << std::left << std::setw(14) << standings[i].agent << std::right
+                      << " solved " << standings[i].solved << "/" << levels.size()
+                      << "  score " << standings[i].score << "  moves " << standings[i].moves << '\n';
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
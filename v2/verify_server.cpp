@@ -0,0 +1,560 @@
+#include "verify_server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <chrono>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace MulaWee {
+
+namespace {
+
+constexpr std::uint64_t LISTEN_ID = 0;
+constexpr std::uint64_t WAKE_ID = 1;
+constexpr int MAX_EVENTS = 64;
+constexpr std::uint32_t READ_EVENTS = EPOLLIN;
+constexpr std::uint32_t WRITE_EVENTS = EPOLLOUT;
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    out[0] = static_cast<std::uint8_t>(value);
+    out[1] = static_cast<std::uint8_t>(value >> 8);
+    out[2] = static_cast<std::uint8_t>(value >> 16);
+    out[3] = static_cast<std::uint8_t>(value >> 24);
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    return static_cast<std::uint32_t>(in[0]) | static_cast<std::uint32_t>(in[1]) << 8 |
+           static_cast<std::uint32_t>(in[2]) << 16 | static_cast<std::uint32_t>(in[3]) << 24;
+}
+
+GameException systemError(const std::string& what) {
+    return GameException(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw GameException("Bad socket path: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return address;
+}
+
+} // namespace
+
+const char* verifyStatusName(VerifyStatus status) {
+    switch (status) {
+        case VerifyStatus::ACCEPTED: return "ACCEPTED";
+        case VerifyStatus::REJECTED: return "REJECTED";
+        case VerifyStatus::INVALID: return "INVALID";
+        case VerifyStatus::TOO_LARGE: return "TOO_LARGE";
+        case VerifyStatus::NOT_RECORDED: return "NOT_RECORDED";
+    }
+    return "UNKNOWN";
+}
+
+// ScoreVerifier class implementation
+ScoreVerifier::ScoreVerifier(const std::vector<std::shared_ptr<const Level>>& gameLevels)
+    : levels(gameLevels), replayer(gameLevels), scorer("") {}
+
+VerifyResponse ScoreVerifier::verify(const Replay& replay, RunRecord* run) const {
+    VerifyResponse response;
+    const std::vector<ReplayLevel>& played = replay.getLevels();
+    if (replay.getLevelCount() != static_cast<int>(levels.size()) || played.size() > levels.size()) {
+        return response;
+    }
+    for (std::size_t i = 0; i < played.size(); ++i) {
+        if (played[i].checksum != levels[i]->getChecksum()) {
+            return response;
+        }
+    }
+
+    ReplayResult result = replayer.run(replay);
+    if (!result.valid) {
+        return response;
+    }
+
+    std::vector<RunLevelResult> levelResults;
+    int score = 0;
+    for (int i = 0; i < result.levelsCompleted; ++i) {
+        int levelScore = scorer.calculateLevelScore(i + 1, result.moveCounts[i]);
+        levelResults.push_back(RunLevelResult{result.moveCounts[i], levelScore});
+        score += levelScore;
+    }
+    response.score = score;
+    response.levelsCompleted = result.levelsCompleted;
+    response.status = score == replay.getScore() ? VerifyStatus::ACCEPTED : VerifyStatus::REJECTED;
+
+    if (run && response.status == VerifyStatus::ACCEPTED) {
+        run->playerName = replay.getPlayerName();
+        run->total = score;
+        run->levels = std::move(levelResults);
+    }
+    return response;
+}
+
+// VerifyServer class implementation
+VerifyServer::VerifyServer(const std::vector<std::shared_ptr<const Level>>& gameLevels,
+                           const VerifyServerOptions& serverOptions)
+    : options(serverOptions), verifier(gameLevels),
+      listenFd(-1), epollFd(-1), wakeFd(-1), stopping(false), nextConnectionId(WAKE_ID + 1),
+      inFlight(0), readingPaused(false), runLogFailing(false),
+      pool(std::make_unique<WorkStealingPool>(serverOptions.threads)) {
+    options.maxInFlight = std::max<std::size_t>(1, options.maxInFlight);
+    if (!options.runLogFile.empty()) {
+        runLog = std::make_unique<RunLog>(options.runLogFile);
+    }
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        throw systemError("eventfd");
+    }
+}
+
+VerifyServer::~VerifyServer() {
+    pool.reset(); // Finish queued replays while wakeFd is still ours
+    shutdownSockets();
+    ::close(wakeFd);
+}
+
+void VerifyServer::stop() {
+    stopping.store(true);
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void VerifyServer::run() {
+    sockaddr_un address = socketAddress(options.socketPath);
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw systemError("socket");
+    }
+    ::unlink(options.socketPath.c_str()); // Left behind by a previous run
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw systemError("Cannot bind " + options.socketPath);
+    }
+    if (::listen(listenFd, SOMAXCONN) < 0) {
+        throw systemError("listen");
+    }
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw systemError("epoll_create1");
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = WAKE_ID;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    epoll_event events[MAX_EVENTS];
+    while (!stopping.load()) {
+        int count = ::epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("epoll_wait");
+        }
+        for (int i = 0; i < count; ++i) {
+            std::uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                acceptConnections();
+            } else if (id == WAKE_ID) {
+                drainCompletions();
+            } else {
+                handleEvents(id, events[i].events);
+            }
+        }
+    }
+
+    shutdownSockets();
+}
+
+void VerifyServer::acceptConnections() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // EAGAIN, or out of descriptors until a client leaves
+        }
+        if (connections.size() >= options.maxConnections) {
+            ::close(fd);
+            ++stats.refused;
+            continue;
+        }
+
+        std::uint64_t id = nextConnectionId++;
+        Connection& conn = connections[id];
+        conn.fd = fd;
+        conn.events = wantsRead(conn) ? READ_EVENTS : 0;
+        ++stats.connections;
+
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = conn.events;
+        event.data.u64 = id;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void VerifyServer::handleEvents(std::uint64_t id, std::uint32_t events) {
+    auto found = connections.find(id);
+    if (found == connections.end()) {
+        return;
+    }
+    Connection& conn = found->second;
+
+    // Both directions are gone, so nothing left to answer can be delivered
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeConnection(id);
+        return;
+    }
+    if ((events & EPOLLOUT) && !flushOutput(conn)) {
+        closeConnection(id);
+        return;
+    }
+    if (events & EPOLLIN) {
+        readInput(id, conn);
+    }
+    updateInterest(id, conn);
+    closeIfDone(id);
+}
+
+void VerifyServer::readInput(std::uint64_t id, Connection& conn) {
+    // One read per wakeup keeps a busy client from starving the others
+    std::uint8_t chunk[READ_CHUNK];
+    ssize_t got;
+    do {
+        got = ::read(conn.fd, chunk, sizeof(chunk));
+    } while (got < 0 && errno == EINTR);
+
+    if (got > 0) {
+        conn.input.insert(conn.input.end(), chunk, chunk + got);
+        parseRequests(id, conn);
+        if (!readingPaused && inFlight >= options.maxInFlight) {
+            setReadingPaused(true);
+        }
+    } else if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        conn.peerClosed = true;
+        conn.input.clear();
+    }
+}
+
+void VerifyServer::parseRequests(std::uint64_t id, Connection& conn) {
+    std::size_t offset = 0;
+    while (!conn.closing && inFlight < options.maxInFlight &&
+           conn.input.size() - offset >= VerifyProtocol::HEADER_BYTES) {
+        std::uint32_t length = getU32(conn.input.data() + offset);
+        if (length > options.maxRequestBytes) {
+            VerifyResponse response;
+            response.status = VerifyStatus::TOO_LARGE;
+            ++stats.tooLarge;
+            deliver(conn, conn.nextSequence++, response);
+            conn.closing = true;
+            offset = conn.input.size();
+            break;
+        }
+        if (conn.input.size() - offset - VerifyProtocol::HEADER_BYTES < length) {
+            break;
+        }
+
+        const std::uint8_t* body = conn.input.data() + offset + VerifyProtocol::HEADER_BYTES;
+        submit(id, conn, std::vector<std::uint8_t>(body, body + length));
+        offset += VerifyProtocol::HEADER_BYTES + length;
+    }
+    conn.input.erase(conn.input.begin(), conn.input.begin() + offset);
+}
+
+void VerifyServer::submit(std::uint64_t id, Connection& conn, std::vector<std::uint8_t> request) {
+    std::uint64_t sequence = conn.nextSequence++;
+    ++inFlight;
+    stats.peakInFlight = std::max(stats.peakInFlight, inFlight);
+
+    pool->submit([this, id, sequence, request = std::move(request)] {
+        Completion done{id, sequence, VerifyResponse(), RunRecord()};
+        try {
+            Replay replay = Replay::parse(request.data(), request.size());
+            done.response = verifier.verify(replay, &done.run);
+        } catch (const GameException&) {
+            // Unparseable: left INVALID
+        }
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            wake = completions.empty();
+            completions.push_back(std::move(done));
+        }
+        if (wake) {
+            std::uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    });
+}
+
+void VerifyServer::drainCompletions() {
+    // Reset the eventfd before taking the batch: a worker that finds the list empty
+    // after this point signals again
+    std::uint64_t signalled;
+    ssize_t ignored = ::read(wakeFd, &signalled, sizeof(signalled));
+    (void)ignored;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        draining.swap(completions);
+    }
+
+    std::vector<std::uint64_t> touched;
+    std::uint64_t now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    for (Completion& done : draining) {
+        --inFlight;
+        if (done.response.status == VerifyStatus::ACCEPTED && runLog) {
+            done.run.timestamp = now;
+            acceptedRuns.push_back(std::move(done.run));
+        }
+    }
+
+    // One write and one fdatasync for the whole batch, before anyone hears "accepted".
+    // If it fails the daemon carries on and answers those runs NOT_RECORDED.
+    bool recorded = true;
+    if (!acceptedRuns.empty()) {
+        try {
+            runLog->append(acceptedRuns);
+            if (runLogFailing) {
+                std::fprintf(stderr, "Run log %s is being written again\n", options.runLogFile.c_str());
+                runLogFailing = false;
+            }
+        } catch (const std::exception& e) {
+            recorded = false;
+            if (!runLogFailing) { // Once per outage
+                std::fprintf(stderr, "Run log write failed, accepted runs are answered NOT_RECORDED: %s\n",
+                             e.what());
+                runLogFailing = true;
+            }
+        }
+        acceptedRuns.clear();
+    }
+
+    for (Completion& done : draining) {
+        if (done.response.status == VerifyStatus::ACCEPTED && !recorded) {
+            done.response.status = VerifyStatus::NOT_RECORDED;
+        }
+        switch (done.response.status) {
+            case VerifyStatus::ACCEPTED: ++stats.accepted; break;
+            case VerifyStatus::REJECTED: ++stats.rejected; break;
+            case VerifyStatus::NOT_RECORDED: ++stats.notRecorded; break;
+            default: ++stats.invalid; break;
+        }
+
+        auto found = connections.find(done.connection);
+        if (found != connections.end()) {
+            deliver(found->second, done.sequence, done.response);
+            touched.push_back(done.connection);
+        }
+    }
+    draining.clear();
+
+    if (readingPaused && inFlight <= options.maxInFlight / 2) {
+        setReadingPaused(false);
+    }
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (std::uint64_t id : touched) {
+        auto found = connections.find(id);
+        if (found == connections.end()) {
+            continue;
+        }
+        if (!flushOutput(found->second)) {
+            closeConnection(id);
+            continue;
+        }
+        updateInterest(id, found->second);
+        closeIfDone(id);
+    }
+}
+
+void VerifyServer::deliver(Connection& conn, std::uint64_t sequence, const VerifyResponse& response) {
+    conn.ready.emplace(sequence, response);
+    while (!conn.ready.empty() && conn.ready.begin()->first == conn.nextToSend) {
+        const VerifyResponse& next = conn.ready.begin()->second;
+        std::uint8_t encoded[VerifyProtocol::RESPONSE_BYTES];
+        encoded[0] = static_cast<std::uint8_t>(next.status);
+        putU32(encoded + 1, static_cast<std::uint32_t>(next.score));
+        putU32(encoded + 5, static_cast<std::uint32_t>(next.levelsCompleted));
+        conn.output.insert(conn.output.end(), encoded, encoded + sizeof(encoded));
+        conn.ready.erase(conn.ready.begin());
+        ++conn.nextToSend;
+    }
+}
+
+bool VerifyServer::flushOutput(Connection& conn) {
+    std::size_t sent = 0;
+    while (sent < conn.output.size()) {
+        ssize_t wrote = ::send(conn.fd, conn.output.data() + sent, conn.output.size() - sent, MSG_NOSIGNAL);
+        if (wrote > 0) {
+            sent += static_cast<std::size_t>(wrote);
+        } else if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else if (wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    conn.output.erase(conn.output.begin(), conn.output.begin() + sent);
+    return true;
+}
+
+bool VerifyServer::wantsRead(const Connection& conn) const {
+    return !readingPaused && !conn.peerClosed && !conn.closing && conn.output.size() < options.maxOutputBytes;
+}
+
+void VerifyServer::updateInterest(std::uint64_t id, Connection& conn) {
+    std::uint32_t events = (wantsRead(conn) ? READ_EVENTS : 0) | (conn.output.empty() ? 0 : WRITE_EVENTS);
+    if (events == conn.events) {
+        return;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = id;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+    conn.events = events;
+}
+
+void VerifyServer::closeIfDone(std::uint64_t id) {
+    auto found = connections.find(id);
+    if (found == connections.end()) {
+        return;
+    }
+    const Connection& conn = found->second;
+    if ((conn.peerClosed || conn.closing) && conn.nextToSend == conn.nextSequence && conn.output.empty()) {
+        closeConnection(id);
+    }
+}
+
+void VerifyServer::closeConnection(std::uint64_t id) {
+    auto found = connections.find(id);
+    if (found == connections.end()) {
+        return;
+    }
+    ::close(found->second.fd); // Also drops it from the epoll set
+    connections.erase(found);
+}
+
+void VerifyServer::setReadingPaused(bool paused) {
+    if (!paused) {
+        // Requests that were already buffered go first
+        for (auto& entry : connections) {
+            parseRequests(entry.first, entry.second);
+        }
+        paused = inFlight >= options.maxInFlight;
+    }
+    if (paused && !readingPaused) {
+        ++stats.pauses;
+    }
+    readingPaused = paused;
+    for (auto& entry : connections) {
+        updateInterest(entry.first, entry.second);
+    }
+}
+
+void VerifyServer::shutdownSockets() {
+    for (auto& entry : connections) {
+        ::close(entry.second.fd);
+    }
+    connections.clear();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(options.socketPath.c_str());
+        listenFd = -1;
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+}
+
+// VerifyClient class implementation
+VerifyClient::VerifyClient(const std::string& socketPath) : fd(-1), inboxStart(0) {
+    sockaddr_un address = socketAddress(socketPath);
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw systemError("socket");
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        GameException error = systemError("Cannot connect to " + socketPath);
+        ::close(fd);
+        throw error;
+    }
+}
+
+VerifyClient::~VerifyClient() {
+    ::close(fd);
+}
+
+void VerifyClient::send(const std::vector<std::uint8_t>& request) {
+    frame.resize(VerifyProtocol::HEADER_BYTES + request.size());
+    putU32(frame.data(), static_cast<std::uint32_t>(request.size()));
+    std::copy(request.begin(), request.end(), frame.begin() + VerifyProtocol::HEADER_BYTES);
+
+    std::size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t wrote = ::send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("Sending to the verification server");
+        }
+        sent += static_cast<std::size_t>(wrote);
+    }
+}
+
+VerifyResponse VerifyClient::receive() {
+    while (inbox.size() - inboxStart < VerifyProtocol::RESPONSE_BYTES) {
+        if (inboxStart > 0) {
+            inbox.erase(inbox.begin(), inbox.begin() + inboxStart);
+            inboxStart = 0;
+        }
+        std::size_t have = inbox.size();
+        inbox.resize(have + 4096);
+        ssize_t got = ::read(fd, inbox.data() + have, 4096);
+        inbox.resize(have + static_cast<std::size_t>(std::max<ssize_t>(got, 0)));
+        if (got == 0) {
+            throw GameException("Verification server closed the connection");
+        }
+        if (got < 0 && errno != EINTR) {
+            throw systemError("Reading from the verification server");
+        }
+    }
+
+    const std::uint8_t* at = inbox.data() + inboxStart;
+    inboxStart += VerifyProtocol::RESPONSE_BYTES;
+    VerifyResponse response;
+    response.status = static_cast<VerifyStatus>(at[0]);
+    response.score = static_cast<int>(getU32(at + 1));
+    response.levelsCompleted = static_cast<int>(getU32(at + 5));
+    return response;
+}
+
+VerifyResponse VerifyClient::submit(const Replay& replay) {
+    send(replay.serialize());
+    return receive();
+}
+
+} // namespace MulaWee
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "replay.hpp"
+#include "run_log.hpp"
+#include "work_stealing_pool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MulaWee {
+
+// Score submission protocol over a Unix stream socket
+//
+//   request:  4-byte little-endian length, then a serialized Replay (.mwr bytes)
+//   response: status byte, then the verified score and the number of completed levels
+//             as 4-byte little-endian integers
+//
+// Requests may be pipelined; each connection gets its responses in request order.
+// A request over the size limit is answered TOO_LARGE and the connection is closed.
+namespace VerifyProtocol {
+
+constexpr std::size_t HEADER_BYTES = 4;
+constexpr std::size_t RESPONSE_BYTES = 9;
+constexpr std::uint32_t MAX_REQUEST_BYTES = 1u << 20;
+constexpr const char* DEFAULT_SOCKET = "/tmp/mulavee-verify.sock";
+
+} // namespace VerifyProtocol
+
+enum class VerifyStatus : std::uint8_t {
+    ACCEPTED,  // Replayed cleanly and the claimed score is the recomputed one
+    REJECTED,  // Replayed cleanly but the claimed score is wrong
+    INVALID,   // Unreadable, not the game's levels, or moves that cannot have been played
+    TOO_LARGE, // Over the request size limit
+    NOT_RECORDED // Would be ACCEPTED, but the run log write failed; submit it again later
+};
+
+const char* verifyStatusName(VerifyStatus status);
+
+struct VerifyResponse {
+    VerifyStatus status = VerifyStatus::INVALID;
+    int score = 0;           // Recomputed score (0 unless the run replayed cleanly)
+    int levelsCompleted = 0;
+};
+
+// Replays a submission and recomputes its score level by level with
+// ScoreManager::calculateLevelScore. Level N of the run must be level N of the game,
+// so an easy level cannot be replayed in place of a harder one. Safe to share
+// between threads.
+class ScoreVerifier {
+private:
+    std::vector<std::shared_ptr<const Level>> levels; // Game order
+    Replayer replayer;
+    ScoreManager scorer;
+
+public:
+    explicit ScoreVerifier(const std::vector<std::shared_ptr<const Level>>& gameLevels);
+
+    // `run`, if given, is filled in for an accepted submission
+    VerifyResponse verify(const Replay& replay, RunRecord* run = nullptr) const;
+};
+
+struct VerifyServerOptions {
+    std::string socketPath = VerifyProtocol::DEFAULT_SOCKET;
+    unsigned threads = 0;                     // Replay workers (0 = every hardware thread)
+    std::size_t maxInFlight = 4096;           // Submissions being replayed or awaiting send
+    std::size_t maxConnections = 128;
+    std::size_t maxOutputBytes = 64 * 1024;   // Unsent responses before a client is paused
+    std::uint32_t maxRequestBytes = VerifyProtocol::MAX_REQUEST_BYTES;
+    std::string runLogFile;                   // Accepted runs are appended here if set
+};
+
+struct VerifyServerStats {
+    std::size_t accepted = 0;
+    std::size_t rejected = 0;
+    std::size_t invalid = 0;
+    std::size_t tooLarge = 0;
+    std::size_t notRecorded = 0;  // Accepted runs the run log failed to store
+    std::size_t connections = 0;  // Accepted over the server's lifetime
+    std::size_t refused = 0;      // Closed at once because maxConnections were open
+    std::size_t peakInFlight = 0;
+    std::size_t pauses = 0;       // Times reading stopped because maxInFlight was reached
+};
+
+// Verification daemon. One thread owns the socket and every connection through
+// epoll; complete requests are replayed on a WorkStealingPool and the results come
+// back through an eventfd. Backpressure: when maxInFlight submissions are
+// outstanding, or a client has maxOutputBytes of responses it is not reading, the
+// server stops reading from the socket and the kernel buffers fill up until the
+// client blocks in send(). Memory therefore stays below about
+// maxConnections * (maxRequestBytes + READ_CHUNK) plus maxInFlight submissions.
+class VerifyServer {
+private:
+    struct Connection {
+        int fd = -1;
+        std::uint32_t events = 0;           // Current epoll interest
+        std::vector<std::uint8_t> input;    // Bytes of incomplete requests
+        std::vector<std::uint8_t> output;   // Encoded responses not yet sent
+        std::uint64_t nextSequence = 0;     // Assigned to the next request
+        std::uint64_t nextToSend = 0;
+        std::map<std::uint64_t, VerifyResponse> ready; // Finished out of order
+        bool peerClosed = false;
+        bool closing = false;               // Protocol error: finish sending, then close
+    };
+
+    struct Completion {
+        std::uint64_t connection;
+        std::uint64_t sequence;
+        VerifyResponse response;
+        RunRecord run;                      // Set for accepted runs
+    };
+
+    VerifyServerOptions options;
+    ScoreVerifier verifier;
+    std::unique_ptr<RunLog> runLog;         // Null without runLogFile
+
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    std::atomic<bool> stopping;
+
+    std::unordered_map<std::uint64_t, Connection> connections;
+    std::uint64_t nextConnectionId;
+    std::size_t inFlight;
+    bool readingPaused;
+    bool runLogFailing;                     // The last append failed
+    VerifyServerStats stats;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;    // Filled by workers
+    std::vector<Completion> draining;       // Swapped out by the socket thread
+    std::vector<RunRecord> acceptedRuns;    // Appended to the log once per drain
+
+    std::unique_ptr<WorkStealingPool> pool; // Last, so workers stop before the rest goes
+
+public:
+    static constexpr std::size_t READ_CHUNK = 64 * 1024;
+
+    VerifyServer(const std::vector<std::shared_ptr<const Level>>& gameLevels,
+                 const VerifyServerOptions& serverOptions);
+    ~VerifyServer();
+
+    VerifyServer(const VerifyServer&) = delete;
+    VerifyServer& operator=(const VerifyServer&) = delete;
+
+    // Bind the socket (replacing a stale one) and serve until stop()
+    void run();
+
+    // Async-signal-safe
+    void stop();
+
+    const VerifyServerStats& getStats() const { return stats; }
+
+private:
+    void acceptConnections();
+    void handleEvents(std::uint64_t id, std::uint32_t events);
+    void readInput(std::uint64_t id, Connection& conn);
+    void parseRequests(std::uint64_t id, Connection& conn);
+    void submit(std::uint64_t id, Connection& conn, std::vector<std::uint8_t> request);
+    void drainCompletions();
+    void deliver(Connection& conn, std::uint64_t sequence, const VerifyResponse& response);
+    bool flushOutput(Connection& conn);
+    bool wantsRead(const Connection& conn) const;
+    void updateInterest(std::uint64_t id, Connection& conn);
+    void closeIfDone(std::uint64_t id);
+    void closeConnection(std::uint64_t id);
+    void setReadingPaused(bool paused);
+    void shutdownSockets();
+};
+
+// Blocking client for the submission protocol
+class VerifyClient {
+private:
+    int fd;
+    std::vector<std::uint8_t> frame;  // Outgoing request with its header
+    std::vector<std::uint8_t> inbox;  // Responses read but not yet returned
+    std::size_t inboxStart;
+
+public:
+    explicit VerifyClient(const std::string& socketPath = VerifyProtocol::DEFAULT_SOCKET);
+    ~VerifyClient();
+
+    VerifyClient(const VerifyClient&) = delete;
+    VerifyClient& operator=(const VerifyClient&) = delete;
+
+    // Pipelining: send() any number of requests, then receive() as many responses;
+    // one thread may send while another receives. send() blocks while the server is
+    // applying backpressure.
+    void send(const std::vector<std::uint8_t>& request);
+    VerifyResponse receive();
+
+    VerifyResponse submit(const Replay& replay);
+};
+
+} // namespace MulaWee
@@ -0,0 +1,93 @@
+#include "verify_server.hpp"
+#include "level_format.hpp"
+#include "level_validator.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Score verification daemon - replays submitted runs and only trusts scores it recomputes
+//
+//   mulavee_verifyd [--socket PATH] [--data DIR] [--threads N] [--max-in-flight N]
+//                   [--max-connections N] [--runs FILE]
+//
+// Levels are DIR/level1..3 in game order. With --runs, every accepted run is appended
+// to that run log. SIGINT or SIGTERM stops the daemon and prints its counters.
+
+namespace {
+
+using namespace MulaWee;
+
+VerifyServer* activeServer = nullptr;
+
+void handleStopSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--socket PATH] [--data DIR] [--threads N] [--max-in-flight N]"
+              << " [--max-connections N] [--runs FILE]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dataDir = "../data";
+    VerifyServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--socket") == 0 && hasValue) {
+            options.socketPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--data") == 0 && hasValue) {
+            dataDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--max-in-flight") == 0 && hasValue) {
+            options.maxInFlight = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--max-connections") == 0 && hasValue) {
+            options.maxConnections = static_cast<std::size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--runs") == 0 && hasValue) {
+            options.runLogFile = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        std::vector<std::shared_ptr<const Level>> levels;
+        for (int i = 1; i <= 3; ++i) {
+            std::string path = dataDir + "/level" + std::to_string(i) + ".dat";
+            std::string compiled = LevelFormat::compiledPathFor(path);
+            levels.push_back(std::make_shared<const Level>(LevelFormat::isCompiled(compiled) ? compiled : path));
+            LevelValidator().check(*levels.back()); // Runs on an unplayable level are never accepted
+        }
+
+        VerifyServer server(levels, options);
+        activeServer = &server;
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = handleStopSignal;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        std::cerr << "Verifying submissions on " << options.socketPath << std::endl;
+        server.run();
+        activeServer = nullptr;
+
+        const VerifyServerStats& stats = server.getStats();
+        std::cerr << "accepted " << stats.accepted << ", rejected " << stats.rejected << ", invalid "
+                  << stats.invalid << ", too large " << stats.tooLarge << ", not recorded " << stats.notRecorded
+                  << "; " << stats.connections
+                  << " connections (" << stats.refused << " refused), peak in flight " << stats.peakInFlight
+                  << ", " << stats.pauses << " pauses" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MulaWee {
+
+// Fixed-size thread pool with one task deque per worker. A worker takes its own
+// newest task first and, when empty, steals the oldest task from another worker,
+// so uneven task costs (a tiny level next to a huge one) still balance out.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<std::size_t> queued;   // Tasks sitting in a deque
+    std::atomic<std::size_t> pending;  // Queued plus running
+    std::atomic<std::size_t> nextQueue;
+    std::atomic<std::size_t> steals;
+    std::exception_ptr firstError;
+    bool stopping;
+
+public:
+    // threads == 0 uses every hardware thread
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Tasks submitted from a worker go to that worker's own deque
+    void submit(Task task);
+
+    // Block until every submitted task has finished; rethrows the first task exception
+    void wait();
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()); }
+    std::size_t getStealCount() const { return steals.load(); }
+
+private:
+    bool tryPop(std::size_t self, Task& task);
+    void workerLoop(std::size_t self);
+    void finishTask();
+};
+
+} // namespace MulaWee